@@ -74,6 +74,18 @@ backtrace_free (struct backtrace_state *state ATTRIBUTE_UNUSED,
   free (p);
 }
 
+/* Prepare for backtrace_state_freeze.  We don't keep a free list of
+   our own when using malloc, so there is nothing to do.  */
+
+int
+backtrace_alloc_freeze (struct backtrace_state *state ATTRIBUTE_UNUSED,
+			backtrace_error_callback error_callback
+			  ATTRIBUTE_UNUSED,
+			void *data ATTRIBUTE_UNUSED)
+{
+  return 1;
+}
+
 /* Grow VEC by SIZE bytes.  */
 
 void *
@@ -115,6 +127,31 @@ backtrace_vector_grow (struct backtrace_state *state ATTRIBUTE_UNUSED,
   return ret;
 }
 
+/* Reserve SIZE bytes in VEC.  */
+
+int
+backtrace_vector_reserve (struct backtrace_state *state ATTRIBUTE_UNUSED,
+			  size_t size,
+			  backtrace_error_callback error_callback,
+			  void *data, struct backtrace_vector *vec)
+{
+  void *base;
+
+  if (size <= vec->alc)
+    return 1;
+
+  base = realloc (vec->base, vec->size + size);
+  if (base == NULL)
+    {
+      error_callback (data, "realloc", errno);
+      return 0;
+    }
+
+  vec->base = base;
+  vec->alc = size;
+  return 1;
+}
+
 /* Finish the current allocation on VEC.  */
 
 void *
@@ -0,0 +1,229 @@
+/* altlinktest.c -- Test sharing .gnu_debugaltlink data between modules.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    (1) Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    (2) Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in
+    the documentation and/or other materials provided with the
+    distribution.
+
+    (3) The name of the author may not be used to
+    endorse or promote products derived from this software without
+    specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.  */
+
+/* The Makefile copies this program twice and runs dwz -m over the
+   copies, so that both refer to one common file with
+   .gnu_debugaltlink.  This reads the two copies as two modules of one
+   state, and checks that the second module reuses the DWARF data
+   that the first one read from the common file.  */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#ifdef HAVE_LINK_H
+#include <link.h>
+#endif
+
+#include "backtrace.h"
+#include "backtrace-supported.h"
+
+#include "internal.h"
+#include "testlib.h"
+
+#if defined (HAVE_DL_ITERATE_PHDR) && defined (HAVE_LINK_H)
+
+/* Return the address that the caller returns to.  */
+
+static uintptr_t get_pc (void) __attribute__ ((noinline, noclone));
+
+static uintptr_t
+get_pc (void)
+{
+  return (uintptr_t) __builtin_return_address (0);
+}
+
+/* An inlined function, whose abstract instance is the same in both
+   copies, so that dwz moves it to the common file.  */
+
+static inline uintptr_t inline_pc (void) __attribute__ ((always_inline));
+
+static inline uintptr_t
+inline_pc (void)
+{
+  return get_pc ();
+}
+
+/* Return a PC in the inlined call of inline_pc.  */
+
+static uintptr_t outer (void) __attribute__ ((noinline, noclone));
+
+static uintptr_t
+outer (void)
+{
+  return inline_pc () - 1;
+}
+
+/* A dl_iterate_phdr callback that records the load bias of the
+   executable, which is the first module.  */
+
+static int
+bias_callback (struct dl_phdr_info *info, size_t size ATTRIBUTE_UNUSED,
+	       void *data)
+{
+  *(uintptr_t *) data = info->dlpi_addr;
+  return 1;
+}
+
+/* A backtrace_pcinfo callback that records the innermost function
+   name.  */
+
+static int
+function_callback (void *data, uintptr_t pc ATTRIBUTE_UNUSED,
+		   const char *filename ATTRIBUTE_UNUSED,
+		   int lineno ATTRIBUTE_UNUSED, const char *function)
+{
+  const char **pfunction = (const char **) data;
+
+  if (*pfunction == NULL)
+    *pfunction = function;
+  return 0;
+}
+
+/* The offset between the two modules.  */
+
+#define MODULE_OFFSET ((uintptr_t) 0x10000000)
+
+/* Return the number of .gnu_debugaltlink files that STATE has read.
+   Each entry on the list starts with a pointer to the next one; see
+   struct elf_altlink in elf.c.  */
+
+static int
+count_altlinks (struct backtrace_state *mstate)
+{
+  void *p;
+  int c;
+
+  c = 0;
+  for (p = mstate->altlink_data; p != NULL; p = *(void **) p)
+    ++c;
+  return c;
+}
+
+/* Look up a PC in each copy of the program.  */
+
+static void
+test1 (const char *filename)
+{
+  char *filename2;
+  size_t len;
+  uintptr_t bias;
+  struct backtrace_module modules[2];
+  struct backtrace_state *mstate;
+  uintptr_t pc;
+  const char *function1;
+  const char *function2;
+  int altlinks;
+  int this_fail;
+
+  len = strlen (filename);
+  filename2 = malloc (len + 3);
+  if (filename2 == NULL)
+    {
+      perror ("malloc");
+      exit (EXIT_FAILURE);
+    }
+  memcpy (filename2, filename, len);
+  memcpy (filename2 + len, "_2", 3);
+
+  /* If dwz failed, the Makefile only provides one copy.  */
+  if (access (filename2, R_OK) != 0)
+    {
+      printf ("UNSUPPORTED: shared altlink\n");
+      free (filename2);
+      return;
+    }
+
+  bias = 0;
+  dl_iterate_phdr (bias_callback, &bias);
+
+  memset (modules, 0, sizeof modules);
+  modules[0].filename = filename;
+  modules[0].base_address = bias;
+  modules[1].filename = filename2;
+  modules[1].base_address = bias + MODULE_OFFSET;
+  mstate = backtrace_create_state_from_modules (modules, 2, 0,
+						error_callback_create, NULL);
+
+  pc = outer ();
+  function1 = NULL;
+  backtrace_pcinfo (mstate, pc, function_callback, error_callback_create,
+		    &function1);
+  function2 = NULL;
+  backtrace_pcinfo (mstate, pc + MODULE_OFFSET, function_callback,
+		    error_callback_create, &function2);
+
+  this_fail = 0;
+  if (function1 == NULL || strcmp (function1, "inline_pc") != 0)
+    {
+      fprintf (stderr, "test1: first module: got %s, want inline_pc\n",
+	       function1 == NULL ? "NULL" : function1);
+      this_fail = 1;
+    }
+  if (function2 == NULL || strcmp (function2, "inline_pc") != 0)
+    {
+      fprintf (stderr, "test1: second module: got %s, want inline_pc\n",
+	       function2 == NULL ? "NULL" : function2);
+      this_fail = 1;
+    }
+
+  /* If the second module found the DWARF data of the common file
+     that the first module read, the file was read only once.  */
+  altlinks = count_altlinks (mstate);
+  if (altlinks != 1)
+    {
+      fprintf (stderr, "test1: read %d altlink files, want 1\n", altlinks);
+      this_fail = 1;
+    }
+
+  printf ("%s: shared altlink\n", this_fail ? "FAIL" : "PASS");
+  failures += this_fail;
+
+  free (filename2);
+}
+
+#endif /* defined (HAVE_DL_ITERATE_PHDR) && defined (HAVE_LINK_H) */
+
+int
+main (int argc ATTRIBUTE_UNUSED, char **argv)
+{
+#if defined (HAVE_DL_ITERATE_PHDR) && defined (HAVE_LINK_H)
+  test1 (argv[0]);
+#else
+  printf ("UNSUPPORTED: shared altlink\n");
+#endif
+
+  exit (failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
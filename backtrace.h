@@ -88,6 +88,59 @@ extern struct backtrace_state *backtrace_create_state (
     const char *filename, int threaded,
     backtrace_error_callback error_callback, void *data);
 
+/* An object file to read with backtrace_create_state_from_modules.  */
+
+struct backtrace_module
+{
+  /* The path name of the file.  */
+  const char *filename;
+  /* The load bias: the difference between the addresses at which the
+     file was loaded and the addresses recorded in the file.  This is
+     0 for a non-PIE executable.  */
+  uintptr_t base_address;
+  /* If BUILD_ID_SIZE is not zero, the build ID that the file must
+     have, as raw bytes rather than hex.  */
+  const char *build_id;
+  size_t build_id_size;
+};
+
+/* Create state information for symbolizing PCs in a process other
+   than this one, such as one that ran on another machine, given the
+   COUNT object files in MODULES.  All the files are read here, and
+   the state does not look at the executable or at the modules loaded
+   in this process.  Separate debug info files are found as usual.
+   THREADED is as for backtrace_create_state.
+
+   The returned state may be used with backtrace_pcinfo,
+   backtrace_pcinfo_array, and backtrace_syminfo, with PCs in the
+   address space of the other process.  It should not be used to
+   capture backtraces.  A file that can't be read, or that doesn't
+   have the requested build ID, is reported through ERROR_CALLBACK and
+   skipped.  This returns NULL if no file could be read.  This is only
+   supported for ELF.  */
+
+extern struct backtrace_state *backtrace_create_state_from_modules (
+    const struct backtrace_module *modules, int count, int threaded,
+    backtrace_error_callback error_callback, void *data);
+
+/* Prepare STATE to be shared with child processes created by fork.
+   This reads all the debug info that lookups would otherwise read the
+   first time they need it, and then puts STATE into a mode in which
+   lookups never write to memory that was allocated before this call.
+   A parent that calls this before forking its workers therefore
+   shares all the symbolization data with them copy-on-write, and no
+   child gets private copies of the line tables.
+
+   After this call STATE may be used as usual.  Memory allocated by
+   lookups is taken from new pages, and is reused once it is freed.
+   Memory that was already free when this was called is not reused.
+   This must not be called while another thread is using
+   STATE.  Returns 1 on success, 0 on error.  */
+
+extern int backtrace_state_freeze (struct backtrace_state *state,
+				   backtrace_error_callback error_callback,
+				   void *data);
+
 /* The type of the callback argument to the backtrace_full function.
    DATA is the argument passed to backtrace_full.  PC is the program
    counter.  FILENAME is the name of the file containing PC, or NULL
@@ -135,6 +188,78 @@ extern int backtrace_simple (struct backtrace_state *state, int skip,
 			     backtrace_error_callback error_callback,
 			     void *data);
 
+/* Store a simple backtrace in PCS, an array of MAX elements.  SKIP
+   is the number of frames to skip, as in backtrace.  Returns the
+   number of PCs stored, which is 0 if no backtrace could be
+   obtained.  The PCs are adjusted in the same way as those passed to
+   a backtrace_simple_callback, so they may be passed directly to
+   backtrace_pcinfo or backtrace_pcinfo_array, perhaps much later.
+   This function does not allocate memory and does not require any
+   debug info for the executable.  */
+
+extern int backtrace_capture (struct backtrace_state *state, int skip,
+			      uintptr_t *pcs, int max);
+
+/* Values for the MODE argument of backtrace_set_unwind_mode.  */
+
+/* Unwind using the unwind library, _Unwind_Backtrace.  This is the
+   default, and works for any code that has unwind information.  */
+#define BACKTRACE_UNWIND_DEFAULT 0
+
+/* Unwind by following the chain of saved frame pointers.  This is
+   much faster than the unwind library, and takes no locks, but it is
+   only accurate if all the code on the stack was compiled with
+   -fno-omit-frame-pointer; functions without a frame pointer are
+   silently omitted from the backtrace.  Each frame pointer is checked
+   against the bounds of the current thread's stack before it is
+   dereferenced, and if the chain does not look valid the unwind
+   library is used instead.  */
+#define BACKTRACE_UNWIND_FRAME_POINTER 1
+
+/* Unwind using the .eh_frame_hdr and .eh_frame sections of the
+   loaded modules, read directly from memory.  This works for code
+   without frame pointers, and is faster than the unwind library
+   because it caches the decoded unwind rule for each PC.  The list
+   of loaded modules is read when this mode is selected, and after
+   that only by backtrace_update_modules, so that walking the stack
+   takes no locks.  Frames with unwind information too complex for
+   the built-in unwinder, or in modules loaded since the list was
+   read, cause the unwind library to be used instead.  */
+#define BACKTRACE_UNWIND_EH_FRAME 2
+
+/* Select how backtrace_simple and backtrace_capture walk the stack.
+   MODE is one of the BACKTRACE_UNWIND_ values above.  This should be
+   called before the state is used by other threads.  If MODE is not
+   supported on this system, this calls ERROR_CALLBACK and returns 0,
+   leaving the mode unchanged.  Otherwise it returns 1.
+
+   When using BACKTRACE_UNWIND_FRAME_POINTER or
+   BACKTRACE_UNWIND_EH_FRAME the bounds of the stack of each thread
+   are looked up on the first call to backtrace_simple or
+   backtrace_capture on that thread, which is not async-signal-safe.
+   Programs that call these functions from a signal handler should
+   ensure that each thread makes an initial call outside of a signal
+   handler.  */
+
+extern int backtrace_set_unwind_mode (struct backtrace_state *state,
+				      int mode,
+				      backtrace_error_callback error_callback,
+				      void *data);
+
+/* Read the list of loaded modules used by BACKTRACE_UNWIND_EH_FRAME
+   again, if any modules have been loaded or unloaded since it was
+   last read.  backtrace_simple and backtrace_capture never do this
+   themselves, so a program that uses that mode and calls dlclose must
+   call this function before walking a stack that may be in a module
+   loaded at the same address; a program that calls dlopen should call
+   it to avoid falling back to the unwind library for frames in the
+   new module.  The sampler and backtrace_dump_threads call this
+   before they send any signals.  This calls dl_iterate_phdr, which
+   takes a lock, so it must not be called from a signal handler.  It
+   does nothing in other modes.  */
+
+extern void backtrace_update_modules (struct backtrace_state *state);
+
 /* Print the current backtrace in a user readable format to a FILE.
    SKIP is the number of frames to skip, as in backtrace_full.  Any
    error messages are printed to stderr.  This function requires debug
@@ -142,6 +267,23 @@ extern int backtrace_simple (struct backtrace_state *state, int skip,
 
 extern void backtrace_print (struct backtrace_state *state, int skip, FILE *);
 
+/* Print the current backtrace in the same format as backtrace_print,
+   but to the file descriptor FD.  The output is formatted into BUF,
+   of SIZE bytes, and written with write whenever BUF fills up; if BUF
+   is NULL a small buffer on the stack is used.  Errors are written to
+   file descriptor 2.  This does not use stdio or malloc, so it may
+   be called from a signal handler, even when another thread holds a
+   stdio lock.  The stack is walked with backtrace_capture, so see
+   the notes on async-signal-safety at backtrace_set_unwind_mode.
+   The debug info should be read first, for example by calling this
+   function or backtrace_pcinfo before any signal handler runs, and
+   the library should use the mmap allocator; otherwise reading it
+   may call malloc.  At most BACKTRACE_STACK_MAX_DEPTH frames are
+   printed.  */
+
+extern void backtrace_print_fd (struct backtrace_state *state, int skip,
+				int fd, char *buf, size_t size);
+
 /* Given PC, a program counter in the current program, call the
    callback function with filename, line number, and function name
    information.  This will normally call the callback function exactly
@@ -156,6 +298,16 @@ extern int backtrace_pcinfo (struct backtrace_state *state, uintptr_t pc,
 			     backtrace_error_callback error_callback,
 			     void *data);
 
+/* Call backtrace_pcinfo for each of the COUNT PCs in PCS, as stored
+   by backtrace_capture, stopping at the first non-zero value returned
+   by CALLBACK.  This returns that value, or 0.  */
+
+extern int backtrace_pcinfo_array (struct backtrace_state *state,
+				   const uintptr_t *pcs, int count,
+				   backtrace_full_callback callback,
+				   backtrace_error_callback error_callback,
+				   void *data);
+
 /* The type of the callback argument to backtrace_syminfo.  DATA and
    PC are the arguments passed to backtrace_syminfo.  SYMNAME is the
    name of the symbol for the corresponding code.  SYMVAL is the
@@ -182,6 +334,211 @@ extern int backtrace_syminfo (struct backtrace_state *state, uintptr_t addr,
 			      backtrace_error_callback error_callback,
 			      void *data);
 
+/* The type of the callback argument to backtrace_resolve.  FILENAME,
+   LINENO and FUNCTION are as for backtrace_full_callback, and
+   SYMNAME, SYMVAL and SYMSIZE are as for backtrace_syminfo_callback.
+   The callback is called once for each inlined frame at PC, each time
+   with the same symbol information; FUNCTION and SYMNAME may differ
+   when PC is in an inlined function.  Any of FILENAME, FUNCTION and
+   SYMNAME may be NULL if the information is not available.  Return
+   zero to continue, or non-zero to stop.  */
+
+typedef int (*backtrace_resolve_callback) (void *data, uintptr_t pc,
+					   const char *filename, int lineno,
+					   const char *function,
+					   const char *symname,
+					   uintptr_t symval,
+					   uintptr_t symsize);
+
+/* Given PC, a program counter in the current program, find both the
+   file/line information that backtrace_pcinfo would report and the
+   symbol that backtrace_syminfo would report, and pass them to
+   CALLBACK together.  This finds the module containing PC once rather
+   than once for each kind of information, so it is cheaper than
+   calling backtrace_pcinfo and then backtrace_syminfo.  The return
+   value is as for backtrace_pcinfo.  */
+
+extern int backtrace_resolve (struct backtrace_state *state, uintptr_t pc,
+			      backtrace_resolve_callback callback,
+			      backtrace_error_callback error_callback,
+			      void *data);
+
+/* A table of interned stacks, used by profilers that record the same
+   stacks many times.  Each distinct stack is stored once and is
+   identified by a small non-zero integer.  */
+
+struct backtrace_stack_table;
+
+/* Create a stack table that can hold up to MAX_STACKS distinct stacks
+   with a total of up to MAX_PCS PCs.  All the memory is allocated
+   here, using the same allocator as STATE, so that the other
+   functions on the table never allocate.  STATE is used by
+   backtrace_stack_capture.  On error this calls ERROR_CALLBACK and
+   returns NULL.  */
+
+extern struct backtrace_stack_table *backtrace_stack_table_create (
+    struct backtrace_state *state, int max_stacks, int max_pcs,
+    backtrace_error_callback error_callback, void *data);
+
+/* Intern the stack of COUNT PCs at PCS, as stored by
+   backtrace_capture, in TABLE.  Returns the ID of the stack, which is
+   the same for every call with the same PCs.  Returns 0 if COUNT is
+   not positive or the table is full.  This may be called by multiple
+   threads at once, and from a signal handler, as it takes no locks
+   and does not allocate.  */
+
+extern uint32_t backtrace_stack_intern (struct backtrace_stack_table *table,
+					const uintptr_t *pcs, int count);
+
+/* The maximum number of frames recorded by backtrace_stack_capture.  */
+
+#define BACKTRACE_STACK_MAX_DEPTH 128
+
+/* Capture the current stack with backtrace_capture and intern it in
+   TABLE.  SKIP is the number of frames to skip, as in backtrace.
+   Returns the ID of the stack, or 0 on failure.  This is as safe as
+   backtrace_capture and backtrace_stack_intern.  */
+
+extern uint32_t backtrace_stack_capture (struct backtrace_stack_table *table,
+					 int skip);
+
+/* Set *PCS to the PCs of the stack ID in TABLE, and return the number
+   of PCs.  Returns 0 if there is no such stack.  */
+
+extern int backtrace_stack_get (struct backtrace_stack_table *table,
+				uint32_t id, const uintptr_t **pcs);
+
+/* The type of the callback argument to backtrace_stack_iterate.  ID is
+   the stack ID, and PCS and COUNT are the PCs of the stack.  This
+   should return 0 to continue.  */
+
+typedef int (*backtrace_stack_callback) (void *data, uint32_t id,
+					 const uintptr_t *pcs, int count);
+
+/* Call CALLBACK for each stack in TABLE in order of ID, for example to
+   symbolize them with backtrace_pcinfo_array.  Stacks that are
+   interned while this is running may or may not be seen.  If CALLBACK
+   returns a non-zero value, this stops and returns that value.
+   Otherwise it returns 0.  */
+
+extern int backtrace_stack_iterate (struct backtrace_stack_table *table,
+				    backtrace_stack_callback callback,
+				    void *data);
+
+/* A sampling profiler.  Threads that are being sampled receive
+   SIGPROF at regular intervals of their CPU time, and the signal
+   handler records the stack in a per-thread ring buffer.  The
+   samples are retrieved later, outside of the signal handler, with
+   backtrace_sampler_drain.  Each stack starts at the PC where the
+   signal arrived and is walked from the registers of the interrupted
+   code, as set by backtrace_set_unwind_mode, but the unwind library
+   is never used, as it is not async-signal-safe: in
+   BACKTRACE_UNWIND_DEFAULT mode the frame pointers are followed.
+   This is only supported on GNU/Linux.  */
+
+struct backtrace_sampler;
+
+/* Create a sampler, and install a SIGPROF handler.  Only one sampler
+   may be created.  MAX_THREADS is the maximum number of threads that
+   may be sampled at once.  BUFFER_SIZE is the size of the ring buffer
+   of each thread, in words; each sample takes one word more than its
+   number of PCs.  MAX_DEPTH is the maximum number of PCs in a sample,
+   at most BACKTRACE_STACK_MAX_DEPTH.  All memory is allocated here.
+   On error this calls ERROR_CALLBACK and returns NULL.  */
+
+extern struct backtrace_sampler *backtrace_sampler_create (
+    struct backtrace_state *state, int max_threads, int buffer_size,
+    int max_depth, backtrace_error_callback error_callback, void *data);
+
+/* Start sampling the calling thread every INTERVAL_USEC microseconds
+   of its CPU time.  Returns 1 on success.  On error this calls
+   ERROR_CALLBACK and returns 0.  */
+
+extern int backtrace_sampler_start_thread (struct backtrace_sampler *sampler,
+					   long interval_usec,
+					   backtrace_error_callback
+					     error_callback,
+					   void *data);
+
+/* Stop sampling the calling thread.  This must be called before a
+   sampled thread exits.  Samples already recorded are still returned
+   by backtrace_sampler_drain.  Returns 1 on success.  On error this
+   calls ERROR_CALLBACK and returns 0.  */
+
+extern int backtrace_sampler_stop_thread (struct backtrace_sampler *sampler,
+					  backtrace_error_callback
+					    error_callback,
+					  void *data);
+
+/* The type of the callback argument to backtrace_sampler_drain.  SLOT
+   is the index of the ring buffer that held the sample; samples from
+   the same thread have the same SLOT, but a SLOT may be reused after
+   a thread stops being sampled.  PCS and COUNT are the PCs of the
+   sample, which may be passed to backtrace_pcinfo_array or
+   backtrace_stack_intern.  PCS is only valid during the call.  This
+   should return 0 to continue.  */
+
+typedef int (*backtrace_sample_callback) (void *data, int slot,
+					  const uintptr_t *pcs, int count);
+
+/* Call CALLBACK for each sample recorded since the last call.  This
+   may run while threads are being sampled, but it must not be called
+   by more than one thread at a time.  If CALLBACK returns a non-zero
+   value, this stops and returns that value; the remaining samples
+   are returned by the next call.  Otherwise it returns 0.  */
+
+extern int backtrace_sampler_drain (struct backtrace_sampler *sampler,
+				    backtrace_sample_callback callback,
+				    void *data);
+
+/* Return the number of samples that were dropped because a ring
+   buffer was full.  */
+
+extern size_t backtrace_sampler_dropped (struct backtrace_sampler *sampler);
+
+/* The type of the thread_callback argument to backtrace_dump_threads.
+   TID is the thread ID.  COUNT is the number of PCs in the stack of
+   the thread, which are passed to the CALLBACK argument of
+   backtrace_dump_threads next, or -1 if the thread did not answer
+   the signal in time.  This should return 0 to continue.  */
+
+typedef int (*backtrace_thread_callback) (void *data, int tid, int count);
+
+/* Report the stacks of all the threads of the process.  This sends
+   the signal SIGNO, which should not be otherwise used by the
+   program, to every thread, and the signal handler records the stack
+   of the thread, starting where the signal arrived.  The stack of
+   the calling thread starts at the caller of this function.  The
+   stacks are walked as set by backtrace_set_unwind_mode, except that
+   the unwind library, which is not async-signal-safe, is never used:
+   in BACKTRACE_UNWIND_DEFAULT mode the frame pointers are followed.
+   The handler does not allocate memory or take locks, so it is safe
+   even when a thread is interrupted inside malloc.  MAX_THREADS is
+   the maximum number of threads, and MAX_DEPTH, at most
+   BACKTRACE_STACK_MAX_DEPTH, the maximum number of PCs per thread;
+   the memory for them is allocated before any signal is sent.  This
+   waits up to TIMEOUT_MS milliseconds for the threads to answer.
+   If every thread answered, the previous action for SIGNO is
+   restored.  Otherwise the signal may still be pending for some
+   thread, so a handler that ignores it is left installed.
+
+   The distinct PCs of all the stacks are then symbolized once each,
+   using up to NWORKERS threads if STATE was created as threaded.
+   Then, for each thread, this calls THREAD_CALLBACK, followed by
+   CALLBACK for each frame as backtrace_full would.  ERROR_CALLBACK
+   may be called by the worker threads.  This returns the first
+   non-zero value returned by THREAD_CALLBACK or CALLBACK, or 0.  This
+   is only supported on GNU/Linux.  Only one call may run at a
+   time.  */
+
+extern int backtrace_dump_threads (struct backtrace_state *state, int signo,
+				   int max_threads, int max_depth,
+				   int timeout_ms, int nworkers,
+				   backtrace_thread_callback thread_callback,
+				   backtrace_full_callback callback,
+				   backtrace_error_callback error_callback,
+				   void *data);
+
 #ifdef __cplusplus
 } /* End extern "C".  */
 #endif
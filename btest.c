@@ -37,6 +37,7 @@ POSSIBILITY OF SUCH DAMAGE.  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <sys/stat.h>
 
@@ -388,6 +389,368 @@ f33 (int f1line, int f2line)
   return failures;
 }
 
+/* Test the backtrace_capture and backtrace_pcinfo_array functions.  */
+
+static int test6 (void) __attribute__ ((noinline, noclone, optnone, unused));
+static int f42 (int) __attribute__ ((noinline, noclone));
+static int f43 (int, int) __attribute__ ((noinline, noclone));
+
+static int
+test6 (void)
+{
+  return f42 (__LINE__) + 1;
+}
+
+static int
+f42 (int f1line)
+{
+  return f43 (f1line, __LINE__) + 2;
+}
+
+static int
+f43 (int f1line, int f2line)
+{
+  uintptr_t addrs[20];
+  struct info all[20];
+  struct bdata bdata;
+  int f3line;
+  int failed;
+  int n;
+  int i;
+
+  failed = 0;
+
+  f3line = __LINE__ + 1;
+  n = backtrace_capture (state, 0, addrs, 20);
+
+  if (n < 3)
+    {
+      fprintf (stderr, "test6: too few frames: %d\n", n);
+      failed = 1;
+    }
+
+  if (!failed)
+    {
+      bdata.all = &all[0];
+      bdata.index = 0;
+      bdata.max = 20;
+      bdata.failed = 0;
+
+      i = backtrace_pcinfo_array (state, addrs, 3, callback_one,
+				  error_callback_one, &bdata);
+      if (i != 0)
+	{
+	  fprintf (stderr,
+		   ("test6: unexpected return value "
+		    "from backtrace_pcinfo_array %d\n"),
+		   i);
+	  bdata.failed = 1;
+	}
+      if (!bdata.failed && bdata.index != 3)
+	{
+	  fprintf (stderr,
+		   ("wrong number of calls from backtrace_pcinfo_array "
+		    "got %u expected 3\n"),
+		   (unsigned int) bdata.index);
+	  bdata.failed = 1;
+	}
+
+      check ("test6", 0, all, f3line, "f43", "btest.c", &bdata.failed);
+      check ("test6", 1, all, f2line, "f42", "btest.c", &bdata.failed);
+      check ("test6", 2, all, f1line, "test6", "btest.c", &bdata.failed);
+
+      if (bdata.failed)
+	failed = 1;
+    }
+
+  if (!failed)
+    {
+      uintptr_t one;
+
+      /* Skipping this frame and capturing just one should give the
+	 call in f42.  */
+      n = backtrace_capture (state, 1, &one, 1);
+      if (n != 1 || one != addrs[1])
+	{
+	  fprintf (stderr, "test6: skip got %d %#lx expected 1 %#lx\n", n,
+		   (unsigned long) one, (unsigned long) addrs[1]);
+	  failed = 1;
+	}
+    }
+
+  printf ("%s: backtrace_capture\n", failed ? "FAIL" : "PASS");
+
+  if (failed)
+    ++failures;
+
+  return failures;
+}
+
+/* Test that backtrace_print_fd prints the same thing as
+   backtrace_print.  */
+
+static void print_one (int, FILE *) __attribute__ ((noinline, noclone));
+static int test7 (void) __attribute__ ((noinline, noclone, unused));
+
+/* Print the backtrace of the caller of test7 with one of the
+   functions.  A tiny buffer makes backtrace_print_fd flush many
+   times.  */
+
+static void
+print_one (int use_fd, FILE *f)
+{
+  char buf[7];
+
+  fflush (f);
+  if (use_fd)
+    backtrace_print_fd (state, 2, fileno (f), buf, sizeof buf);
+  else
+    backtrace_print (state, 2, f);
+  fflush (f);
+}
+
+/* Read the contents of F into BUF.  Return the length.  */
+
+static size_t
+read_all (FILE *f, char *buf, size_t size)
+{
+  size_t len;
+
+  rewind (f);
+  len = fread (buf, 1, size - 1, f);
+  buf[len] = '\0';
+  return len;
+}
+
+static int
+test7 (void)
+{
+  FILE *files[2];
+  static char contents[2][8192];
+  size_t lens[2];
+  int i;
+  int failed;
+
+  failed = 0;
+  for (i = 0; i < 2; ++i)
+    {
+      files[i] = tmpfile ();
+      if (files[i] == NULL)
+	{
+	  perror ("tmpfile");
+	  exit (EXIT_FAILURE);
+	}
+    }
+
+  /* The frames above test7 are the same for both calls, so the
+     output should match.  */
+  for (i = 0; i < 2; ++i)
+    print_one (i, files[i]);
+
+  for (i = 0; i < 2; ++i)
+    {
+      lens[i] = read_all (files[i], contents[i], sizeof contents[i]);
+      fclose (files[i]);
+    }
+
+  if (lens[0] == 0
+      || strstr (contents[0], "main") == NULL
+      || lens[0] != lens[1]
+      || strcmp (contents[0], contents[1]) != 0)
+    {
+      fprintf (stderr, "test7: backtrace_print:\n%s", contents[0]);
+      fprintf (stderr, "test7: backtrace_print_fd:\n%s", contents[1]);
+      failed = 1;
+    }
+
+  printf ("%s: backtrace_print_fd\n", failed ? "FAIL" : "PASS");
+
+  if (failed)
+    ++failures;
+
+  return failures;
+}
+
+/* Test that backtrace_resolve reports the same information as
+   backtrace_pcinfo and backtrace_syminfo.  */
+
+static int test8 (void) __attribute__ ((noinline, noclone, optnone, unused));
+static int f52 (int) __attribute__ ((noinline, noclone));
+static int f53 (int, int) __attribute__ ((noinline, noclone));
+
+/* Passed to resolve_callback.  */
+
+struct rdata
+{
+  struct bdata bdata;
+  struct symdata symdata;
+};
+
+/* The backtrace_resolve callback.  */
+
+static int
+resolve_callback (void *vdata, uintptr_t pc, const char *filename,
+		  int lineno, const char *function, const char *symname,
+		  uintptr_t symval, uintptr_t symsize)
+{
+  struct rdata *data = (struct rdata *) vdata;
+
+  callback_three (&data->symdata, pc, symname, symval, symsize);
+  return callback_one (&data->bdata, pc, filename, lineno, function);
+}
+
+static int
+test8 (void)
+{
+  return f52 (__LINE__) + 1;
+}
+
+static int
+f52 (int f1line)
+{
+  return f53 (f1line, __LINE__) + 2;
+}
+
+static int
+f53 (int f1line, int f2line)
+{
+  uintptr_t addrs[20];
+  struct info all[3];
+  struct info want[3];
+  struct rdata rdata;
+  struct bdata bdata;
+  struct symdata symdata;
+  int f3line;
+  int failed;
+  int n;
+  int i;
+
+  failed = 0;
+
+  f3line = __LINE__ + 1;
+  n = backtrace_capture (state, 0, addrs, 20);
+
+  if (n < 3)
+    {
+      fprintf (stderr, "test8: too few frames: %d\n", n);
+      failed = 1;
+    }
+
+  rdata.bdata.all = &all[0];
+  rdata.bdata.index = 0;
+  rdata.bdata.max = 3;
+  rdata.bdata.failed = 0;
+
+  bdata.all = &want[0];
+  bdata.index = 0;
+  bdata.max = 3;
+  bdata.failed = 0;
+
+  for (i = 0; i < 3 && !failed; ++i)
+    {
+      memset (&rdata.symdata, 0, sizeof rdata.symdata);
+      memset (&symdata, 0, sizeof symdata);
+
+      if (backtrace_resolve (state, addrs[i], resolve_callback,
+			     error_callback_one, &rdata) != 0
+	  || backtrace_pcinfo (state, addrs[i], callback_one,
+			       error_callback_one, &bdata) != 0)
+	{
+	  fprintf (stderr, "test8: unexpected return value\n");
+	  failed = 1;
+	  break;
+	}
+      backtrace_syminfo (state, addrs[i], callback_three,
+			 error_callback_three, &symdata);
+
+      if (rdata.bdata.failed || bdata.failed || symdata.failed
+	  || rdata.symdata.failed)
+	{
+	  failed = 1;
+	  break;
+	}
+
+      if (rdata.bdata.index != (size_t) i + 1
+	  || bdata.index != (size_t) i + 1)
+	{
+	  fprintf (stderr, "test8: got %d frames for PC %d\n",
+		   (int) rdata.bdata.index - i, i);
+	  failed = 1;
+	  break;
+	}
+
+      if (all[i].lineno != want[i].lineno
+	  || strcmp (all[i].function, want[i].function) != 0
+	  || strcmp (all[i].filename, want[i].filename) != 0)
+	{
+	  fprintf (stderr, "test8: frame %d: got %s:%d %s want %s:%d %s\n",
+		   i, all[i].filename, all[i].lineno, all[i].function,
+		   want[i].filename, want[i].lineno, want[i].function);
+	  failed = 1;
+	}
+
+      if (rdata.symdata.name == NULL
+	  || symdata.name == NULL
+	  || strcmp (rdata.symdata.name, symdata.name) != 0
+	  || rdata.symdata.val != symdata.val
+	  || rdata.symdata.size != symdata.size)
+	{
+	  fprintf (stderr, "test8: frame %d: got symbol %s want %s\n", i,
+		   rdata.symdata.name == NULL ? "NULL" : rdata.symdata.name,
+		   symdata.name == NULL ? "NULL" : symdata.name);
+	  failed = 1;
+	}
+    }
+
+  if (!failed)
+    {
+      check ("test8", 0, all, f3line, "f53", "btest.c", &failed);
+      check ("test8", 1, all, f2line, "f52", "btest.c", &failed);
+      check ("test8", 2, all, f1line, "test8", "btest.c", &failed);
+    }
+
+  printf ("%s: backtrace_resolve\n", failed ? "FAIL" : "PASS");
+
+  if (failed)
+    ++failures;
+
+  return failures;
+}
+
+/* Test that backtraces still work after backtrace_state_freeze.  */
+
+static int test9 (void) __attribute__ ((unused));
+
+static int
+test9 (void)
+{
+  int old_failures;
+  int failed;
+
+  old_failures = failures;
+  failed = 0;
+  if (!backtrace_state_freeze (state, error_callback_create, NULL))
+    {
+      fprintf (stderr, "test9: backtrace_state_freeze failed\n");
+      failed = 1;
+    }
+  else
+    {
+      test1 ();
+      test2 ();
+      test8 ();
+      if (failures != old_failures)
+	failed = 1;
+    }
+
+  printf ("%s: backtrace_state_freeze\n", failed ? "FAIL" : "PASS");
+
+  if (failed)
+    ++failures;
+
+  return failures;
+}
+
 static int test5 (void) __attribute__ ((unused));
 
 int global = 1;
@@ -491,11 +854,56 @@ check_open_files (void)
     }
 }
 
-/* Run all the tests.  */
+/* Time reading all the debug info of FILENAME COUNT times, each time
+   with a new state.  The states are not freed, as there is no way to
+   do that.  */
+
+static void
+benchmark (const char *filename, int count)
+{
+  clock_t best;
+  clock_t total;
+  int i;
+
+  best = 0;
+  total = 0;
+  for (i = 0; i < count; i++)
+    {
+      struct backtrace_state *bstate;
+      clock_t start;
+      clock_t t;
+
+      start = clock ();
+      bstate = backtrace_create_state (filename, 0, error_callback_create,
+				       NULL);
+      if (bstate == NULL
+	  || !backtrace_state_freeze (bstate, error_callback_create, NULL))
+	exit (EXIT_FAILURE);
+      t = clock () - start;
+      total += t;
+      if (i == 0 || t < best)
+	best = t;
+    }
+
+  printf ("%s: read debug info %d times: best %.2f ms, mean %.2f ms\n",
+	  filename, count, (double) best * 1000.0 / CLOCKS_PER_SEC,
+	  (double) total * 1000.0 / CLOCKS_PER_SEC / count);
+}
+
+/* Run all the tests.  With -b, time reading the debug info instead.
+   Optional further arguments are the file to read, by default this
+   program, and the number of times to read it.  */
 
 int
-main (int argc ATTRIBUTE_UNUSED, char **argv)
+main (int argc, char **argv)
 {
+  if (argc > 1 && strcmp (argv[1], "-b") == 0)
+    {
+      benchmark (argc > 2 ? argv[2] : argv[0],
+		 argc > 3 ? atoi (argv[3]) : 20);
+      exit (EXIT_SUCCESS);
+    }
+
   check_available_files ();
 
   state = backtrace_create_state (argv[0], BACKTRACE_SUPPORTS_THREADS,
@@ -506,6 +914,10 @@ main (int argc ATTRIBUTE_UNUSED, char **argv)
   test2 ();
   test3 ();
   test4 ();
+  test6 ();
+  test7 ();
+  test8 ();
+  test9 ();
 #if BACKTRACE_SUPPORTS_DATA
   test5 ();
 #endif
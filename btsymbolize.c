@@ -0,0 +1,649 @@
+/* btsymbolize.c -- Symbolize addresses read from standard input.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    (1) Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    (2) Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in
+    the documentation and/or other materials provided with the
+    distribution.
+
+    (3) The name of the author may not be used to
+    endorse or promote products derived from this software without
+    specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.  */
+
+
+/* A command line symbolizer, a faster replacement for running
+   addr2line once per binary.  It reads queries from standard input,
+   one per line:
+
+     MODULE OFFSET
+
+   MODULE is the path name of an ELF file, or buildid:HEX to find the
+   file by build ID in the debug directories.  OFFSET is a hex
+   address in the file, as it would be passed to addr2line.  For each
+   query this writes one line per frame, innermost first, followed by
+   an empty line:
+
+     SEQ OFFSET FUNCTION FILE:LINE
+
+   SEQ is the number of the query, counting from 0.  Only valid
+   queries are counted: blank lines are skipped, and an invalid line
+   is reported on standard error by its line number and produces no
+   output, so SEQ always matches the order of the queries that are
+   answered.  Queries are collected into batches and sorted by module
+   and offset, which makes the debug info lookups much cheaper, so the
+   results of a batch may be written in a different order than the
+   queries.  A batch ends when it is full or when no more input is
+   available without waiting, so interactive use works.  Each module
+   is read once, the first time it is used.
+
+   Options:
+
+     -d DIR    Look for buildid: modules in DIR/.build-id; may be
+	       repeated.  The default is /usr/lib/debug.
+     -n COUNT  The maximum number of queries in a batch.
+     -b COUNT  Benchmark: read all the queries, symbolize them COUNT
+	       times without writing the results, and report the
+	       number of queries per second on standard error.  */
+
+#include "config.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "backtrace.h"
+
+#ifndef ATTRIBUTE_UNUSED
+# define ATTRIBUTE_UNUSED __attribute__ ((__unused__))
+#endif
+
+/* A module named in the input.  */
+
+struct module
+{
+  /* Next module in the same hash bucket.  */
+  struct module *next;
+  /* The name used in the queries.  */
+  char *name;
+  /* The order in which the module was first seen, used to sort
+     queries.  */
+  size_t index;
+  /* The state, or NULL if it has not been created yet or could not
+     be created.  */
+  struct backtrace_state *state;
+  /* Whether we tried to create the state.  */
+  int opened;
+  /* Whether an error has been reported for this module.  */
+  int reported;
+};
+
+/* A single query.  */
+
+struct query
+{
+  /* The number of the query.  */
+  size_t seq;
+  /* The module.  */
+  struct module *module;
+  /* The address.  */
+  uintptr_t pc;
+};
+
+/* The number of buckets in the module hash table.  */
+
+#define MODULE_HASH_SIZE 1024
+
+static struct module *modules[MODULE_HASH_SIZE];
+
+static size_t module_count;
+
+/* The debug directories.  */
+
+static const char **debug_dirs;
+
+static int debug_dir_count;
+
+/* Whether we are running a benchmark, in which case nothing is
+   written.  */
+
+static int benchmark;
+
+/* The number of frames found while benchmarking, so that the work
+   can't be optimized away.  */
+
+static size_t frame_count;
+
+/* Report a fatal error.  */
+
+static void
+die (const char *msg)
+{
+  fprintf (stderr, "btsymbolize: %s\n", msg);
+  exit (EXIT_FAILURE);
+}
+
+/* Allocate memory or die.  */
+
+static void *
+xmalloc (size_t size)
+{
+  void *ret;
+
+  ret = malloc (size);
+  if (ret == NULL)
+    die ("out of memory");
+  return ret;
+}
+
+/* Error callback for a module.  Each module reports at most one
+   error, so that a module without debug info doesn't produce a
+   message for each query.  */
+
+static void
+module_error_callback (void *data, const char *msg, int errnum)
+{
+  struct module *module = (struct module *) data;
+
+  if (module->reported)
+    return;
+  module->reported = 1;
+  fprintf (stderr, "btsymbolize: %s: %s", module->name, msg);
+  if (errnum > 0)
+    fprintf (stderr, ": %s", strerror (errnum));
+  fputc ('\n', stderr);
+}
+
+/* Convert the hex digit C to a value, or return -1.  */
+
+static int
+hex_value (int c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+/* Create the state for a module named buildid:HEX.  */
+
+static struct backtrace_state *
+open_buildid (struct module *module)
+{
+  const char *hex;
+  size_t len;
+  char *id;
+  size_t i;
+  int d;
+
+  hex = module->name + sizeof "buildid:" - 1;
+  len = strlen (hex);
+  if (len < 4 || len % 2 != 0)
+    {
+      module_error_callback (module, "invalid build ID", 0);
+      return NULL;
+    }
+
+  id = (char *) xmalloc (len / 2);
+  for (i = 0; i < len; i += 2)
+    {
+      int hi;
+      int lo;
+
+      hi = hex_value (hex[i]);
+      lo = hex_value (hex[i + 1]);
+      if (hi < 0 || lo < 0)
+	{
+	  module_error_callback (module, "invalid build ID", 0);
+	  free (id);
+	  return NULL;
+	}
+      id[i / 2] = (char) (hi * 16 + lo);
+    }
+
+  for (d = 0; d < debug_dir_count; ++d)
+    {
+      struct backtrace_module bm;
+      struct backtrace_state *state;
+      char *path;
+
+      path = (char *) xmalloc (strlen (debug_dirs[d]) + len
+			       + sizeof "/.build-id//.debug");
+      sprintf (path, "%s/.build-id/%.2s/%s.debug", debug_dirs[d], hex,
+	       hex + 2);
+      if (access (path, R_OK) != 0)
+	{
+	  free (path);
+	  continue;
+	}
+
+      memset (&bm, 0, sizeof bm);
+      bm.filename = path;
+      bm.build_id = id;
+      bm.build_id_size = len / 2;
+      state = backtrace_create_state_from_modules (&bm, 1, 0,
+						   module_error_callback,
+						   module);
+      /* The state keeps a pointer to the file name.  */
+      if (state != NULL)
+	{
+	  free (id);
+	  return state;
+	}
+      free (path);
+    }
+
+  free (id);
+  module_error_callback (module, "build ID not found", 0);
+  return NULL;
+}
+
+/* Return the state for MODULE, creating it if needed.  */
+
+static struct backtrace_state *
+module_state (struct module *module)
+{
+  if (!module->opened)
+    {
+      module->opened = 1;
+      if (strncmp (module->name, "buildid:", sizeof "buildid:" - 1) == 0)
+	module->state = open_buildid (module);
+      else
+	{
+	  struct backtrace_module bm;
+
+	  memset (&bm, 0, sizeof bm);
+	  bm.filename = module->name;
+	  module->state = backtrace_create_state_from_modules (
+	      &bm, 1, 0, module_error_callback, module);
+	}
+    }
+  return module->state;
+}
+
+/* Return the module called NAME, of length LEN.  */
+
+static struct module *
+lookup_module (const char *name, size_t len)
+{
+  unsigned int hash;
+  size_t i;
+  struct module *module;
+
+  hash = 0;
+  for (i = 0; i < len; ++i)
+    hash = hash * 31 + (unsigned char) name[i];
+  hash %= MODULE_HASH_SIZE;
+
+  for (module = modules[hash]; module != NULL; module = module->next)
+    {
+      if (strncmp (module->name, name, len) == 0
+	  && module->name[len] == '\0')
+	return module;
+    }
+
+  module = (struct module *) xmalloc (sizeof *module);
+  memset (module, 0, sizeof *module);
+  module->name = (char *) xmalloc (len + 1);
+  memcpy (module->name, name, len);
+  module->name[len] = '\0';
+  module->index = module_count++;
+  module->next = modules[hash];
+  modules[hash] = module;
+  return module;
+}
+
+/* Parse the query in LINE, of length LEN, into *Q.  Returns 0 if the
+   line is not a valid query.  */
+
+static int
+parse_query (const char *line, size_t len, struct query *q)
+{
+  const char *p;
+  const char *end;
+  const char *name;
+  size_t name_len;
+  uintptr_t pc;
+  int digits;
+
+  p = line;
+  end = line + len;
+  while (p < end && (*p == ' ' || *p == '\t'))
+    ++p;
+  name = p;
+  while (p < end && *p != ' ' && *p != '\t')
+    ++p;
+  name_len = (size_t) (p - name);
+  while (p < end && (*p == ' ' || *p == '\t'))
+    ++p;
+  if (name_len == 0)
+    return 0;
+
+  if (end - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+    p += 2;
+  pc = 0;
+  digits = 0;
+  while (p < end && hex_value (*p) >= 0)
+    {
+      pc = pc * 16 + (uintptr_t) hex_value (*p);
+      ++p;
+      ++digits;
+    }
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+    ++p;
+  if (digits == 0 || p != end)
+    return 0;
+
+  q->module = lookup_module (name, name_len);
+  q->pc = pc;
+  return 1;
+}
+
+/* Sort queries by module and then by address.  */
+
+static int
+query_compare (const void *v1, const void *v2)
+{
+  const struct query *q1 = (const struct query *) v1;
+  const struct query *q2 = (const struct query *) v2;
+
+  if (q1->module->index != q2->module->index)
+    return q1->module->index < q2->module->index ? -1 : 1;
+  if (q1->pc != q2->pc)
+    return q1->pc < q2->pc ? -1 : 1;
+  if (q1->seq != q2->seq)
+    return q1->seq < q2->seq ? -1 : 1;
+  return 0;
+}
+
+/* Data passed to frame_callback.  */
+
+struct frame_data
+{
+  const struct query *q;
+  int frames;
+};
+
+/* A backtrace_pcinfo callback that writes one frame.  */
+
+static int
+frame_callback (void *data, uintptr_t pc ATTRIBUTE_UNUSED,
+		const char *filename, int lineno, const char *function)
+{
+  struct frame_data *fd = (struct frame_data *) data;
+
+  if (function == NULL && filename == NULL)
+    return 0;
+  ++fd->frames;
+  if (benchmark)
+    {
+      ++frame_count;
+      return 0;
+    }
+  printf ("%lu 0x%lx %s %s:%d\n", (unsigned long) fd->q->seq,
+	  (unsigned long) fd->q->pc, function == NULL ? "??" : function,
+	  filename == NULL ? "??" : filename, lineno);
+  return 0;
+}
+
+/* A backtrace_syminfo callback used when there is no line
+   information.  */
+
+static void
+symbol_callback (void *data, uintptr_t pc,
+		 const char *symname, uintptr_t symval ATTRIBUTE_UNUSED,
+		 uintptr_t symsize ATTRIBUTE_UNUSED)
+{
+  if (symname != NULL)
+    frame_callback (data, pc, "??", 0, symname);
+}
+
+/* Symbolize the COUNT queries in QUERIES.  */
+
+static void
+process_batch (struct query *queries, size_t count)
+{
+  size_t i;
+
+  qsort (queries, count, sizeof (struct query), query_compare);
+
+  for (i = 0; i < count; ++i)
+    {
+      const struct query *q;
+      struct backtrace_state *state;
+      struct frame_data fd;
+
+      q = &queries[i];
+      fd.q = q;
+      fd.frames = 0;
+      state = module_state (q->module);
+      if (state != NULL)
+	{
+	  backtrace_pcinfo (state, q->pc, frame_callback,
+			    module_error_callback, &fd);
+	  if (fd.frames == 0)
+	    backtrace_syminfo (state, q->pc, symbol_callback,
+			       module_error_callback, &fd);
+	}
+      if (benchmark)
+	continue;
+      if (fd.frames == 0)
+	printf ("%lu 0x%lx ?? ??:0\n", (unsigned long) q->seq,
+		(unsigned long) q->pc);
+      putchar ('\n');
+    }
+
+  if (!benchmark)
+    fflush (stdout);
+}
+
+/* Return whether more input is available without waiting.  */
+
+static int
+input_ready (void)
+{
+  struct pollfd pfd;
+
+  pfd.fd = 0;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  return poll (&pfd, 1, 0) > 0;
+}
+
+/* Return the current time in seconds.  */
+
+static double
+now (void)
+{
+#ifdef HAVE_CLOCK_GETTIME
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+#else
+  return (double) time (NULL);
+#endif
+}
+
+/* The size of the input buffer.  */
+
+#define INPUT_SIZE 65536
+
+int
+main (int argc, char **argv)
+{
+  size_t batch_size;
+  long repeat;
+  int opt;
+  struct query *queries;
+  size_t count;
+  size_t alc;
+  size_t seq;
+  size_t lineno;
+  char *buf;
+  size_t buf_len;
+  int eof;
+
+  batch_size = 4096;
+  repeat = 0;
+  debug_dirs = (const char **) xmalloc (argc * sizeof (const char *));
+  debug_dir_count = 0;
+  while ((opt = getopt (argc, argv, "b:d:n:")) != -1)
+    {
+      switch (opt)
+	{
+	case 'b':
+	  repeat = atol (optarg);
+	  if (repeat <= 0)
+	    die ("invalid -b option");
+	  break;
+	case 'd':
+	  debug_dirs[debug_dir_count++] = optarg;
+	  break;
+	case 'n':
+	  batch_size = (size_t) atol (optarg);
+	  if (batch_size == 0)
+	    die ("invalid -n option");
+	  break;
+	default:
+	  fprintf (stderr,
+		   "usage: btsymbolize [-d dir]... [-n batch] [-b repeat]\n");
+	  exit (EXIT_FAILURE);
+	}
+    }
+  if (optind != argc)
+    die ("unexpected argument");
+  if (debug_dir_count == 0)
+    debug_dirs[debug_dir_count++] = "/usr/lib/debug";
+
+  /* When benchmarking, read all the queries into a single batch.  */
+  benchmark = repeat > 0;
+  alc = benchmark ? 4096 : batch_size;
+  queries = (struct query *) xmalloc (alc * sizeof (struct query));
+  count = 0;
+  seq = 0;
+  lineno = 0;
+
+  buf = (char *) xmalloc (INPUT_SIZE);
+  buf_len = 0;
+  eof = 0;
+  while (!eof)
+    {
+      ssize_t got;
+      char *line;
+      char *nl;
+
+      got = read (0, buf + buf_len, INPUT_SIZE - buf_len);
+      if (got < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  die (strerror (errno));
+	}
+      if (got == 0)
+	{
+	  eof = 1;
+	  /* Treat a final line without a newline as complete.  */
+	  if (buf_len > 0 && buf_len < INPUT_SIZE)
+	    buf[buf_len++] = '\n';
+	}
+      buf_len += (size_t) got;
+
+      line = buf;
+      while ((nl = (char *) memchr (line, '\n', buf_len - (line - buf)))
+	     != NULL)
+	{
+	  struct query *q;
+
+	  if (count == alc)
+	    {
+	      if (!benchmark)
+		{
+		  process_batch (queries, count);
+		  count = 0;
+		}
+	      else
+		{
+		  alc *= 2;
+		  queries = ((struct query *)
+			     realloc (queries, alc * sizeof (struct query)));
+		  if (queries == NULL)
+		    die ("out of memory");
+		}
+	    }
+
+	  ++lineno;
+	  q = &queries[count];
+	  if (parse_query (line, (size_t) (nl - line), q))
+	    {
+	      q->seq = seq++;
+	      ++count;
+	    }
+	  else if (strspn (line, " \t\r") < (size_t) (nl - line))
+	    fprintf (stderr, "btsymbolize: line %lu: invalid query\n",
+		     (unsigned long) lineno);
+	  line = nl + 1;
+	}
+
+      buf_len -= (size_t) (line - buf);
+      memmove (buf, line, buf_len);
+      if (buf_len == INPUT_SIZE)
+	die ("input line too long");
+
+      if (!benchmark && count > 0 && (eof || !input_ready ()))
+	{
+	  process_batch (queries, count);
+	  count = 0;
+	}
+    }
+
+  if (benchmark)
+    {
+      double start;
+      double first;
+      double end;
+      long i;
+
+      start = now ();
+      process_batch (queries, count);
+      first = now ();
+      for (i = 1; i < repeat; ++i)
+	process_batch (queries, count);
+      end = now ();
+
+      fprintf (stderr, "%lu queries, %lu frames per pass\n",
+	       (unsigned long) count, (unsigned long) (frame_count / repeat));
+      fprintf (stderr, "first pass: %.3f s (%.0f queries/s)\n",
+	       first - start, count / (first - start));
+      if (repeat > 1)
+	fprintf (stderr, "later passes: %.3f s (%.0f queries/s)\n",
+		 end - first, (double) count * (repeat - 1) / (end - first));
+    }
+
+  return 0;
+}
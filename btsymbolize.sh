@@ -0,0 +1,74 @@
+#!/bin/sh
+
+# btsymbolize.sh -- Test the btsymbolize program.
+# Copyright (C) 2024 Free Software Foundation, Inc.
+
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are
+# met:
+
+#     (1) Redistributions of source code must retain the above copyright
+#     notice, this list of conditions and the following disclaimer.
+
+#     (2) Redistributions in binary form must reproduce the above copyright
+#     notice, this list of conditions and the following disclaimer in
+#     the documentation and/or other materials provided with the
+#     distribution.
+
+#     (3) The name of the author may not be used to
+#     endorse or promote products derived from this software without
+#     specific prior written permission.
+
+# THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+# IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+# INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+# (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+# HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+# STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+# IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+
+set -e
+
+if [ ! -f ./btsymbolize ] || [ ! -f ./symtarget ]; then
+    # Hard failure.
+    exit 99
+fi
+
+./symtarget > symtarget.out
+awk '{ print $1, $2 }' symtarget.out > symtarget.queries
+
+# Blank and invalid lines must not use up a query number.
+{ echo; echo "not a query"; echo; cat symtarget.queries; } \
+    | ./btsymbolize > symtarget.result 2> symtarget.err
+grep -q "line 2: invalid query" symtarget.err
+
+# Check the innermost frame of each query against the expected
+# function name.  The results are grouped by query, but the queries
+# may be in any order.
+awk '
+NR == FNR { want[NR - 1] = $3; queries++; next }
+NF == 0 { next }
+!($1 in seen) {
+  seen[$1] = 1
+  found++
+  if ($3 != want[$1]) {
+    print "query " $1 ": got " $3 ", want " want[$1]
+    bad = 1
+  }
+}
+END {
+  if (found != queries) {
+    print "got " found " results, want " queries
+    bad = 1
+  }
+  exit bad
+}' symtarget.out symtarget.result
+
+# Report the throughput.
+./btsymbolize -b 100 < symtarget.queries
+
+exit 0
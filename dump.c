@@ -0,0 +1,772 @@
+/* dump.c -- Dump the stacks of all threads.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    (1) Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    (2) Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in
+    the documentation and/or other materials provided with the
+    distribution.
+
+    (3) The name of the author may not be used to
+    endorse or promote products derived from this software without
+    specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.  */
+
+
+#include "config.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <sys/syscall.h>
+#endif
+
+#ifdef HAVE_PTHREAD_CREATE
+#include <pthread.h>
+#endif
+
+#include "backtrace.h"
+#include "internal.h"
+
+/* Dump the stacks of all the threads in the process.  The calling
+   thread sends a signal to every other thread listed in
+   /proc/self/task.  The signal handler captures the stack of its
+   thread from the interrupted registers with
+   backtrace_capture_context, which never allocates or takes locks,
+   into a slot that was allocated before any signal was sent.  The
+   threads being dumped have usually never looked up the bounds of
+   their stacks, so the calling thread reads the readable regions of
+   memory from /proc/self/maps first, and the handler only reads
+   memory in the region that holds its stack pointer.  Once every
+   thread has answered, or the timeout has expired, the calling
+   thread collects the distinct PCs of all the stacks and symbolizes
+   each of them once, in parallel on a few worker threads.  The
+   result is then reported thread by thread.  In a process with many
+   threads running the same code, most stacks share most of their
+   PCs, so this is much cheaper than calling backtrace_pcinfo for
+   every frame of every thread.  */
+
+#if defined (HAVE_ATOMIC_FUNCTIONS) && defined (SYS_gettid) \
+  && defined (SYS_tgkill)
+
+/* The stack of one thread.  */
+
+struct dump_slot
+{
+  /* The thread ID.  */
+  pid_t tid;
+  /* The number of PCs, or -1 if the thread has not answered.  Set
+     by the signal handler.  */
+  int count;
+  /* The value of count when the dump stopped waiting.  */
+  int final_count;
+  /* The PCs, which point into the pcs field of struct dump.  */
+  uintptr_t *pcs;
+};
+
+/* A dump in progress.  */
+
+struct dump
+{
+  /* The state used to capture the stacks.  */
+  struct backtrace_state *state;
+  /* The slots.  */
+  struct dump_slot *slots;
+  /* The number of slots allocated.  */
+  int max_threads;
+  /* The number of slots in use.  */
+  int nslots;
+  /* The maximum number of PCs per thread.  */
+  int max_depth;
+  /* The PCs of all the threads.  */
+  uintptr_t *pcs;
+  /* The readable regions of memory, as pairs of start and end
+     addresses sorted by start, or NULL if they are not known.  */
+  struct backtrace_vector regions;
+  /* The number of threads that have answered.  */
+  int answered;
+};
+
+/* The dump that the signal handler writes to.  */
+
+static struct dump *active_dump;
+
+/* The number of signal handlers that are running.  The dump is not
+   freed until this drops to zero.  */
+
+static int dump_handlers;
+
+/* The signal handler, run by each thread that is being dumped.  */
+
+static void
+dump_handler (int sig ATTRIBUTE_UNUSED, siginfo_t *info ATTRIBUTE_UNUSED,
+	      void *context)
+{
+  struct dump *dump;
+  int saved_errno;
+  const uintptr_t *regions;
+  size_t nregions;
+  pid_t tid;
+  int i;
+
+  /* Count this handler before looking at active_dump, so that the
+     dumping thread either sees us or we see a NULL dump.  */
+  __atomic_add_fetch (&dump_handlers, 1, __ATOMIC_SEQ_CST);
+  dump = __atomic_load_n (&active_dump, __ATOMIC_SEQ_CST);
+  if (dump == NULL)
+    {
+      __atomic_sub_fetch (&dump_handlers, 1, __ATOMIC_SEQ_CST);
+      return;
+    }
+
+  saved_errno = errno;
+  regions = (const uintptr_t *) dump->regions.base;
+  nregions = dump->regions.size / (2 * sizeof (uintptr_t));
+  tid = (pid_t) syscall (SYS_gettid);
+  for (i = 0; i < dump->nslots; ++i)
+    {
+      struct dump_slot *slot;
+      int count;
+
+      slot = &dump->slots[i];
+      if (slot->tid != tid)
+	continue;
+      if (__atomic_load_n (&slot->count, __ATOMIC_RELAXED) >= 0)
+	break;
+
+      count = backtrace_capture_context (dump->state, context, regions,
+					 nregions, slot->pcs,
+					 dump->max_depth);
+      __atomic_store_n (&slot->count, count, __ATOMIC_RELEASE);
+      __atomic_add_fetch (&dump->answered, 1, __ATOMIC_RELEASE);
+      break;
+    }
+  errno = saved_errno;
+
+  __atomic_sub_fetch (&dump_handlers, 1, __ATOMIC_SEQ_CST);
+}
+
+/* Sleep for a millisecond.  */
+
+static void
+dump_sleep (void)
+{
+  struct timespec ts;
+
+  ts.tv_sec = 0;
+  ts.tv_nsec = 1000000;
+  nanosleep (&ts, NULL);
+}
+
+/* Compare two PCs, for backtrace_qsort and bsearch.  */
+
+static int
+dump_pc_compare (const void *v1, const void *v2)
+{
+  uintptr_t pc1 = *(const uintptr_t *) v1;
+  uintptr_t pc2 = *(const uintptr_t *) v2;
+
+  if (pc1 < pc2)
+    return -1;
+  else if (pc1 > pc2)
+    return 1;
+  else
+    return 0;
+}
+
+/* One frame of symbolized output.  */
+
+struct dump_frame
+{
+  const char *filename;
+  int lineno;
+  const char *function;
+};
+
+/* The symbolized frames of a distinct PC.  The first field is the PC,
+   so that an array of these can be searched with dump_pc_compare.  */
+
+struct dump_pc
+{
+  /* The PC.  */
+  uintptr_t pc;
+  /* The worker that symbolized the PC.  */
+  int worker;
+  /* The number of frames; more than one for inlined calls.  */
+  int count;
+  /* The index of the first frame in the frames of the worker.  */
+  size_t first;
+};
+
+/* Data shared by the workers.  */
+
+struct dump_symbolize
+{
+  struct backtrace_state *state;
+  /* The distinct PCs.  */
+  struct dump_pc *upcs;
+  /* The number of distinct PCs.  */
+  size_t count;
+  /* The index of the next PC to symbolize.  */
+  size_t next;
+  backtrace_error_callback error_callback;
+  void *data;
+};
+
+/* The data of a single worker.  */
+
+struct dump_worker
+{
+  struct dump_symbolize *sym;
+  /* The index of this worker.  */
+  int index;
+  /* The frames found by this worker.  */
+  struct backtrace_vector frames;
+  /* The PC being symbolized.  */
+  struct dump_pc *upc;
+  /* Set if memory allocation failed.  */
+  int failed;
+};
+
+/* The number of PCs a worker takes at a time.  */
+
+#define DUMP_CHUNK 32
+
+/* The backtrace_pcinfo callback used by the workers.  */
+
+static int
+dump_pcinfo_callback (void *data, uintptr_t pc ATTRIBUTE_UNUSED,
+		      const char *filename, int lineno, const char *function)
+{
+  struct dump_worker *worker = (struct dump_worker *) data;
+  struct dump_frame *frame;
+
+  frame = ((struct dump_frame *)
+	   backtrace_vector_grow (worker->sym->state, sizeof *frame,
+				  worker->sym->error_callback,
+				  worker->sym->data, &worker->frames));
+  if (frame == NULL)
+    {
+      worker->failed = 1;
+      return 1;
+    }
+  frame->filename = filename;
+  frame->lineno = lineno;
+  frame->function = function;
+  ++worker->upc->count;
+  return 0;
+}
+
+/* The backtrace_pcinfo error callback used by the workers.  */
+
+static void
+dump_error_callback (void *data, const char *msg, int errnum)
+{
+  struct dump_worker *worker = (struct dump_worker *) data;
+
+  worker->sym->error_callback (worker->sym->data, msg, errnum);
+}
+
+/* Symbolize distinct PCs until there are none left.  */
+
+static void *
+dump_worker_run (void *arg)
+{
+  struct dump_worker *worker = (struct dump_worker *) arg;
+  struct dump_symbolize *sym = worker->sym;
+
+  while (!worker->failed)
+    {
+      size_t start;
+      size_t end;
+      size_t i;
+
+      start = __atomic_fetch_add (&sym->next, DUMP_CHUNK, __ATOMIC_RELAXED);
+      if (start >= sym->count)
+	break;
+      end = start + DUMP_CHUNK;
+      if (end > sym->count)
+	end = sym->count;
+
+      for (i = start; i < end && !worker->failed; ++i)
+	{
+	  struct dump_pc *upc;
+
+	  upc = &sym->upcs[i];
+	  upc->worker = worker->index;
+	  upc->count = 0;
+	  upc->first = worker->frames.size / sizeof (struct dump_frame);
+	  worker->upc = upc;
+	  backtrace_pcinfo (sym->state, upc->pc, dump_pcinfo_callback,
+			    dump_error_callback, worker);
+	}
+    }
+
+  return NULL;
+}
+
+/* Symbolize the COUNT distinct PCs in UPCS using NWORKERS threads.
+   Returns the array of workers, or NULL on error.  */
+
+static struct dump_worker *
+dump_symbolize (struct backtrace_state *state, struct dump_pc *upcs,
+		size_t count, int nworkers,
+		backtrace_error_callback error_callback, void *data)
+{
+  struct dump_symbolize sym;
+  struct dump_worker *workers;
+  int i;
+  int failed;
+
+  workers = ((struct dump_worker *)
+	     backtrace_alloc (state, nworkers * sizeof *workers,
+			      error_callback, data));
+  if (workers == NULL)
+    return NULL;
+
+  sym.state = state;
+  sym.upcs = upcs;
+  sym.count = count;
+  sym.next = 0;
+  sym.error_callback = error_callback;
+  sym.data = data;
+
+  memset (workers, 0, nworkers * sizeof *workers);
+  for (i = 0; i < nworkers; ++i)
+    {
+      workers[i].sym = &sym;
+      workers[i].index = i;
+    }
+
+#ifdef HAVE_PTHREAD_CREATE
+  {
+    pthread_t *tids;
+    int started;
+
+    tids = NULL;
+    if (nworkers > 1)
+      tids = ((pthread_t *)
+	      backtrace_alloc (state, (nworkers - 1) * sizeof *tids,
+			       error_callback, data));
+
+    /* The calling thread is worker 0.  If a thread can't be created,
+       the threads that were created do all the work.  */
+    started = 0;
+    if (tids != NULL)
+      {
+	for (i = 1; i < nworkers; ++i)
+	  {
+	    if (pthread_create (&tids[i - 1], NULL, dump_worker_run,
+				&workers[i]) != 0)
+	      break;
+	    ++started;
+	  }
+      }
+
+    dump_worker_run (&workers[0]);
+
+    for (i = 0; i < started; ++i)
+      pthread_join (tids[i], NULL);
+
+    if (tids != NULL)
+      backtrace_free (state, tids, (nworkers - 1) * sizeof *tids,
+		      error_callback, data);
+  }
+#else
+  dump_worker_run (&workers[0]);
+#endif
+
+  failed = 0;
+  for (i = 0; i < nworkers; ++i)
+    if (workers[i].failed)
+      failed = 1;
+  if (failed)
+    {
+      for (i = 0; i < nworkers; ++i)
+	backtrace_vector_free (state, &workers[i].frames, error_callback,
+			       data);
+      backtrace_free (state, workers, nworkers * sizeof *workers,
+		      error_callback, data);
+      return NULL;
+    }
+
+  return workers;
+}
+
+/* Read the readable regions of memory from /proc/self/maps into
+   DUMP.  If they can't be read, the handler falls back to reading
+   less of each stack, so errors are ignored.  */
+
+static void
+dump_read_regions (struct backtrace_state *state, struct dump *dump,
+		   backtrace_error_callback error_callback, void *data)
+{
+  FILE *f;
+  unsigned long start;
+  unsigned long end;
+  char perms[5];
+
+  f = fopen ("/proc/self/maps", "r");
+  if (f == NULL)
+    return;
+  while (fscanf (f, "%lx-%lx %4s", &start, &end, perms) == 3)
+    {
+      int c;
+
+      if (perms[0] == 'r' && start < end)
+	{
+	  uintptr_t *p;
+
+	  p = ((uintptr_t *)
+	       backtrace_vector_grow (state, 2 * sizeof (uintptr_t),
+				      error_callback, data, &dump->regions));
+	  if (p == NULL)
+	    {
+	      backtrace_vector_free (state, &dump->regions, error_callback,
+				     data);
+	      break;
+	    }
+	  p[0] = (uintptr_t) start;
+	  p[1] = (uintptr_t) end;
+	}
+
+      do
+	c = getc (f);
+      while (c != '\n' && c != EOF);
+    }
+  fclose (f);
+}
+
+/* Free DUMP and its buffers.  */
+
+static void
+dump_free (struct backtrace_state *state, struct dump *dump,
+	   backtrace_error_callback error_callback, void *data)
+{
+  backtrace_vector_free (state, &dump->regions, error_callback, data);
+  if (dump->pcs != NULL)
+    backtrace_free (state, dump->pcs,
+		    ((size_t) dump->max_threads * dump->max_depth
+		     * sizeof (uintptr_t)),
+		    error_callback, data);
+  if (dump->slots != NULL)
+    backtrace_free (state, dump->slots,
+		    (size_t) dump->max_threads * sizeof (struct dump_slot),
+		    error_callback, data);
+  backtrace_free (state, dump, sizeof *dump, error_callback, data);
+}
+
+/* Dump the stacks of all threads.  */
+
+int
+backtrace_dump_threads (struct backtrace_state *state, int signo,
+			int max_threads, int max_depth, int timeout_ms,
+			int nworkers,
+			backtrace_thread_callback thread_callback,
+			backtrace_full_callback callback,
+			backtrace_error_callback error_callback, void *data)
+{
+  struct dump *dump;
+  struct sigaction sa;
+  struct sigaction old_sa;
+  pid_t pid;
+  pid_t self;
+  DIR *dir;
+  struct dirent *de;
+  int sent;
+  int waited;
+  int leak;
+  size_t total;
+  size_t ucount;
+  struct dump_pc *upcs;
+  size_t upcs_size;
+  struct dump_worker *workers;
+  size_t i;
+  int j;
+  int ret;
+
+  if (max_threads <= 0
+      || max_depth <= 0
+      || max_depth > BACKTRACE_STACK_MAX_DEPTH
+      || timeout_ms < 0)
+    {
+      error_callback (data, "invalid dump parameters", 0);
+      return 0;
+    }
+
+  if (nworkers <= 0 || !state->threaded)
+    nworkers = 1;
+
+  /* Read the debug info now, so that the workers don't all try to
+     read it at once, and so that a failure is reported once.  */
+  if (!backtrace_fileline_initialize (state, error_callback, data))
+    return 0;
+
+  dump = ((struct dump *)
+	  backtrace_alloc (state, sizeof *dump, error_callback, data));
+  if (dump == NULL)
+    return 0;
+  memset (dump, 0, sizeof *dump);
+  dump->state = state;
+  dump->max_threads = max_threads;
+  dump->max_depth = max_depth;
+
+  dump->slots = ((struct dump_slot *)
+		 backtrace_alloc (state,
+				  ((size_t) max_threads
+				   * sizeof (struct dump_slot)),
+				  error_callback, data));
+  if (dump->slots == NULL)
+    {
+      dump_free (state, dump, error_callback, data);
+      return 0;
+    }
+  dump->pcs = ((uintptr_t *)
+	       backtrace_alloc (state,
+				((size_t) max_threads * max_depth
+				 * sizeof (uintptr_t)),
+				error_callback, data));
+  if (dump->pcs == NULL)
+    {
+      dump_free (state, dump, error_callback, data);
+      return 0;
+    }
+
+  /* Record the threads before sending any signals, so that the
+     handler never sees a slot change.  */
+  pid = getpid ();
+  self = (pid_t) syscall (SYS_gettid);
+  dir = opendir ("/proc/self/task");
+  if (dir == NULL)
+    {
+      error_callback (data, "/proc/self/task", errno);
+      dump_free (state, dump, error_callback, data);
+      return 0;
+    }
+  while ((de = readdir (dir)) != NULL)
+    {
+      struct dump_slot *slot;
+      pid_t tid;
+
+      tid = (pid_t) atoi (de->d_name);
+      if (tid <= 0)
+	continue;
+      if (dump->nslots >= max_threads)
+	{
+	  error_callback (data, "too many threads to dump", 0);
+	  break;
+	}
+      slot = &dump->slots[dump->nslots];
+      slot->tid = tid;
+      slot->count = -1;
+      slot->pcs = dump->pcs + (size_t) dump->nslots * max_depth;
+      ++dump->nslots;
+    }
+  closedir (dir);
+
+  /* The signal handler can't read the unwind tables of modules loaded
+     since they were last read.  */
+  backtrace_eh_frame_sync (state);
+  dump_read_regions (state, dump, error_callback, data);
+
+  memset (&sa, 0, sizeof sa);
+  sa.sa_sigaction = dump_handler;
+  sa.sa_flags = SA_SIGINFO | SA_RESTART;
+  sigemptyset (&sa.sa_mask);
+  if (sigaction (signo, &sa, &old_sa) < 0)
+    {
+      error_callback (data, "sigaction", errno);
+      dump_free (state, dump, error_callback, data);
+      return 0;
+    }
+
+  if (!__sync_bool_compare_and_swap (&active_dump, NULL, dump))
+    {
+      error_callback (data, "dump already in progress", 0);
+      sigaction (signo, &old_sa, NULL);
+      dump_free (state, dump, error_callback, data);
+      return 0;
+    }
+
+  sent = 0;
+  for (j = 0; j < dump->nslots; ++j)
+    {
+      struct dump_slot *slot;
+
+      slot = &dump->slots[j];
+      if (slot->tid == self)
+	{
+	  /* Skip this function, so that like the other threads the
+	     stack starts where the thread was when the dump began.  */
+	  slot->count = backtrace_capture (state, 1, slot->pcs, max_depth);
+	  continue;
+	}
+
+      /* A thread that has exited since we read the directory is left
+	 with a count of -1.  */
+      if (syscall (SYS_tgkill, pid, slot->tid, signo) == 0)
+	++sent;
+    }
+
+  waited = 0;
+  while (__atomic_load_n (&dump->answered, __ATOMIC_ACQUIRE) < sent
+	 && waited < timeout_ms)
+    {
+      dump_sleep ();
+      ++waited;
+    }
+
+  /* Stop any late handler from writing to the dump, and wait for the
+     ones already running.  A handler that is stuck, for example
+     because its thread was interrupted holding a lock that the
+     unwinder needs, would write to the dump at some later time, so
+     in that case the memory is never freed.  */
+  __atomic_store_n (&active_dump, NULL, __ATOMIC_SEQ_CST);
+  waited = 0;
+  while (__atomic_load_n (&dump_handlers, __ATOMIC_SEQ_CST) != 0
+	 && waited < timeout_ms)
+    {
+      dump_sleep ();
+      ++waited;
+    }
+  leak = __atomic_load_n (&dump_handlers, __ATOMIC_SEQ_CST) != 0;
+
+  /* A thread that has not answered, for example because it has the
+     signal blocked, still has the signal pending.  Delivering it
+     under the old action, usually SIG_DFL, would kill the process, so
+     in that case leave our handler installed; with no active dump it
+     does nothing.  */
+  if (!leak && __atomic_load_n (&dump->answered, __ATOMIC_ACQUIRE) >= sent)
+    sigaction (signo, &old_sa, NULL);
+
+  /* Collect the distinct PCs.  */
+  total = 0;
+  for (j = 0; j < dump->nslots; ++j)
+    {
+      struct dump_slot *slot;
+
+      slot = &dump->slots[j];
+      slot->final_count = __atomic_load_n (&slot->count, __ATOMIC_ACQUIRE);
+      if (slot->final_count > 0)
+	total += slot->final_count;
+    }
+
+  ret = 0;
+  upcs = NULL;
+  upcs_size = total * sizeof (struct dump_pc);
+  ucount = 0;
+  if (total > 0)
+    {
+      upcs = ((struct dump_pc *)
+	      backtrace_alloc (state, upcs_size, error_callback, data));
+      if (upcs == NULL)
+	goto done;
+      for (j = 0; j < dump->nslots; ++j)
+	{
+	  struct dump_slot *slot;
+	  int k;
+
+	  slot = &dump->slots[j];
+	  for (k = 0; k < slot->final_count; ++k)
+	    upcs[ucount++].pc = slot->pcs[k];
+	}
+      backtrace_qsort (upcs, ucount, sizeof (struct dump_pc),
+		       dump_pc_compare);
+      total = ucount;
+      ucount = 1;
+      for (i = 1; i < total; ++i)
+	if (upcs[i].pc != upcs[ucount - 1].pc)
+	  upcs[ucount++].pc = upcs[i].pc;
+    }
+
+  if ((size_t) nworkers > (ucount + DUMP_CHUNK - 1) / DUMP_CHUNK)
+    nworkers = (ucount + DUMP_CHUNK - 1) / DUMP_CHUNK;
+  if (nworkers < 1)
+    nworkers = 1;
+  workers = dump_symbolize (state, upcs, ucount, nworkers, error_callback,
+			    data);
+  if (workers == NULL)
+    goto done;
+
+  /* Report the stacks.  */
+  for (j = 0; j < dump->nslots && ret == 0; ++j)
+    {
+      struct dump_slot *slot;
+      int k;
+
+      slot = &dump->slots[j];
+      ret = thread_callback (data, (int) slot->tid, slot->final_count);
+      for (k = 0; k < slot->final_count && ret == 0; ++k)
+	{
+	  struct dump_pc *upc;
+	  const struct dump_frame *frames;
+	  int f;
+
+	  upc = ((struct dump_pc *)
+		 bsearch (&slot->pcs[k], upcs, ucount,
+			  sizeof (struct dump_pc), dump_pc_compare));
+	  frames = ((const struct dump_frame *)
+		    workers[upc->worker].frames.base) + upc->first;
+	  for (f = 0; f < upc->count && ret == 0; ++f)
+	    ret = callback (data, upc->pc, frames[f].filename,
+			    frames[f].lineno, frames[f].function);
+	}
+    }
+
+  for (j = 0; j < nworkers; ++j)
+    backtrace_vector_free (state, &workers[j].frames, error_callback, data);
+  backtrace_free (state, workers, nworkers * sizeof *workers, error_callback,
+		  data);
+
+ done:
+  if (upcs != NULL)
+    backtrace_free (state, upcs, upcs_size, error_callback, data);
+  if (!leak)
+    dump_free (state, dump, error_callback, data);
+  return ret;
+}
+
+#else /* !(HAVE_ATOMIC_FUNCTIONS && ...) */
+
+int
+backtrace_dump_threads (struct backtrace_state *state ATTRIBUTE_UNUSED,
+			int signo ATTRIBUTE_UNUSED,
+			int max_threads ATTRIBUTE_UNUSED,
+			int max_depth ATTRIBUTE_UNUSED,
+			int timeout_ms ATTRIBUTE_UNUSED,
+			int nworkers ATTRIBUTE_UNUSED,
+			backtrace_thread_callback thread_callback
+			  ATTRIBUTE_UNUSED,
+			backtrace_full_callback callback ATTRIBUTE_UNUSED,
+			backtrace_error_callback error_callback, void *data)
+{
+  error_callback (data, "dumping threads not supported on this system", 0);
+  return 0;
+}
+
+#endif /* !(HAVE_ATOMIC_FUNCTIONS && ...) */
@@ -37,6 +37,10 @@ POSSIBILITY OF SUCH DAMAGE.  */
 #include <string.h>
 #include <sys/types.h>
 
+#if defined (__BMI2__) && defined (__x86_64__)
+#include <immintrin.h>
+#endif
+
 #include "filenames.h"
 
 #include "backtrace.h"
@@ -428,6 +432,9 @@ struct attr
   enum dwarf_form form;
   /* The attribute value, for DW_FORM_implicit_const.  */
   int64_t val;
+  /* The size of the attribute value in the entry, or -1 if the size
+     is not fixed.  */
+  int size;
 };
 
 /* A single DWARF abbreviation.  */
@@ -444,6 +451,10 @@ struct abbrev
   size_t num_attrs;
   /* The attributes.  */
   struct attr *attrs;
+  /* The total size of the attribute values, if every attribute has a
+     fixed size; otherwise (size_t) -1.  This lets us skip entries that
+     we don't care about without decoding them.  */
+  size_t fixed_size;
 };
 
 /* The DWARF abbreviations for a compilation unit.  This structure
@@ -600,6 +611,12 @@ struct function
   /* Map PC ranges to inlined functions.  */
   struct function_addrs *function_addrs;
   size_t function_addrs_count;
+  /* If the inlined calls in this function have not been read yet, the
+     first child entry of the function in the unit data; otherwise
+     NULL.  See read_inlined_functions.  */
+  const unsigned char *inlined_data;
+  /* The base address to use when reading the inlined calls.  */
+  uintptr_t inlined_base;
 };
 
 /* An address range for a function.  This maps a PC value to a
@@ -679,6 +696,10 @@ struct unit
   /* PC ranges to function.  */
   struct function_addrs *function_addrs;
   size_t function_addrs_count;
+  /* The file names from the line header, for reading the calls
+     inlined into a function when they are first needed.  */
+  const char **filenames;
+  size_t filenames_count;
 };
 
 /* An address range for a compilation unit.  This maps a PC value to a
@@ -728,6 +749,10 @@ struct dwarf_data
   struct unit_addrs *addrs;
   /* Number of address ranges in list.  */
   size_t addrs_count;
+  /* The lowest and one past the highest PC in ADDRS, for a quick
+     check of whether a PC might be in this module.  */
+  uintptr_t low;
+  uintptr_t high;
   /* A sorted list of units.  */
   struct unit **units;
   /* Number of units in the list.  */
@@ -952,6 +977,64 @@ is_highest_address (uint64_t address, int addrsize)
     }
 }
 
+/* Decode a LEB128 number of at most 8 bytes at P, which must have at
+   least 8 bytes available.  Sets *VAL to the value, without sign
+   extension, and returns the number of bytes.  Returns 0 if the
+   number is longer than 8 bytes.  */
+
+static inline size_t
+leb128_fast (const unsigned char *p, uint64_t *val)
+{
+  uint64_t word;
+  uint64_t stop;
+  uint64_t x;
+
+  if (*p < 0x80)
+    {
+      *val = *p;
+      return 1;
+    }
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) \
+    && defined(__ORDER_BIG_ENDIAN__) \
+    && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__ \
+        || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+  memcpy (&word, p, sizeof word);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  word = __builtin_bswap64 (word);
+#endif
+#else
+  word = ((uint64_t) p[0]
+	  | ((uint64_t) p[1] << 8)
+	  | ((uint64_t) p[2] << 16)
+	  | ((uint64_t) p[3] << 24)
+	  | ((uint64_t) p[4] << 32)
+	  | ((uint64_t) p[5] << 40)
+	  | ((uint64_t) p[6] << 48)
+	  | ((uint64_t) p[7] << 56));
+#endif
+
+  /* The high bit of each byte is clear in the last byte.  */
+  stop = ~word & 0x8080808080808080ULL;
+  if (stop == 0)
+    return 0;
+
+  /* Keep the bytes up to the last one, and squeeze out the high bit
+     of each.  */
+  x = word & (stop ^ (stop - 1));
+#if defined (__BMI2__) && defined (__x86_64__)
+  x = _pext_u64 (x, 0x7f7f7f7f7f7f7f7fULL);
+#else
+  x &= 0x7f7f7f7f7f7f7f7fULL;
+  x = ((x & 0x7f007f007f007f00ULL) >> 1) | (x & 0x007f007f007f007fULL);
+  x = ((x & 0x3fff00003fff0000ULL) >> 2) | (x & 0x00003fff00003fffULL);
+  x = ((x & 0x0fffffff00000000ULL) >> 4) | (x & 0x000000000fffffffULL);
+#endif
+  *val = x;
+
+  return (size_t) (__builtin_ctzll (stop) >> 3) + 1;
+}
+
 /* Read an unsigned LEB128 number.  */
 
 static uint64_t
@@ -962,6 +1045,19 @@ read_uleb128 (struct dwarf_buf *buf)
   int overflow;
   unsigned char b;
 
+  if (buf->left >= 8)
+    {
+      size_t len;
+
+      len = leb128_fast (buf->buf, &ret);
+      if (len > 0)
+	{
+	  buf->buf += len;
+	  buf->left -= len;
+	  return ret;
+	}
+    }
+
   ret = 0;
   shift = 0;
   overflow = 0;
@@ -997,6 +1093,22 @@ read_sleb128 (struct dwarf_buf *buf)
   int overflow;
   unsigned char b;
 
+  if (buf->left >= 8)
+    {
+      size_t len;
+
+      len = leb128_fast (buf->buf, &val);
+      if (len > 0)
+	{
+	  buf->buf += len;
+	  buf->left -= len;
+	  shift = (unsigned int) len * 7;
+	  if ((val & ((uint64_t) 1 << (shift - 1))) != 0)
+	    val |= ((uint64_t) -1) << shift;
+	  return (int64_t) val;
+	}
+    }
+
   val = 0;
   shift = 0;
   overflow = 0;
@@ -1362,6 +1474,130 @@ read_attribute (enum dwarf_form form, uint64_t implicit_val,
     }
 }
 
+/* Return the number of bytes that an attribute of form FORM takes in
+   an entry, or -1 if that depends on the value.  */
+
+static int
+attr_form_size (enum dwarf_form form, int is_dwarf64, int version,
+		int addrsize)
+{
+  switch (form)
+    {
+    case DW_FORM_flag_present:
+    case DW_FORM_implicit_const:
+      return 0;
+    case DW_FORM_data1: case DW_FORM_flag: case DW_FORM_ref1:
+    case DW_FORM_strx1: case DW_FORM_addrx1:
+      return 1;
+    case DW_FORM_data2: case DW_FORM_ref2: case DW_FORM_strx2:
+    case DW_FORM_addrx2:
+      return 2;
+    case DW_FORM_strx3: case DW_FORM_addrx3:
+      return 3;
+    case DW_FORM_data4: case DW_FORM_ref4: case DW_FORM_strx4:
+    case DW_FORM_addrx4: case DW_FORM_ref_sup4:
+      return 4;
+    case DW_FORM_data8: case DW_FORM_ref8: case DW_FORM_ref_sig8:
+    case DW_FORM_ref_sup8:
+      return 8;
+    case DW_FORM_data16:
+      return 16;
+    case DW_FORM_strp: case DW_FORM_line_strp: case DW_FORM_sec_offset:
+    case DW_FORM_GNU_ref_alt: case DW_FORM_strp_sup:
+    case DW_FORM_GNU_strp_alt:
+      return is_dwarf64 ? 8 : 4;
+    case DW_FORM_ref_addr:
+      if (version != 2)
+	return is_dwarf64 ? 8 : 4;
+      /* Fall through.  */
+    case DW_FORM_addr:
+      /* Let read_address report an invalid address size.  */
+      if (addrsize == 1 || addrsize == 2 || addrsize == 4 || addrsize == 8)
+	return addrsize;
+      return -1;
+    default:
+      return -1;
+    }
+}
+
+/* Skip the attribute values of an entry with abbrev ABBREV, for an
+   entry that we don't care about.  Unlike read_attribute this doesn't
+   check string offsets, since we don't look at the strings.  Returns
+   1 on success, 0 on failure.  */
+
+static int
+skip_attributes (const struct abbrev *abbrev, struct dwarf_buf *buf,
+		 const struct unit *u,
+		 const struct dwarf_sections *dwarf_sections,
+		 struct dwarf_data *altlink)
+{
+  size_t pending;
+  size_t i;
+
+  if (abbrev->fixed_size != (size_t) -1)
+    return advance (buf, abbrev->fixed_size);
+
+  /* Advance over runs of fixed size attributes at once.  */
+  pending = 0;
+  for (i = 0; i < abbrev->num_attrs; ++i)
+    {
+      const struct attr *attr;
+
+      attr = &abbrev->attrs[i];
+      if (attr->size >= 0)
+	{
+	  pending += (size_t) attr->size;
+	  continue;
+	}
+
+      if (pending > 0)
+	{
+	  if (!advance (buf, pending))
+	    return 0;
+	  pending = 0;
+	}
+
+      switch (attr->form)
+	{
+	case DW_FORM_sdata:
+	  read_sleb128 (buf);
+	  break;
+	case DW_FORM_udata: case DW_FORM_ref_udata:
+	case DW_FORM_strx: case DW_FORM_addrx: case DW_FORM_loclistx:
+	case DW_FORM_rnglistx: case DW_FORM_GNU_addr_index:
+	case DW_FORM_GNU_str_index:
+	  read_uleb128 (buf);
+	  break;
+	case DW_FORM_string:
+	  if (read_string (buf) == NULL)
+	    return 0;
+	  break;
+	case DW_FORM_block: case DW_FORM_exprloc:
+	  if (!advance (buf, read_uleb128 (buf)))
+	    return 0;
+	  break;
+	case DW_FORM_block1:
+	  if (!advance (buf, read_byte (buf)))
+	    return 0;
+	  break;
+	default:
+	  {
+	    struct attr_val val;
+
+	    if (!read_attribute (attr->form, attr->val, buf, u->is_dwarf64,
+				 u->version, u->addrsize, dwarf_sections,
+				 altlink, &val))
+	      return 0;
+	  }
+	  break;
+	}
+    }
+
+  if (pending > 0)
+    return advance (buf, pending);
+  return 1;
+}
+
 /* If we can determine the value of a string attribute, set *STRING to
    point to the string.  Return 1 on success, 0 on error.  If we don't
    know the value, we consider that a success, and we don't change
@@ -1864,14 +2100,16 @@ abbrev_compare (const void *v1, const void *v2)
     }
 }
 
-/* Read the abbreviation table for a compilation unit.  Returns 1 on
-   success, 0 on failure.  */
+/* Read the abbreviation table for a compilation unit.  IS_DWARF64,
+   VERSION and ADDRSIZE describe the unit, and are used to record the
+   size of each attribute.  Returns 1 on success, 0 on failure.  */
 
 static int
 read_abbrevs (struct backtrace_state *state, uint64_t abbrev_offset,
 	      const unsigned char *dwarf_abbrev, size_t dwarf_abbrev_size,
-	      int is_bigendian, backtrace_error_callback error_callback,
-	      void *data, struct abbrevs *abbrevs)
+	      int is_bigendian, int is_dwarf64, int version, int addrsize,
+	      backtrace_error_callback error_callback, void *data,
+	      struct abbrevs *abbrevs)
 {
   struct dwarf_buf abbrev_buf;
   struct dwarf_buf count_buf;
@@ -1967,6 +2205,7 @@ read_abbrevs (struct backtrace_state *state, uint64_t abbrev_offset,
 	    read_sleb128 (&count_buf);
 	}
 
+      a.fixed_size = 0;
       if (num_attrs == 0)
 	{
 	  attrs = NULL;
@@ -1996,6 +2235,13 @@ read_abbrevs (struct backtrace_state *state, uint64_t abbrev_offset,
 		attrs[num_attrs].val = read_sleb128 (&abbrev_buf);
 	      else
 		attrs[num_attrs].val = 0;
+	      attrs[num_attrs].size = attr_form_size ((enum dwarf_form) form,
+						      is_dwarf64, version,
+						      addrsize);
+	      if (attrs[num_attrs].size < 0)
+		a.fixed_size = (size_t) -1;
+	      else if (a.fixed_size != (size_t) -1)
+		a.fixed_size += (size_t) attrs[num_attrs].size;
 	      ++num_attrs;
 	    }
 	}
@@ -2496,6 +2742,23 @@ find_address_ranges (struct backtrace_state *state,
       if (unit_tag != NULL)
 	*unit_tag = abbrev->tag;
 
+      if (abbrev->tag != DW_TAG_compile_unit
+	  && abbrev->tag != DW_TAG_subprogram
+	  && abbrev->tag != DW_TAG_skeleton_unit)
+	{
+	  /* We only look at the attributes of the entries above.  */
+	  if (!skip_attributes (abbrev, unit_buf, u, dwarf_sections, altlink))
+	    return 0;
+	  if (abbrev->has_children)
+	    {
+	      if (!find_address_ranges (state, base_address, unit_buf,
+					dwarf_sections, is_bigendian, altlink,
+					error_callback, data, u, addrs, NULL))
+		return 0;
+	    }
+	  continue;
+	}
+
       memset (&pcrange, 0, sizeof pcrange);
       memset (&name_val, 0, sizeof name_val);
       have_name_val = 0;
@@ -2723,15 +2986,17 @@ build_address_map (struct backtrace_state *state,
 
       memset (&u->abbrevs, 0, sizeof u->abbrevs);
       abbrev_offset = read_offset (&unit_buf, is_dwarf64);
+
+      if (version < 5)
+	addrsize = read_byte (&unit_buf);
+
       if (!read_abbrevs (state, abbrev_offset,
 			 dwarf_sections->data[DEBUG_ABBREV],
 			 dwarf_sections->size[DEBUG_ABBREV],
-			 is_bigendian, error_callback, data, &u->abbrevs))
+			 is_bigendian, is_dwarf64, version, addrsize,
+			 error_callback, data, &u->abbrevs))
 	goto fail;
 
-      if (version < 5)
-	addrsize = read_byte (&unit_buf);
-
       switch (unit_type)
 	{
 	case 0:
@@ -2767,6 +3032,8 @@ build_address_map (struct backtrace_state *state,
       u->lines_count = 0;
       u->function_addrs = NULL;
       u->function_addrs_count = 0;
+      u->filenames = NULL;
+      u->filenames_count = 0;
 
       if (!find_address_ranges (state, base_address, &unit_buf, dwarf_sections,
 				is_bigendian, altlink, error_callback, data,
@@ -2833,11 +3100,22 @@ add_line (struct backtrace_state *state, struct dwarf_data *ddata,
 	return 1;
     }
 
-  ln = ((struct line *)
-	backtrace_vector_grow (state, sizeof (struct line), error_callback,
-			       data, &vec->vec));
-  if (ln == NULL)
-    return 0;
+  /* Use space reserved by read_line_program if there is any, to
+     avoid a call per line.  */
+  if (vec->vec.alc >= sizeof (struct line))
+    {
+      ln = (struct line *) ((char *) vec->vec.base + vec->vec.size);
+      vec->vec.size += sizeof (struct line);
+      vec->vec.alc -= sizeof (struct line);
+    }
+  else
+    {
+      ln = ((struct line *)
+	    backtrace_vector_grow (state, sizeof (struct line),
+				   error_callback, data, &vec->vec));
+      if (ln == NULL)
+	return 0;
+    }
 
   /* Add in the base address here, so that we can look up the PC
      directly.  */
@@ -3250,6 +3528,11 @@ read_line_header (struct backtrace_state *state, struct dwarf_data *ddata,
   return 1;
 }
 
+/* The most lines that read_line_program reserves space for at once.
+   This bounds the up front allocation for a very large unit.  */
+
+#define LINE_RESERVE_MAX (64 * 1024)
+
 /* Read the line program, adding line mappings to VEC.  Return 1 on
    success, 0 on failure.  */
 
@@ -3263,6 +3546,43 @@ read_line_program (struct backtrace_state *state, struct dwarf_data *ddata,
   const char *reset_filename;
   const char *filename;
   int lineno;
+  int use_special;
+  struct
+  {
+    unsigned int address;
+    int line;
+  } special[256];
+  size_t reserve;
+
+  /* In the usual case of one operation per instruction, precompute
+     the address and line advance of each special opcode.  */
+  use_special = hdr->max_ops_per_insn == 1 && hdr->line_range != 0;
+  if (use_special)
+    {
+      unsigned int op;
+
+      for (op = hdr->opcode_base; op < 256; ++op)
+	{
+	  unsigned int adj;
+
+	  adj = op - hdr->opcode_base;
+	  special[op].address = hdr->min_insn_len * (adj / hdr->line_range);
+	  special[op].line = hdr->line_base + (int) (adj % hdr->line_range);
+	}
+    }
+
+  /* Typical line programs use a few bytes per line.  Reserve space
+     for lines in advance, so that the vector isn't repeatedly grown
+     and copied.  The reservation is capped, and past it add_line
+     falls back to growing the vector.  Any space left over is
+     released by the caller.  */
+  reserve = line_buf->left / 4;
+  if (reserve > LINE_RESERVE_MAX)
+    reserve = LINE_RESERVE_MAX;
+  reserve *= sizeof (struct line);
+  if (!backtrace_vector_reserve (state, reserve, line_buf->error_callback,
+				 line_buf->data, &vec->vec))
+    return 0;
 
   address = 0;
   op_index = 0;
@@ -3282,12 +3602,20 @@ read_line_program (struct backtrace_state *state, struct dwarf_data *ddata,
 	  unsigned int advance;
 
 	  /* Special opcode.  */
-	  op -= hdr->opcode_base;
-	  advance = op / hdr->line_range;
-	  address += (hdr->min_insn_len * (op_index + advance)
-		      / hdr->max_ops_per_insn);
-	  op_index = (op_index + advance) % hdr->max_ops_per_insn;
-	  lineno += hdr->line_base + (int) (op % hdr->line_range);
+	  if (use_special)
+	    {
+	      address += special[op].address;
+	      lineno += special[op].line;
+	    }
+	  else
+	    {
+	      op -= hdr->opcode_base;
+	      advance = op / hdr->line_range;
+	      address += (hdr->min_insn_len * (op_index + advance)
+			  / hdr->max_ops_per_insn);
+	      op_index = (op_index + advance) % hdr->max_ops_per_insn;
+	      lineno += hdr->line_base + (int) (op % hdr->line_range);
+	    }
 	  add_line (state, ddata, address, filename, lineno,
 		    line_buf->error_callback, line_buf->data, vec);
 	}
@@ -3747,8 +4075,51 @@ add_function_range (struct backtrace_state *state, void *rdata,
   return 1;
 }
 
+/* Add a trailing entry to FVEC, which holds the calls inlined into a
+   function, and sort it.  Sets *PADDRS and *PCOUNT.  Returns 1 on
+   success, 0 on error.  */
+
+static int
+finish_inlined_functions (struct backtrace_state *state,
+			  struct function_vector *fvec,
+			  backtrace_error_callback error_callback, void *data,
+			  struct function_addrs **paddrs, size_t *pcount)
+{
+  struct function_addrs *p;
+  struct function_addrs *faddrs;
+
+  if (fvec->count == 0)
+    return 1;
+
+  /* Allocate a trailing entry, but don't include it in fvec->count.  */
+  p = ((struct function_addrs *)
+       backtrace_vector_grow (state, sizeof (struct function_addrs),
+			      error_callback, data, &fvec->vec));
+  if (p == NULL)
+    return 0;
+  p->low = 0;
+  --p->low;
+  p->high = p->low;
+  p->function = NULL;
+
+  if (!backtrace_vector_release (state, &fvec->vec, error_callback, data))
+    return 0;
+
+  faddrs = (struct function_addrs *) fvec->vec.base;
+  backtrace_qsort (faddrs, fvec->count, sizeof (struct function_addrs),
+		   function_addrs_compare);
+
+  *paddrs = faddrs;
+  *pcount = fvec->count;
+  return 1;
+}
+
 /* Read one entry plus all its children.  Add function addresses to
-   VEC.  Returns 1 on success, 0 on error.  */
+   VEC_FUNCTION and inlined call addresses to VEC_INLINED.  If
+   VEC_INLINED is NULL, the inlined calls are skipped, and each
+   function records where to find them for read_inlined_functions.  If
+   VEC_FUNCTION is NULL, nested functions are skipped along with the
+   calls inlined into them.  Returns 1 on success, 0 on error.  */
 
 static int
 read_function_entry (struct backtrace_state *state, struct dwarf_data *ddata,
@@ -3785,6 +4156,8 @@ read_function_entry (struct backtrace_state *state, struct dwarf_data *ddata,
 	vec = vec_inlined;
       else
 	vec = vec_function;
+      if (vec == NULL)
+	is_function = 0;
 
       function = NULL;
       if (is_function)
@@ -3797,6 +4170,34 @@ read_function_entry (struct backtrace_state *state, struct dwarf_data *ddata,
 	  memset (function, 0, sizeof *function);
 	}
 
+      if (!is_function
+	  && abbrev->tag != DW_TAG_compile_unit
+	  && abbrev->tag != DW_TAG_skeleton_unit)
+	{
+	  /* Nothing in this entry is of interest, but its children may
+	     be.  */
+	  if (!skip_attributes (abbrev, unit_buf, u, &ddata->dwarf_sections,
+				ddata->altlink))
+	    return 0;
+	  if (abbrev->has_children)
+	    {
+	      struct function_vector *child_inlined;
+
+	      /* The calls inlined into a skipped function are not
+		 wanted either.  */
+	      child_inlined = vec_inlined;
+	      if (vec_function == NULL
+		  && (abbrev->tag == DW_TAG_subprogram
+		      || abbrev->tag == DW_TAG_entry_point))
+		child_inlined = NULL;
+	      if (!read_function_entry (state, ddata, u, base, unit_buf, lhdr,
+					error_callback, data, vec_function,
+					child_inlined))
+		return 0;
+	    }
+	  continue;
+	}
+
       memset (&pcrange, 0, sizeof pcrange);
       have_linkage_name = 0;
       for (i = 0; i < abbrev->num_attrs; ++i)
@@ -3948,6 +4349,17 @@ read_function_entry (struct backtrace_state *state, struct dwarf_data *ddata,
 					vec_inlined))
 		return 0;
 	    }
+	  else if (vec_inlined == NULL)
+	    {
+	      /* Leave the inlined calls until a PC in this function is
+		 looked up, but look for nested functions now.  */
+	      function->inlined_data = unit_buf->buf;
+	      function->inlined_base = base;
+	      if (!read_function_entry (state, ddata, u, base, unit_buf, lhdr,
+					error_callback, data, vec_function,
+					NULL))
+		return 0;
+	    }
 	  else
 	    {
 	      struct function_vector fvec;
@@ -3962,37 +4374,10 @@ read_function_entry (struct backtrace_state *state, struct dwarf_data *ddata,
 					&fvec))
 		return 0;
 
-	      if (fvec.count > 0)
-		{
-		  struct function_addrs *p;
-		  struct function_addrs *faddrs;
-
-		  /* Allocate a trailing entry, but don't include it
-		     in fvec.count.  */
-		  p = ((struct function_addrs *)
-		       backtrace_vector_grow (state,
-					      sizeof (struct function_addrs),
-					      error_callback, data,
-					      &fvec.vec));
-		  if (p == NULL)
-		    return 0;
-		  p->low = 0;
-		  --p->low;
-		  p->high = p->low;
-		  p->function = NULL;
-
-		  if (!backtrace_vector_release (state, &fvec.vec,
-						 error_callback, data))
-		    return 0;
-
-		  faddrs = (struct function_addrs *) fvec.vec.base;
-		  backtrace_qsort (faddrs, fvec.count,
-				   sizeof (struct function_addrs),
-				   function_addrs_compare);
-
-		  function->function_addrs = faddrs;
-		  function->function_addrs_count = fvec.count;
-		}
+	      if (!finish_inlined_functions (state, &fvec, error_callback,
+					     data, &function->function_addrs,
+					     &function->function_addrs_count))
+		return 0;
 	    }
 	}
     }
@@ -4001,7 +4386,8 @@ read_function_entry (struct backtrace_state *state, struct dwarf_data *ddata,
 }
 
 /* Read function name information for a compilation unit.  We look
-   through the whole unit looking for function tags.  */
+   through the whole unit looking for function tags.  The calls
+   inlined into each function are left for read_inlined_functions.  */
 
 static void
 read_function_info (struct backtrace_state *state, struct dwarf_data *ddata,
@@ -4039,7 +4425,7 @@ read_function_info (struct backtrace_state *state, struct dwarf_data *ddata,
   while (unit_buf.left > 0)
     {
       if (!read_function_entry (state, ddata, u, 0, &unit_buf, lhdr,
-				error_callback, data, pfvec, pfvec))
+				error_callback, data, pfvec, NULL))
 	return;
     }
 
@@ -4085,6 +4471,77 @@ read_function_info (struct backtrace_state *state, struct dwarf_data *ddata,
   *ret_addrs_count = addrs_count;
 }
 
+/* Read the calls inlined into FUNCTION, a function in unit U, if
+   read_function_info left them unread.  When running in threaded
+   mode another thread may be doing the same thing; the loser's copy
+   is leaked.  */
+
+static void
+read_inlined_functions (struct backtrace_state *state,
+			struct dwarf_data *ddata, struct unit *u,
+			struct function *function,
+			backtrace_error_callback error_callback, void *data)
+{
+  const unsigned char *inlined_data;
+  struct line_header lhdr;
+  struct dwarf_buf unit_buf;
+  struct function_vector fvec;
+  struct function_addrs *addrs;
+  size_t addrs_count;
+
+  if (!state->threaded)
+    inlined_data = function->inlined_data;
+  else
+    inlined_data = ((const unsigned char *)
+		    backtrace_atomic_load_pointer (&function->inlined_data));
+  if (inlined_data == NULL)
+    return;
+
+  /* read_function_entry only uses the file names from the line
+     header.  */
+  memset (&lhdr, 0, sizeof lhdr);
+  lhdr.filenames = u->filenames;
+  lhdr.filenames_count = u->filenames_count;
+
+  unit_buf.name = ".debug_info";
+  unit_buf.start = ddata->dwarf_sections.data[DEBUG_INFO];
+  unit_buf.buf = inlined_data;
+  unit_buf.left = u->unit_data_len - (size_t) (inlined_data - u->unit_data);
+  unit_buf.is_bigendian = ddata->is_bigendian;
+  unit_buf.error_callback = error_callback;
+  unit_buf.data = data;
+  unit_buf.reported_underflow = 0;
+
+  memset (&fvec, 0, sizeof fvec);
+  addrs = NULL;
+  addrs_count = 0;
+  if (!read_function_entry (state, ddata, u, function->inlined_base,
+			    &unit_buf, &lhdr, error_callback, data, NULL,
+			    &fvec)
+      || !finish_inlined_functions (state, &fvec, error_callback, data,
+				    &addrs, &addrs_count))
+    {
+      /* Don't try again; report the function without its inlined
+	 calls.  */
+      addrs = NULL;
+      addrs_count = 0;
+    }
+
+  if (!state->threaded)
+    {
+      function->function_addrs = addrs;
+      function->function_addrs_count = addrs_count;
+      function->inlined_data = NULL;
+    }
+  else
+    {
+      backtrace_atomic_store_pointer (&function->function_addrs, addrs);
+      backtrace_atomic_store_size_t (&function->function_addrs_count,
+				     addrs_count);
+      backtrace_atomic_store_pointer (&function->inlined_data, NULL);
+    }
+}
+
 /* See if PC is inlined in FUNCTION.  If it is, print out the inlined
    information, and update FILENAME and LINENO for the caller.
    Returns whatever CALLBACK returns, or 0 to keep going.  */
@@ -4162,6 +4619,87 @@ report_inlined_functions (uintptr_t pc, struct function *function,
   return 0;
 }
 
+/* We need the lines, lines_count, function_addrs,
+   function_addrs_count fields of U.  Read them and set them in U, and
+   return the lines.  The lines are (struct line *) -1 if the unit has
+   no useful line number information.  When running in threaded mode,
+   we need to allow for the possibility that some other thread is
+   setting them simultaneously.  */
+
+static struct line *
+dwarf_read_unit (struct backtrace_state *state, struct dwarf_data *ddata,
+		 struct unit *u, backtrace_error_callback error_callback,
+		 void *data)
+{
+  struct function_addrs *function_addrs;
+  size_t function_addrs_count;
+  struct line_header lhdr;
+  const char **filenames;
+  size_t filenames_count;
+  struct line *lines;
+  size_t count;
+
+  /* We have never read the line information for this unit.  Read it
+     now.  */
+
+  function_addrs = NULL;
+  function_addrs_count = 0;
+  filenames = NULL;
+  filenames_count = 0;
+  if (read_line_info (state, ddata, error_callback, data, u, &lhdr,
+		      &lines, &count))
+    {
+      struct function_vector *pfvec;
+
+      /* If not threaded, reuse DDATA->FVEC for better memory
+	 consumption.  */
+      if (state->threaded)
+	pfvec = NULL;
+      else
+	pfvec = &ddata->fvec;
+      read_function_info (state, ddata, &lhdr, error_callback, data,
+			  u, pfvec, &function_addrs,
+			  &function_addrs_count);
+
+      /* Keep the file names for read_inlined_functions.  */
+      filenames = lhdr.filenames;
+      filenames_count = lhdr.filenames_count;
+      if (lhdr.dirs_count != 0)
+	backtrace_free (state, lhdr.dirs,
+			lhdr.dirs_count * sizeof (const char *),
+			error_callback, data);
+    }
+
+  /* Atomically store the information we just read into the unit.  If
+     another thread is simultaneously writing, it presumably read the
+     same information, and we don't care which one we wind up with; we
+     just leak the other one.  We do have to write the lines field
+     last, so that the acquire-loads in dwarf_lookup_pc ensure that
+     the other fields are set.  */
+
+  if (!state->threaded)
+    {
+      u->lines_count = count;
+      u->function_addrs = function_addrs;
+      u->function_addrs_count = function_addrs_count;
+      u->filenames = filenames;
+      u->filenames_count = filenames_count;
+      u->lines = lines;
+    }
+  else
+    {
+      backtrace_atomic_store_size_t (&u->lines_count, count);
+      backtrace_atomic_store_pointer (&u->function_addrs, function_addrs);
+      backtrace_atomic_store_size_t (&u->function_addrs_count,
+				     function_addrs_count);
+      backtrace_atomic_store_pointer (&u->filenames, filenames);
+      backtrace_atomic_store_size_t (&u->filenames_count, filenames_count);
+      backtrace_atomic_store_pointer (&u->lines, lines);
+    }
+
+  return lines;
+}
+
 /* Look for a PC in the DWARF mapping for one module.  On success,
    call CALLBACK and return whatever it returns.  On error, call
    ERROR_CALLBACK and return 0.  Sets *FOUND to 1 if the PC is found,
@@ -4230,10 +4768,8 @@ dwarf_lookup_pc (struct backtrace_state *state, struct dwarf_data *ddata,
     }
 
   /* We need the lines, lines_count, function_addrs,
-     function_addrs_count fields of u.  If they are not set, we need
-     to set them.  When running in threaded mode, we need to allow for
-     the possibility that some other thread is setting them
-     simultaneously.  */
+     function_addrs_count fields of u.  If they are not set,
+     dwarf_read_unit sets them.  */
 
   u = entry->u;
   lines = u->lines;
@@ -4263,56 +4799,8 @@ dwarf_lookup_pc (struct backtrace_state *state, struct dwarf_data *ddata,
   new_data = 0;
   if (lines == NULL)
     {
-      struct function_addrs *function_addrs;
-      size_t function_addrs_count;
-      struct line_header lhdr;
-      size_t count;
-
-      /* We have never read the line information for this unit.  Read
-	 it now.  */
-
-      function_addrs = NULL;
-      function_addrs_count = 0;
-      if (read_line_info (state, ddata, error_callback, data, entry->u, &lhdr,
-			  &lines, &count))
-	{
-	  struct function_vector *pfvec;
-
-	  /* If not threaded, reuse DDATA->FVEC for better memory
-	     consumption.  */
-	  if (state->threaded)
-	    pfvec = NULL;
-	  else
-	    pfvec = &ddata->fvec;
-	  read_function_info (state, ddata, &lhdr, error_callback, data,
-			      entry->u, pfvec, &function_addrs,
-			      &function_addrs_count);
-	  free_line_header (state, &lhdr, error_callback, data);
-	  new_data = 1;
-	}
-
-      /* Atomically store the information we just read into the unit.
-	 If another thread is simultaneously writing, it presumably
-	 read the same information, and we don't care which one we
-	 wind up with; we just leak the other one.  We do have to
-	 write the lines field last, so that the acquire-loads above
-	 ensure that the other fields are set.  */
-
-      if (!state->threaded)
-	{
-	  u->lines_count = count;
-	  u->function_addrs = function_addrs;
-	  u->function_addrs_count = function_addrs_count;
-	  u->lines = lines;
-	}
-      else
-	{
-	  backtrace_atomic_store_size_t (&u->lines_count, count);
-	  backtrace_atomic_store_pointer (&u->function_addrs, function_addrs);
-	  backtrace_atomic_store_size_t (&u->function_addrs_count,
-					 function_addrs_count);
-	  backtrace_atomic_store_pointer (&u->lines, lines);
-	}
+      lines = dwarf_read_unit (state, ddata, u, error_callback, data);
+      new_data = lines != (struct line *) (uintptr_t) -1;
     }
 
   /* Now all fields of U have been initialized.  */
@@ -4413,6 +4901,8 @@ dwarf_lookup_pc (struct backtrace_state *state, struct dwarf_data *ddata,
     return callback (data, pc, ln->filename, ln->lineno, NULL);
 
   function = fmatch->function;
+  read_inlined_functions (state, ddata, entry->u, function, error_callback,
+			  data);
 
   filename = ln->filename;
   lineno = ln->lineno;
@@ -4475,6 +4965,93 @@ dwarf_fileline (struct backtrace_state *state, uintptr_t pc,
   return callback (data, pc, NULL, 0, NULL);
 }
 
+/* Return the DWARF data for the first module after AFTER, or the
+   first module at all if AFTER is NULL, whose address ranges span PC,
+   or NULL if there is none.  This only looks at the overall range of
+   each module, so it is much cheaper than a lookup; a module whose
+   range does not span PC can't have any information about it.  */
+
+struct dwarf_data *
+backtrace_dwarf_find (struct backtrace_state *state, struct dwarf_data *after,
+		      uintptr_t pc)
+{
+  struct dwarf_data *ddata;
+
+  for (ddata = backtrace_dwarf_next (state, after);
+       ddata != NULL;
+       ddata = backtrace_dwarf_next (state, ddata))
+    if (pc >= ddata->low && pc < ddata->high)
+      return ddata;
+  return NULL;
+}
+
+/* Look up PC in the DWARF data for a single module, as returned by
+   backtrace_dwarf_find.  */
+
+int
+backtrace_dwarf_lookup (struct backtrace_state *state,
+			struct dwarf_data *ddata, uintptr_t pc,
+			backtrace_full_callback callback,
+			backtrace_error_callback error_callback, void *data,
+			int *found)
+{
+  return dwarf_lookup_pc (state, ddata, pc, callback, error_callback, data,
+			  found);
+}
+
+/* Read the line and function information, including inlined calls,
+   for every unit of every module, which dwarf_lookup_pc would
+   otherwise read the first time it needs it.  Errors are reported to
+   ERROR_CALLBACK, and leave the unit marked as having no line
+   information, as they would in dwarf_lookup_pc.  */
+
+void
+backtrace_dwarf_read_all (struct backtrace_state *state,
+			  backtrace_error_callback error_callback,
+			  void *data)
+{
+  struct dwarf_data **pp;
+
+  if (state->fileline_fn != dwarf_fileline)
+    return;
+
+  pp = (struct dwarf_data **) (void *) &state->fileline_data;
+  while (1)
+    {
+      struct dwarf_data *ddata;
+      size_t i;
+
+      if (!state->threaded)
+	ddata = *pp;
+      else
+	ddata = backtrace_atomic_load_pointer (pp);
+      if (ddata == NULL)
+	break;
+
+      for (i = 0; i < ddata->units_count; ++i)
+	{
+	  struct unit *u;
+	  struct line *lines;
+	  size_t j;
+
+	  u = ddata->units[i];
+	  if (!state->threaded)
+	    lines = u->lines;
+	  else
+	    lines = backtrace_atomic_load_pointer (&u->lines);
+	  if (lines == NULL)
+	    dwarf_read_unit (state, ddata, u, error_callback, data);
+
+	  for (j = 0; j < u->function_addrs_count; ++j)
+	    read_inlined_functions (state, ddata, u,
+				    u->function_addrs[j].function,
+				    error_callback, data);
+	}
+
+      pp = &ddata->next;
+    }
+}
+
 /* Initialize our data structures from the DWARF debug info for a
    file.  Return NULL on failure.  */
 
@@ -4490,6 +5067,8 @@ build_dwarf_data (struct backtrace_state *state,
   struct unit_addrs_vector addrs_vec;
   struct unit_vector units_vec;
   struct dwarf_data *fdata;
+  struct unit_addrs *addrs;
+  size_t i;
 
   if (!build_address_map (state, base_address, dwarf_sections, is_bigendian,
 			  altlink, error_callback, data, &addrs_vec,
@@ -4517,8 +5096,14 @@ build_dwarf_data (struct backtrace_state *state,
   fdata->next = NULL;
   fdata->altlink = altlink;
   fdata->base_address = base_address;
-  fdata->addrs = (struct unit_addrs *) addrs_vec.vec.base;
+  addrs = (struct unit_addrs *) addrs_vec.vec.base;
+  fdata->addrs = addrs;
   fdata->addrs_count = addrs_vec.count;
+  fdata->low = addrs_vec.count > 0 ? addrs[0].low : 0;
+  fdata->high = 0;
+  for (i = 0; i < addrs_vec.count; ++i)
+    if (addrs[i].high > fdata->high)
+      fdata->high = addrs[i].high;
   fdata->units = (struct unit **) units_vec.vec.base;
   fdata->units_count = units_vec.count;
   fdata->dwarf_sections = *dwarf_sections;
@@ -4528,30 +5113,11 @@ build_dwarf_data (struct backtrace_state *state,
   return fdata;
 }
 
-/* Build our data structures from the DWARF sections for a module.
-   Set FILELINE_FN and STATE->FILELINE_DATA.  Return 1 on success, 0
-   on failure.  */
+/* Add FDATA to the end of the list in STATE.  */
 
-int
-backtrace_dwarf_add (struct backtrace_state *state,
-		     struct libbacktrace_base_address base_address,
-		     const struct dwarf_sections *dwarf_sections,
-		     int is_bigendian,
-		     struct dwarf_data *fileline_altlink,
-		     backtrace_error_callback error_callback,
-		     void *data, fileline *fileline_fn,
-		     struct dwarf_data **fileline_entry)
+static void
+dwarf_add_data (struct backtrace_state *state, struct dwarf_data *fdata)
 {
-  struct dwarf_data *fdata;
-
-  fdata = build_dwarf_data (state, base_address, dwarf_sections, is_bigendian,
-			    fileline_altlink, error_callback, data);
-  if (fdata == NULL)
-    return 0;
-
-  if (fileline_entry != NULL)
-    *fileline_entry = fdata;
-
   if (!state->threaded)
     {
       struct dwarf_data **pp;
@@ -4586,6 +5152,80 @@ backtrace_dwarf_add (struct backtrace_state *state,
 	    break;
 	}
     }
+}
+
+/* Build our data structures from the DWARF sections for a module.
+   Set FILELINE_FN and STATE->FILELINE_DATA.  Return 1 on success, 0
+   on failure.  */
+
+int
+backtrace_dwarf_add (struct backtrace_state *state,
+		     struct libbacktrace_base_address base_address,
+		     const struct dwarf_sections *dwarf_sections,
+		     int is_bigendian,
+		     struct dwarf_data *fileline_altlink,
+		     backtrace_error_callback error_callback,
+		     void *data, fileline *fileline_fn,
+		     struct dwarf_data **fileline_entry)
+{
+  struct dwarf_data *fdata;
+
+  fdata = build_dwarf_data (state, base_address, dwarf_sections, is_bigendian,
+			    fileline_altlink, error_callback, data);
+  if (fdata == NULL)
+    return 0;
+
+  if (fileline_entry != NULL)
+    *fileline_entry = fdata;
+
+  dwarf_add_data (state, fdata);
+
+  *fileline_fn = dwarf_fileline;
+
+  return 1;
+}
+
+/* Return the DWARF data after DDATA in the list in STATE, or the first
+   one if DDATA is NULL.  */
+
+struct dwarf_data *
+backtrace_dwarf_next (struct backtrace_state *state, struct dwarf_data *ddata)
+{
+  struct dwarf_data **pp;
+
+  if (ddata == NULL)
+    pp = (struct dwarf_data **) (void *) &state->fileline_data;
+  else
+    pp = &ddata->next;
+  if (!state->threaded)
+    return *pp;
+  return backtrace_atomic_load_pointer (pp);
+}
+
+/* Add to STATE the DWARF data DDATA that was read for another state.
+   The units, and so the line and function information read on demand,
+   are shared; only the list entry is copied.  Both states must be
+   threaded, as the units may be read by either.  */
+
+int
+backtrace_dwarf_share (struct backtrace_state *state,
+		       const struct dwarf_data *ddata,
+		       backtrace_error_callback error_callback, void *data,
+		       fileline *fileline_fn)
+{
+  struct dwarf_data *fdata;
+
+  fdata = ((struct dwarf_data *)
+	   backtrace_alloc (state, sizeof (struct dwarf_data),
+			    error_callback, data));
+  if (fdata == NULL)
+    return 0;
+
+  *fdata = *ddata;
+  fdata->next = NULL;
+  memset (&fdata->fvec, 0, sizeof fdata->fvec);
+
+  dwarf_add_data (state, fdata);
 
   *fileline_fn = dwarf_fileline;
 
@@ -0,0 +1,1324 @@
+/* ehframe.c -- Unwind the stack using .eh_frame_hdr and .eh_frame.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    (1) Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    (2) Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in
+    the documentation and/or other materials provided with the
+    distribution.
+
+    (3) The name of the author may not be used to
+    endorse or promote products derived from this software without
+    specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.  */
+
+
+#include "config.h"
+
+#include <string.h>
+#include <sys/types.h>
+
+#include "backtrace.h"
+#include "internal.h"
+
+#if BACKTRACE_EH_FRAME_UNWIND
+#include <link.h>
+#include <signal.h>
+#include <stddef.h>
+#include <ucontext.h>
+#endif
+
+/* This is a small unwinder for the common case of code compiled by
+   GCC or clang: it reads the .eh_frame_hdr search table and the
+   .eh_frame CFI of each module that is loaded in memory, and tracks
+   only the stack pointer, the frame pointer and the return address.
+   Anything that it does not understand, such as DWARF expressions,
+   makes the caller fall back to the unwind library.  Stepping a frame
+   is async-signal-safe: it only reads memory and never allocates.
+   Decoded unwind rules are cached in a fixed size table, indexed by
+   PC, that is shared by all threads without locking.
+
+   The list of modules is read with dl_iterate_phdr, and read again
+   by backtrace_eh_frame_sync, if the counts of modules loaded and
+   unloaded that dl_iterate_phdr reports have changed.  That is only
+   done outside of stack walks, which must not take the loader's
+   lock: by backtrace_update_modules, and by the sampler and
+   backtrace_dump_threads before they send signals.  Each new
+   list gets a new generation number, and cached rules from an older
+   generation are ignored, so rules for code that has been unloaded
+   are never used.  */
+
+#if BACKTRACE_EH_FRAME_UNWIND
+
+/* DWARF register numbers.  */
+
+#define EH_REG_FP 6
+#define EH_REG_SP 7
+#define EH_REG_RA 16
+
+/* Pointer encodings used in .eh_frame and .eh_frame_hdr.  */
+
+#define DW_EH_PE_absptr		0x00
+#define DW_EH_PE_uleb128	0x01
+#define DW_EH_PE_udata2		0x02
+#define DW_EH_PE_udata4		0x03
+#define DW_EH_PE_udata8		0x04
+#define DW_EH_PE_sleb128	0x09
+#define DW_EH_PE_sdata2		0x0a
+#define DW_EH_PE_sdata4		0x0b
+#define DW_EH_PE_sdata8		0x0c
+#define DW_EH_PE_pcrel		0x10
+#define DW_EH_PE_datarel	0x30
+#define DW_EH_PE_indirect	0x80
+#define DW_EH_PE_omit		0xff
+
+/* Call frame instructions.  */
+
+enum dwarf_cfa
+{
+  DW_CFA_nop = 0x00,
+  DW_CFA_set_loc = 0x01,
+  DW_CFA_advance_loc1 = 0x02,
+  DW_CFA_advance_loc2 = 0x03,
+  DW_CFA_advance_loc4 = 0x04,
+  DW_CFA_offset_extended = 0x05,
+  DW_CFA_restore_extended = 0x06,
+  DW_CFA_undefined = 0x07,
+  DW_CFA_same_value = 0x08,
+  DW_CFA_register = 0x09,
+  DW_CFA_remember_state = 0x0a,
+  DW_CFA_restore_state = 0x0b,
+  DW_CFA_def_cfa = 0x0c,
+  DW_CFA_def_cfa_register = 0x0d,
+  DW_CFA_def_cfa_offset = 0x0e,
+  DW_CFA_def_cfa_expression = 0x0f,
+  DW_CFA_expression = 0x10,
+  DW_CFA_offset_extended_sf = 0x11,
+  DW_CFA_def_cfa_sf = 0x12,
+  DW_CFA_def_cfa_offset_sf = 0x13,
+  DW_CFA_val_offset = 0x14,
+  DW_CFA_val_offset_sf = 0x15,
+  DW_CFA_val_expression = 0x16,
+  DW_CFA_GNU_args_size = 0x2e,
+  DW_CFA_GNU_negative_offset_extended = 0x2f,
+
+  DW_CFA_advance_loc = 0x40,
+  DW_CFA_offset = 0x80,
+  DW_CFA_restore = 0xc0
+};
+
+/* How to recover a register in the caller.  */
+
+enum eh_reg_rule
+{
+  /* The register has the same value in the caller.  */
+  EH_RULE_SAME,
+  /* The register is saved at CFA + offset.  */
+  EH_RULE_OFFSET,
+  /* The register can not be recovered; for the return address this
+     marks the outermost frame.  */
+  EH_RULE_UNDEFINED
+};
+
+/* The unwind rule for a single PC.  */
+
+struct eh_rule
+{
+  /* Non-zero for a signal frame, in which case the caller's registers
+     are found in the ucontext on the stack and the other fields are
+     not used.  */
+  int signal_frame;
+  /* The register used to compute the CFA: EH_REG_SP or EH_REG_FP.  */
+  int cfa_reg;
+  /* The offset from CFA_REG to the CFA.  */
+  int64_t cfa_off;
+  /* How to recover the frame pointer.  */
+  enum eh_reg_rule fp_rule;
+  int64_t fp_off;
+  /* How to recover the return address.  */
+  enum eh_reg_rule ra_rule;
+  int64_t ra_off;
+};
+
+/* A module registered by backtrace_register_eh_frame.  */
+
+struct backtrace_eh_module
+{
+  /* Next module on the list.  */
+  struct backtrace_eh_module *next;
+  /* The range of executable addresses in the module.  */
+  uintptr_t low;
+  uintptr_t high;
+  /* The .eh_frame_hdr section, in memory.  */
+  const unsigned char *hdr;
+  /* The binary search table, pairs of 32-bit offsets from HDR.  */
+  const int32_t *table;
+  /* The number of entries in TABLE.  */
+  size_t count;
+};
+
+/* The number of entries in the rule cache.  This must be a power of
+   two.  */
+
+#define EH_CACHE_SIZE 4096
+
+/* The number of slots that we probe when looking for a PC.  */
+
+#define EH_CACHE_PROBES 8
+
+/* An entry in the rule cache.  An entry may be replaced at any time,
+   so it is protected by a sequence count: a writer claims the entry
+   by making SEQ odd with a compare and swap, and makes it even again
+   when it is done.  A reader checks that SEQ is even and unchanged
+   after reading the other fields.  */
+
+struct eh_cache_entry
+{
+  /* The sequence count.  */
+  unsigned int seq;
+  /* The generation of the module list that RULE was computed
+     from.  */
+  unsigned int gen;
+  /* The PC, and the packed rule for it.  */
+  uintptr_t pc;
+  uint64_t rule;
+};
+
+struct backtrace_eh_cache
+{
+  /* The generation of the current module list.  This starts at 1,
+     so an entry that was never written matches no generation.  */
+  unsigned int gen;
+  /* Non-zero if ADDS and SUBS are known.  */
+  int counts_valid;
+  /* The counts of modules loaded and unloaded that dl_iterate_phdr
+     reported when the module list was read.  */
+  unsigned long long adds;
+  unsigned long long subs;
+  struct eh_cache_entry entries[EH_CACHE_SIZE];
+};
+
+/* Bits in a packed rule.  A packed rule is never zero.  */
+
+#define EH_PACK_VALID		0x1
+#define EH_PACK_SIGNAL		0x2
+#define EH_PACK_CFA_FP		0x4
+#define EH_PACK_FP_SHIFT	4
+#define EH_PACK_RA_SHIFT	6
+#define EH_PACK_FP_OFF_SHIFT	8
+#define EH_PACK_RA_OFF_SHIFT	20
+#define EH_PACK_CFA_OFF_SHIFT	32
+
+/* Pack RULE into a single word.  Returns 0 if it can't be
+   represented.  The register save offsets are stored as 12-bit
+   signed multiples of 8, which covers every frame that GCC lays
+   out.  */
+
+static uint64_t
+eh_pack_rule (const struct eh_rule *rule)
+{
+  uint64_t ret;
+
+  if (rule->signal_frame)
+    return EH_PACK_VALID | EH_PACK_SIGNAL;
+
+  if (rule->cfa_off < INT32_MIN || rule->cfa_off > INT32_MAX)
+    return 0;
+  if ((rule->fp_off & 7) != 0
+      || rule->fp_off < -(2048 * 8)
+      || rule->fp_off > 2047 * 8)
+    return 0;
+  if ((rule->ra_off & 7) != 0
+      || rule->ra_off < -(2048 * 8)
+      || rule->ra_off > 2047 * 8)
+    return 0;
+
+  ret = EH_PACK_VALID;
+  if (rule->cfa_reg == EH_REG_FP)
+    ret |= EH_PACK_CFA_FP;
+  ret |= (uint64_t) rule->fp_rule << EH_PACK_FP_SHIFT;
+  ret |= (uint64_t) rule->ra_rule << EH_PACK_RA_SHIFT;
+  ret |= ((uint64_t) (rule->fp_off / 8) & 0xfff) << EH_PACK_FP_OFF_SHIFT;
+  ret |= ((uint64_t) (rule->ra_off / 8) & 0xfff) << EH_PACK_RA_OFF_SHIFT;
+  ret |= ((uint64_t) rule->cfa_off & 0xffffffff) << EH_PACK_CFA_OFF_SHIFT;
+  return ret;
+}
+
+/* Sign extend the low BITS bits of V.  */
+
+static int64_t
+eh_sign_extend (uint64_t v, int bits)
+{
+  uint64_t m;
+
+  m = (uint64_t) 1 << (bits - 1);
+  v &= ((uint64_t) 1 << bits) - 1;
+  return (int64_t) ((v ^ m) - m);
+}
+
+/* Unpack a rule packed by eh_pack_rule.  */
+
+static void
+eh_unpack_rule (uint64_t packed, struct eh_rule *rule)
+{
+  memset (rule, 0, sizeof *rule);
+  if ((packed & EH_PACK_SIGNAL) != 0)
+    {
+      rule->signal_frame = 1;
+      return;
+    }
+  rule->cfa_reg = (packed & EH_PACK_CFA_FP) != 0 ? EH_REG_FP : EH_REG_SP;
+  rule->fp_rule = (enum eh_reg_rule) ((packed >> EH_PACK_FP_SHIFT) & 3);
+  rule->ra_rule = (enum eh_reg_rule) ((packed >> EH_PACK_RA_SHIFT) & 3);
+  rule->fp_off = eh_sign_extend (packed >> EH_PACK_FP_OFF_SHIFT, 12) * 8;
+  rule->ra_off = eh_sign_extend (packed >> EH_PACK_RA_OFF_SHIFT, 12) * 8;
+  rule->cfa_off = eh_sign_extend (packed >> EH_PACK_CFA_OFF_SHIFT, 32);
+}
+
+/* Return the first cache slot to probe for PC.  */
+
+static inline size_t
+eh_cache_hash (uintptr_t pc)
+{
+  return (size_t) ((pc * (uintptr_t) 0x9e3779b97f4a7c15ULL) >> 52)
+    & (EH_CACHE_SIZE - 1);
+}
+
+/* Look up PC in CACHE for generation GEN.  Returns the packed rule,
+   or 0 if not found.  */
+
+static uint64_t
+eh_cache_lookup (struct backtrace_eh_cache *cache, unsigned int gen,
+		 uintptr_t pc)
+{
+  size_t h;
+  int i;
+
+  h = eh_cache_hash (pc);
+  for (i = 0; i < EH_CACHE_PROBES; ++i)
+    {
+      struct eh_cache_entry *e;
+      unsigned int seq;
+      uint64_t rule;
+
+      e = &cache->entries[(h + i) & (EH_CACHE_SIZE - 1)];
+      seq = __atomic_load_n (&e->seq, __ATOMIC_ACQUIRE);
+      if ((seq & 1) != 0)
+	continue;
+      if (__atomic_load_n (&e->pc, __ATOMIC_RELAXED) != pc
+	  || __atomic_load_n (&e->gen, __ATOMIC_RELAXED) != gen)
+	continue;
+      rule = __atomic_load_n (&e->rule, __ATOMIC_RELAXED);
+      __atomic_thread_fence (__ATOMIC_ACQUIRE);
+      if (__atomic_load_n (&e->seq, __ATOMIC_RELAXED) == seq)
+	return rule;
+    }
+  return 0;
+}
+
+/* Add PC with the packed rule PACKED, computed for generation GEN,
+   to CACHE.  Use an entry from an older generation if there is one
+   near PC, and otherwise replace one.  If another thread is writing
+   the entry, just drop the rule.  */
+
+static void
+eh_cache_add (struct backtrace_eh_cache *cache, unsigned int gen,
+	      uintptr_t pc, uint64_t packed)
+{
+  size_t h;
+  struct eh_cache_entry *e;
+  int i;
+  unsigned int seq;
+
+  h = eh_cache_hash (pc);
+  e = NULL;
+  for (i = 0; i < EH_CACHE_PROBES; ++i)
+    {
+      struct eh_cache_entry *p;
+
+      p = &cache->entries[(h + i) & (EH_CACHE_SIZE - 1)];
+      if (__atomic_load_n (&p->gen, __ATOMIC_RELAXED) != gen)
+	{
+	  e = p;
+	  break;
+	}
+      if (__atomic_load_n (&p->pc, __ATOMIC_RELAXED) == pc)
+	return;
+    }
+  if (e == NULL)
+    e = &cache->entries[(h + ((pc >> 2) & (EH_CACHE_PROBES - 1)))
+			& (EH_CACHE_SIZE - 1)];
+
+  seq = __atomic_load_n (&e->seq, __ATOMIC_RELAXED);
+  if ((seq & 1) != 0
+      || !__atomic_compare_exchange_n (&e->seq, &seq, seq + 1, 0,
+				       __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    return;
+  __atomic_store_n (&e->gen, gen, __ATOMIC_RELAXED);
+  __atomic_store_n (&e->pc, pc, __ATOMIC_RELAXED);
+  __atomic_store_n (&e->rule, packed, __ATOMIC_RELAXED);
+  __atomic_store_n (&e->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/* A buffer that we are reading call frame information from.  */
+
+struct eh_buf
+{
+  const unsigned char *p;
+  const unsigned char *end;
+  /* Set if we ran off the end of the buffer.  */
+  int failed;
+};
+
+static inline unsigned char
+eh_read_byte (struct eh_buf *b)
+{
+  if (b->p >= b->end)
+    {
+      b->failed = 1;
+      return 0;
+    }
+  return *b->p++;
+}
+
+static uint64_t
+eh_read_uleb128 (struct eh_buf *b)
+{
+  uint64_t ret;
+  unsigned int shift;
+  unsigned char c;
+
+  ret = 0;
+  shift = 0;
+  do
+    {
+      c = eh_read_byte (b);
+      if (shift < 64)
+	ret |= ((uint64_t) (c & 0x7f)) << shift;
+      shift += 7;
+    }
+  while ((c & 0x80) != 0 && !b->failed);
+  return ret;
+}
+
+static int64_t
+eh_read_sleb128 (struct eh_buf *b)
+{
+  uint64_t ret;
+  unsigned int shift;
+  unsigned char c;
+
+  ret = 0;
+  shift = 0;
+  do
+    {
+      c = eh_read_byte (b);
+      if (shift < 64)
+	ret |= ((uint64_t) (c & 0x7f)) << shift;
+      shift += 7;
+    }
+  while ((c & 0x80) != 0 && !b->failed);
+  if ((c & 0x40) != 0 && shift < 64)
+    ret |= -((uint64_t) 1 << shift);
+  return (int64_t) ret;
+}
+
+/* Read N bytes as a little or big endian value of the host byte
+   order.  */
+
+static uint64_t
+eh_read_fixed (struct eh_buf *b, size_t n)
+{
+  uint64_t ret;
+
+  if ((size_t) (b->end - b->p) < n)
+    {
+      b->failed = 1;
+      return 0;
+    }
+  switch (n)
+    {
+    case 2:
+      {
+	uint16_t v;
+
+	memcpy (&v, b->p, 2);
+	ret = v;
+      }
+      break;
+    case 4:
+      {
+	uint32_t v;
+
+	memcpy (&v, b->p, 4);
+	ret = v;
+      }
+      break;
+    default:
+      memcpy (&ret, b->p, 8);
+      break;
+    }
+  b->p += n;
+  return ret;
+}
+
+/* Read a pointer encoded with ENCODING.  DATAREL is the base for
+   DW_EH_PE_datarel.  */
+
+static uintptr_t
+eh_read_encoded (struct eh_buf *b, unsigned char encoding,
+		 uintptr_t datarel)
+{
+  uintptr_t start;
+  uint64_t val;
+
+  if (encoding == DW_EH_PE_omit)
+    return 0;
+
+  start = (uintptr_t) b->p;
+  switch (encoding & 0x0f)
+    {
+    case DW_EH_PE_absptr:
+      val = eh_read_fixed (b, sizeof (uintptr_t));
+      break;
+    case DW_EH_PE_uleb128:
+      val = eh_read_uleb128 (b);
+      break;
+    case DW_EH_PE_udata2:
+      val = eh_read_fixed (b, 2);
+      break;
+    case DW_EH_PE_udata4:
+      val = eh_read_fixed (b, 4);
+      break;
+    case DW_EH_PE_udata8:
+      val = eh_read_fixed (b, 8);
+      break;
+    case DW_EH_PE_sleb128:
+      val = (uint64_t) eh_read_sleb128 (b);
+      break;
+    case DW_EH_PE_sdata2:
+      val = (uint64_t) (int64_t) (int16_t) eh_read_fixed (b, 2);
+      break;
+    case DW_EH_PE_sdata4:
+      val = (uint64_t) (int64_t) (int32_t) eh_read_fixed (b, 4);
+      break;
+    case DW_EH_PE_sdata8:
+      val = eh_read_fixed (b, 8);
+      break;
+    default:
+      b->failed = 1;
+      return 0;
+    }
+
+  switch (encoding & 0x70)
+    {
+    case DW_EH_PE_absptr:
+      break;
+    case DW_EH_PE_pcrel:
+      val += start;
+      break;
+    case DW_EH_PE_datarel:
+      val += datarel;
+      break;
+    default:
+      b->failed = 1;
+      return 0;
+    }
+
+  if ((encoding & DW_EH_PE_indirect) != 0)
+    {
+      /* Only used for personality routines, which we skip.  */
+      val = 0;
+    }
+
+  return (uintptr_t) val;
+}
+
+/* The parts of a CIE that we need.  */
+
+struct eh_cie
+{
+  uint64_t code_align;
+  int64_t data_align;
+  unsigned char fde_encoding;
+  int has_augmentation_data;
+  int signal_frame;
+  struct eh_buf insns;
+};
+
+/* Parse the CIE at P.  Returns 1 on success, 0 on failure.  */
+
+static int
+eh_parse_cie (const unsigned char *p, struct eh_cie *cie)
+{
+  struct eh_buf b;
+  uint64_t len;
+  const char *aug;
+  unsigned char version;
+  uint64_t ra;
+  int has_z;
+  const unsigned char *aug_end;
+
+  b.p = p;
+  b.end = p + 12;
+  b.failed = 0;
+  len = eh_read_fixed (&b, 4);
+  if (len == 0xffffffff)
+    len = eh_read_fixed (&b, 8);
+  b.end = b.p + len;
+  if (b.end < b.p || eh_read_fixed (&b, 4) != 0)
+    return 0;
+
+  version = eh_read_byte (&b);
+  if (version != 1 && version != 3)
+    return 0;
+
+  aug = (const char *) b.p;
+  while (eh_read_byte (&b) != '\0' && !b.failed)
+    ;
+
+  cie->code_align = eh_read_uleb128 (&b);
+  cie->data_align = eh_read_sleb128 (&b);
+  if (version == 1)
+    ra = eh_read_byte (&b);
+  else
+    ra = eh_read_uleb128 (&b);
+  if (ra != EH_REG_RA)
+    return 0;
+
+  cie->fde_encoding = DW_EH_PE_absptr;
+  cie->signal_frame = 0;
+  has_z = 0;
+  aug_end = NULL;
+  for (; *aug != '\0' && !b.failed; ++aug)
+    {
+      switch (*aug)
+	{
+	case 'z':
+	  {
+	    uint64_t alen;
+
+	    alen = eh_read_uleb128 (&b);
+	    if (alen > (uint64_t) (b.end - b.p))
+	      return 0;
+	    aug_end = b.p + alen;
+	    has_z = 1;
+	  }
+	  break;
+	case 'R':
+	  cie->fde_encoding = eh_read_byte (&b);
+	  break;
+	case 'P':
+	  {
+	    unsigned char penc;
+
+	    penc = eh_read_byte (&b);
+	    eh_read_encoded (&b, penc, 0);
+	  }
+	  break;
+	case 'L':
+	  eh_read_byte (&b);
+	  break;
+	case 'S':
+	  cie->signal_frame = 1;
+	  break;
+	default:
+	  /* Unknown augmentation; skip the rest of the data if we
+	     can.  */
+	  if (!has_z)
+	    return 0;
+	  goto done;
+	}
+    }
+ done:
+  if (has_z)
+    b.p = aug_end;
+  if (b.failed)
+    return 0;
+
+  cie->has_augmentation_data = has_z;
+  cie->insns = b;
+  return 1;
+}
+
+/* Set the rule for register REG, if it is one we track.  */
+
+static void
+eh_set_reg (struct eh_rule *rule, uint64_t reg, enum eh_reg_rule how,
+	    int64_t off)
+{
+  if (reg == EH_REG_FP)
+    {
+      rule->fp_rule = how;
+      rule->fp_off = off;
+    }
+  else if (reg == EH_REG_RA)
+    {
+      rule->ra_rule = how;
+      rule->ra_off = off;
+    }
+}
+
+/* The maximum depth of DW_CFA_remember_state.  */
+
+#define EH_STATE_STACK 8
+
+/* Execute the call frame instructions in B, updating RULE, until the
+   location passes TARGET.  LOC is the starting location.  INIT is
+   the rule after the CIE instructions, used by DW_CFA_restore; it is
+   NULL while executing the CIE instructions.  Returns 1 on success,
+   0 if we found something that we don't support.  */
+
+static int
+eh_execute (struct eh_buf *b, const struct eh_cie *cie, uintptr_t loc,
+	    uintptr_t target, struct eh_rule *rule,
+	    const struct eh_rule *init)
+{
+  struct eh_rule stack[EH_STATE_STACK];
+  int depth;
+
+  depth = 0;
+  while (b->p < b->end && !b->failed)
+    {
+      unsigned char op;
+      uint64_t reg;
+      uint64_t delta;
+
+      op = eh_read_byte (b);
+      delta = 0;
+      switch (op & 0xc0)
+	{
+	case DW_CFA_advance_loc:
+	  delta = op & 0x3f;
+	  goto advance;
+	case DW_CFA_offset:
+	  reg = op & 0x3f;
+	  eh_set_reg (rule, reg, EH_RULE_OFFSET,
+		      (int64_t) eh_read_uleb128 (b) * cie->data_align);
+	  continue;
+	case DW_CFA_restore:
+	  reg = op & 0x3f;
+	  goto restore;
+	default:
+	  break;
+	}
+
+      switch (op)
+	{
+	case DW_CFA_nop:
+	  break;
+	case DW_CFA_set_loc:
+	  loc = eh_read_encoded (b, cie->fde_encoding, 0);
+	  if (loc > target)
+	    return !b->failed;
+	  break;
+	case DW_CFA_advance_loc1:
+	  delta = eh_read_byte (b);
+	  goto advance;
+	case DW_CFA_advance_loc2:
+	  delta = eh_read_fixed (b, 2);
+	  goto advance;
+	case DW_CFA_advance_loc4:
+	  delta = eh_read_fixed (b, 4);
+	  goto advance;
+	case DW_CFA_offset_extended:
+	  reg = eh_read_uleb128 (b);
+	  eh_set_reg (rule, reg, EH_RULE_OFFSET,
+		      (int64_t) eh_read_uleb128 (b) * cie->data_align);
+	  break;
+	case DW_CFA_offset_extended_sf:
+	  reg = eh_read_uleb128 (b);
+	  eh_set_reg (rule, reg, EH_RULE_OFFSET,
+		      eh_read_sleb128 (b) * cie->data_align);
+	  break;
+	case DW_CFA_GNU_negative_offset_extended:
+	  reg = eh_read_uleb128 (b);
+	  eh_set_reg (rule, reg, EH_RULE_OFFSET,
+		      -((int64_t) eh_read_uleb128 (b) * cie->data_align));
+	  break;
+	case DW_CFA_restore_extended:
+	  reg = eh_read_uleb128 (b);
+	restore:
+	  if (init == NULL)
+	    return 0;
+	  if (reg == EH_REG_FP)
+	    {
+	      rule->fp_rule = init->fp_rule;
+	      rule->fp_off = init->fp_off;
+	    }
+	  else if (reg == EH_REG_RA)
+	    {
+	      rule->ra_rule = init->ra_rule;
+	      rule->ra_off = init->ra_off;
+	    }
+	  break;
+	case DW_CFA_undefined:
+	  eh_set_reg (rule, eh_read_uleb128 (b), EH_RULE_UNDEFINED, 0);
+	  break;
+	case DW_CFA_same_value:
+	  eh_set_reg (rule, eh_read_uleb128 (b), EH_RULE_SAME, 0);
+	  break;
+	case DW_CFA_register:
+	case DW_CFA_val_offset:
+	case DW_CFA_val_offset_sf:
+	  reg = eh_read_uleb128 (b);
+	  if (reg == EH_REG_FP || reg == EH_REG_RA)
+	    return 0;
+	  if (op == DW_CFA_val_offset_sf)
+	    eh_read_sleb128 (b);
+	  else
+	    eh_read_uleb128 (b);
+	  break;
+	case DW_CFA_remember_state:
+	  if (depth >= EH_STATE_STACK)
+	    return 0;
+	  stack[depth++] = *rule;
+	  break;
+	case DW_CFA_restore_state:
+	  if (depth == 0)
+	    return 0;
+	  *rule = stack[--depth];
+	  break;
+	case DW_CFA_def_cfa:
+	  rule->cfa_reg = (int) eh_read_uleb128 (b);
+	  rule->cfa_off = (int64_t) eh_read_uleb128 (b);
+	  break;
+	case DW_CFA_def_cfa_sf:
+	  rule->cfa_reg = (int) eh_read_uleb128 (b);
+	  rule->cfa_off = eh_read_sleb128 (b) * cie->data_align;
+	  break;
+	case DW_CFA_def_cfa_register:
+	  rule->cfa_reg = (int) eh_read_uleb128 (b);
+	  break;
+	case DW_CFA_def_cfa_offset:
+	  rule->cfa_off = (int64_t) eh_read_uleb128 (b);
+	  break;
+	case DW_CFA_def_cfa_offset_sf:
+	  rule->cfa_off = eh_read_sleb128 (b) * cie->data_align;
+	  break;
+	case DW_CFA_expression:
+	case DW_CFA_val_expression:
+	  {
+	    uint64_t len;
+
+	    reg = eh_read_uleb128 (b);
+	    if (reg == EH_REG_FP || reg == EH_REG_RA)
+	      return 0;
+	    len = eh_read_uleb128 (b);
+	    if (len > (uint64_t) (b->end - b->p))
+	      return 0;
+	    b->p += len;
+	  }
+	  break;
+	case DW_CFA_GNU_args_size:
+	  eh_read_uleb128 (b);
+	  break;
+	case DW_CFA_def_cfa_expression:
+	default:
+	  return 0;
+	}
+      continue;
+
+    advance:
+      loc += delta * cie->code_align;
+      if (loc > target)
+	return !b->failed;
+    }
+
+  return !b->failed;
+}
+
+/* Find the module containing PC.  */
+
+static const struct backtrace_eh_module *
+eh_find_module (struct backtrace_state *state, uintptr_t pc)
+{
+  const struct backtrace_eh_module *m;
+
+  m = backtrace_atomic_load_pointer (&state->eh_modules);
+  for (; m != NULL; m = m->next)
+    {
+      if (pc >= m->low && pc < m->high)
+	return m;
+    }
+  return NULL;
+}
+
+/* Compute the unwind rule for PC.  Returns 1 on success, 0 if there
+   is no rule we can use.  */
+
+static int
+eh_find_rule (struct backtrace_state *state, uintptr_t pc,
+	      struct eh_rule *rule)
+{
+  const struct backtrace_eh_module *m;
+  size_t lo;
+  size_t hi;
+  const unsigned char *fde;
+  struct eh_buf b;
+  uint64_t len;
+  uint32_t cie_off;
+  struct eh_cie cie;
+  uintptr_t pc_begin;
+  uintptr_t pc_range;
+  struct eh_rule init;
+
+  m = eh_find_module (state, pc);
+  if (m == NULL)
+    return 0;
+
+  /* Find the last table entry whose initial location is <= PC.  */
+  lo = 0;
+  hi = m->count;
+  while (lo < hi)
+    {
+      size_t mid;
+
+      mid = lo + (hi - lo) / 2;
+      if ((uintptr_t) m->hdr + (intptr_t) m->table[2 * mid] <= pc)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  if (lo == 0)
+    return 0;
+
+  fde = m->hdr + (intptr_t) m->table[2 * (lo - 1) + 1];
+
+  b.p = fde;
+  b.end = fde + 12;
+  b.failed = 0;
+  len = eh_read_fixed (&b, 4);
+  if (len == 0xffffffff)
+    len = eh_read_fixed (&b, 8);
+  b.end = b.p + len;
+  cie_off = (uint32_t) eh_read_fixed (&b, 4);
+  if (b.failed || cie_off == 0)
+    return 0;
+  if (!eh_parse_cie (b.p - 4 - cie_off, &cie))
+    return 0;
+
+  pc_begin = eh_read_encoded (&b, cie.fde_encoding, 0);
+  pc_range = eh_read_encoded (&b, cie.fde_encoding & 0x0f, 0);
+  if (b.failed || pc < pc_begin || pc - pc_begin >= pc_range)
+    return 0;
+
+  memset (rule, 0, sizeof *rule);
+  if (cie.signal_frame)
+    {
+      rule->signal_frame = 1;
+      return 1;
+    }
+
+  if (cie.has_augmentation_data)
+    {
+      len = eh_read_uleb128 (&b);
+      if (len > (uint64_t) (b.end - b.p))
+	return 0;
+      b.p += len;
+    }
+
+  rule->cfa_reg = EH_REG_SP;
+  rule->fp_rule = EH_RULE_SAME;
+  rule->ra_rule = EH_RULE_SAME;
+  if (!eh_execute (&cie.insns, &cie, pc_begin, pc, rule, NULL))
+    return 0;
+  init = *rule;
+  if (!eh_execute (&b, &cie, pc_begin, pc, rule, &init))
+    return 0;
+
+  if (rule->cfa_reg != EH_REG_SP && rule->cfa_reg != EH_REG_FP)
+    return 0;
+
+  return 1;
+}
+
+/* Read a word from the stack at ADDR, which must be within LO and
+   HI.  */
+
+static inline int
+eh_read_stack (uintptr_t addr, uintptr_t lo, uintptr_t hi, uintptr_t *val)
+{
+  if (addr < lo
+      || addr > hi - sizeof (uintptr_t)
+      || (addr & (sizeof (uintptr_t) - 1)) != 0)
+    return 0;
+  *val = *(const uintptr_t *) addr;
+  return 1;
+}
+
+/* Step REGS to the caller's frame.  */
+
+int
+backtrace_eh_frame_step (struct backtrace_state *state,
+			 struct backtrace_unwind_regs *regs,
+			 uintptr_t lo, uintptr_t hi)
+{
+  struct backtrace_eh_cache *cache;
+  unsigned int gen;
+  uintptr_t pc;
+  uint64_t packed;
+  struct eh_rule rule;
+  uintptr_t cfa;
+  uintptr_t ra;
+  uintptr_t fp;
+
+  /* A return address points after the call instruction, which may be
+     the start of a different function or of a different unwind
+     row.  */
+  pc = regs->pc;
+  if (!regs->exact)
+    --pc;
+
+  cache = backtrace_atomic_load_pointer (&state->eh_cache);
+  if (cache == NULL)
+    return -1;
+
+  /* Load the generation before the module list that eh_find_rule
+     uses, so that a rule computed from a newer list is at worst
+     ignored later.  */
+  gen = __atomic_load_n (&cache->gen, __ATOMIC_ACQUIRE);
+  packed = eh_cache_lookup (cache, gen, pc);
+  if (packed != 0)
+    eh_unpack_rule (packed, &rule);
+  else
+    {
+      if (!eh_find_rule (state, pc, &rule))
+	return -1;
+      packed = eh_pack_rule (&rule);
+      if (packed != 0)
+	eh_cache_add (cache, gen, pc, packed);
+    }
+
+  if (rule.signal_frame)
+    {
+      const ucontext_t *uc;
+
+      /* The stack pointer points at the signal frame pushed by the
+	 kernel.  */
+      uc = (const ucontext_t *) regs->sp;
+      if ((uintptr_t) uc < lo || (uintptr_t) (uc + 1) > hi)
+	return -1;
+      regs->pc = uc->uc_mcontext.gregs[REG_RIP];
+      regs->sp = uc->uc_mcontext.gregs[REG_RSP];
+      regs->fp = uc->uc_mcontext.gregs[REG_RBP];
+      /* The PC is where the signal arrived, not a return
+	 address.  */
+      regs->exact = 1;
+      return regs->pc == 0 ? 0 : 1;
+    }
+
+  if (rule.cfa_reg == EH_REG_FP)
+    cfa = regs->fp + rule.cfa_off;
+  else
+    cfa = regs->sp + rule.cfa_off;
+
+  /* The stack grows down, so the caller's frame must be above this
+     one.  */
+  if (cfa <= regs->sp || cfa > hi)
+    return -1;
+
+  switch (rule.ra_rule)
+    {
+    case EH_RULE_OFFSET:
+      if (!eh_read_stack (cfa + rule.ra_off, lo, hi, &ra))
+	return -1;
+      break;
+    case EH_RULE_SAME:
+      /* The return address is still in a register, which we don't
+	 track.  */
+      return -1;
+    case EH_RULE_UNDEFINED:
+    default:
+      return 0;
+    }
+
+  switch (rule.fp_rule)
+    {
+    case EH_RULE_OFFSET:
+      if (!eh_read_stack (cfa + rule.fp_off, lo, hi, &fp))
+	return -1;
+      break;
+    case EH_RULE_SAME:
+      fp = regs->fp;
+      break;
+    case EH_RULE_UNDEFINED:
+    default:
+      fp = 0;
+      break;
+    }
+
+  regs->pc = ra;
+  regs->sp = cfa;
+  regs->fp = fp;
+  regs->exact = 0;
+  return ra == 0 ? 0 : 1;
+}
+
+/* Set *PM to a new module for the .eh_frame_hdr section HDR of a
+   module loaded in memory, whose executable code is between LOW and
+   HIGH, or to NULL if the section can't be used.  Returns 0 if memory
+   allocation failed, 1 otherwise.  */
+
+static int
+eh_new_module (struct backtrace_state *state, uintptr_t low, uintptr_t high,
+	       const unsigned char *hdr, struct backtrace_eh_module **pm)
+{
+  struct eh_buf b;
+  unsigned char eh_frame_ptr_enc;
+  unsigned char fde_count_enc;
+  unsigned char table_enc;
+  uintptr_t count;
+  struct backtrace_eh_module *m;
+
+  *pm = NULL;
+
+  /* We only support the binary search table format that the GNU
+     linker and gold and lld all generate.  */
+  b.p = hdr;
+  b.end = hdr + 4;
+  b.failed = 0;
+  if (eh_read_byte (&b) != 1)
+    return 1;
+  eh_frame_ptr_enc = eh_read_byte (&b);
+  fde_count_enc = eh_read_byte (&b);
+  table_enc = eh_read_byte (&b);
+  if (table_enc != (DW_EH_PE_datarel | DW_EH_PE_sdata4))
+    return 1;
+  b.end = hdr + 4 + 2 * sizeof (uint64_t);
+  eh_read_encoded (&b, eh_frame_ptr_enc, (uintptr_t) hdr);
+  count = eh_read_encoded (&b, fde_count_enc, (uintptr_t) hdr);
+  if (b.failed || count == 0)
+    return 1;
+
+  m = ((struct backtrace_eh_module *)
+       backtrace_alloc (state, sizeof *m, NULL, NULL));
+  if (m == NULL)
+    return 0;
+  m->next = NULL;
+  m->low = low;
+  m->high = high;
+  m->hdr = hdr;
+  m->table = (const int32_t *) b.p;
+  m->count = count;
+  *pm = m;
+  return 1;
+}
+
+/* Data passed to eh_phdr_callback.  */
+
+struct eh_phdr_data
+{
+  struct backtrace_state *state;
+  /* The modules found so far.  */
+  struct backtrace_eh_module *modules;
+  /* Set if memory allocation failed.  */
+  int failed;
+};
+
+/* Callback passed to dl_iterate_phdr to find the unwind tables of
+   every module, including those without a name such as a non-PIE
+   executable and the vDSO.  */
+
+static int
+#ifdef __i386__
+__attribute__ ((__force_align_arg_pointer__))
+#endif
+eh_phdr_callback (struct dl_phdr_info *info, size_t size ATTRIBUTE_UNUSED,
+		  void *pdata)
+{
+  struct eh_phdr_data *pd = (struct eh_phdr_data *) pdata;
+  const unsigned char *eh_frame_hdr;
+  uintptr_t low;
+  uintptr_t high;
+  size_t i;
+  struct backtrace_eh_module *m;
+
+  eh_frame_hdr = NULL;
+  low = (uintptr_t) -1;
+  high = 0;
+  for (i = 0; i < info->dlpi_phnum; ++i)
+    {
+      uintptr_t start;
+
+      start = info->dlpi_addr + info->dlpi_phdr[i].p_vaddr;
+      if (info->dlpi_phdr[i].p_type == PT_GNU_EH_FRAME)
+	eh_frame_hdr = (const unsigned char *) start;
+      else if (info->dlpi_phdr[i].p_type == PT_LOAD
+	       && (info->dlpi_phdr[i].p_flags & PF_X) != 0)
+	{
+	  if (start < low)
+	    low = start;
+	  if (start + info->dlpi_phdr[i].p_memsz > high)
+	    high = start + info->dlpi_phdr[i].p_memsz;
+	}
+    }
+  if (eh_frame_hdr == NULL || low >= high)
+    return 0;
+
+  if (!eh_new_module (pd->state, low, high, eh_frame_hdr, &m))
+    pd->failed = 1;
+  else if (m != NULL)
+    {
+      m->next = pd->modules;
+      pd->modules = m;
+    }
+  return 0;
+}
+
+/* The counts of modules loaded and unloaded, as reported by
+   dl_iterate_phdr.  */
+
+struct eh_phdr_counts
+{
+  int valid;
+  unsigned long long adds;
+  unsigned long long subs;
+};
+
+/* Callback passed to dl_iterate_phdr to get the counts, which are the
+   same for every module, so it stops after the first one.  */
+
+static int
+#ifdef __i386__
+__attribute__ ((__force_align_arg_pointer__))
+#endif
+eh_counts_callback (struct dl_phdr_info *info, size_t size, void *pdata)
+{
+  struct eh_phdr_counts *counts = (struct eh_phdr_counts *) pdata;
+
+  if (size >= (offsetof (struct dl_phdr_info, dlpi_subs)
+	       + sizeof info->dlpi_subs))
+    {
+      counts->valid = 1;
+      counts->adds = info->dlpi_adds;
+      counts->subs = info->dlpi_subs;
+    }
+  return 1;
+}
+
+/* Read the module list again if modules have been loaded or unloaded
+   since it was last read, or if FORCE is set.  */
+
+static void
+eh_sync (struct backtrace_state *state, struct backtrace_eh_cache *cache,
+	 int force)
+{
+  struct eh_phdr_counts counts;
+  struct eh_phdr_data pd;
+
+  memset (&counts, 0, sizeof counts);
+  dl_iterate_phdr (eh_counts_callback, (void *) &counts);
+  if (!force
+      && (!counts.valid
+	  || (__atomic_load_n (&cache->counts_valid, __ATOMIC_ACQUIRE)
+	      && (__atomic_load_n (&cache->adds, __ATOMIC_RELAXED)
+		  == counts.adds)
+	      && (__atomic_load_n (&cache->subs, __ATOMIC_RELAXED)
+		  == counts.subs))))
+    return;
+
+  pd.state = state;
+  pd.modules = NULL;
+  pd.failed = 0;
+  dl_iterate_phdr (eh_phdr_callback, (void *) &pd);
+  if (pd.failed)
+    {
+      /* Keep using the old list.  */
+      while (pd.modules != NULL)
+	{
+	  struct backtrace_eh_module *next;
+
+	  next = pd.modules->next;
+	  backtrace_free (state, pd.modules, sizeof *pd.modules, NULL, NULL);
+	  pd.modules = next;
+	}
+      return;
+    }
+
+  /* Publish the new list, and then the new generation, so that a
+     thread that sees the new generation sees the new list.  The old
+     list may still be in use by another thread, or by a signal
+     handler that interrupted this one, so it is leaked.  If two
+     threads get here at once, they read the same list.  */
+  backtrace_atomic_store_pointer (&state->eh_modules, pd.modules);
+  __atomic_add_fetch (&cache->gen, 1, __ATOMIC_RELEASE);
+  __atomic_store_n (&cache->adds, counts.adds, __ATOMIC_RELAXED);
+  __atomic_store_n (&cache->subs, counts.subs, __ATOMIC_RELAXED);
+  __atomic_store_n (&cache->counts_valid, counts.valid, __ATOMIC_RELEASE);
+}
+
+/* Read the module list again if it is out of date.  */
+
+void
+backtrace_eh_frame_sync (struct backtrace_state *state)
+{
+  struct backtrace_eh_cache *cache;
+
+  cache = backtrace_atomic_load_pointer (&state->eh_cache);
+  if (cache != NULL)
+    eh_sync (state, cache, 0);
+}
+
+/* Prepare STATE for the built-in unwinder.  */
+
+int
+backtrace_eh_frame_init (struct backtrace_state *state,
+			 backtrace_error_callback error_callback, void *data)
+{
+  struct backtrace_eh_cache *cache;
+
+  if (backtrace_atomic_load_pointer (&state->eh_cache) != NULL)
+    return 1;
+
+  cache = ((struct backtrace_eh_cache *)
+	   backtrace_alloc (state, sizeof *cache, error_callback, data));
+  if (cache == NULL)
+    return 0;
+  memset (cache, 0, sizeof *cache);
+  cache->gen = 1;
+
+  eh_sync (state, cache, 1);
+
+  if (!state->threaded)
+    state->eh_cache = cache;
+  else if (!__sync_bool_compare_and_swap (&state->eh_cache, NULL, cache))
+    backtrace_free (state, cache, sizeof *cache, error_callback, data);
+
+  return 1;
+}
+
+#else /* !BACKTRACE_EH_FRAME_UNWIND */
+
+void
+backtrace_eh_frame_sync (struct backtrace_state *state ATTRIBUTE_UNUSED)
+{
+}
+
+int
+backtrace_eh_frame_init (struct backtrace_state *state ATTRIBUTE_UNUSED,
+			 backtrace_error_callback error_callback,
+			 void *data)
+{
+  error_callback (data, "built-in unwinder not supported on this system", 0);
+  return 0;
+}
+
+#endif /* !BACKTRACE_EH_FRAME_UNWIND */
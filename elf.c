@@ -48,6 +48,14 @@ POSSIBILITY OF SUCH DAMAGE.  */
  #endif
 #endif
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#ifdef HAVE_PCLMUL
+#include <immintrin.h>
+#endif
+
 #include "backtrace.h"
 #include "internal.h"
 
@@ -395,6 +403,9 @@ struct elf_syminfo_data
   struct elf_symbol *symbols;
   /* The number of symbols.  */
   size_t count;
+  /* The DWARF data for the same module, once elf_resolve has found
+     a PC in it.  */
+  struct dwarf_data *dwarf;
 };
 
 /* A view that works for either a file or memory.  */
@@ -458,72 +469,567 @@ elf_release_view (struct backtrace_state *state, struct elf_view *view,
     backtrace_release_view (state, &view->view, error_callback, data);
 }
 
+#ifdef BACKTRACE_GENERATE_CRC32_TABLES
+
+/* Used to generate the CRC-32 tables below.  Table 0 is the usual
+   byte-at-a-time table.  Table K gives the effect of a byte followed
+   by K zero bytes, which lets elf_crc32 process 8 bytes per step.  */
+
+#include <stdio.h>
+
+static uint32_t crc32_tables[8][256];
+
+int
+main ()
+{
+  size_t i;
+  size_t k;
+
+  for (i = 0; i < 256; ++i)
+    {
+      uint32_t c;
+      size_t j;
+
+      c = i;
+      for (j = 0; j < 8; ++j)
+	c = (c & 1) != 0 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+      crc32_tables[0][i] = c;
+    }
+  for (k = 1; k < 8; ++k)
+    for (i = 0; i < 256; ++i)
+      crc32_tables[k][i] = ((crc32_tables[k - 1][i] >> 8)
+			    ^ crc32_tables[0][crc32_tables[k - 1][i] & 0xff]);
+
+  printf ("static const uint32_t elf_crc32_tables[8][256] =\n");
+  printf ("{\n");
+  for (k = 0; k < 8; ++k)
+    {
+      printf ("  {\n");
+      for (i = 0; i < 256; i += 6)
+	{
+	  size_t j;
+
+	  printf ("   ");
+	  for (j = i; j < 256 && j < i + 6; ++j)
+	    printf (" 0x%08x,", crc32_tables[k][j]);
+	  printf ("\n");
+	}
+      printf ("  },\n");
+    }
+  printf ("};\n");
+
+  return 0;
+}
+
+#endif
+
+static const uint32_t elf_crc32_tables[8][256] =
+{
+  {
+    0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
+    0xe963a535, 0x9e6495a3, 0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988,
+    0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91, 0x1db71064, 0x6ab020f2,
+    0xf3b97148, 0x84be41de, 0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
+    0x136c9856, 0x646ba8c0, 0xfd62f97a, 0x8a65c9ec, 0x14015c4f, 0x63066cd9,
+    0xfa0f3d63, 0x8d080df5, 0x3b6e20c8, 0x4c69105e, 0xd56041e4, 0xa2677172,
+    0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b, 0x35b5a8fa, 0x42b2986c,
+    0xdbbbc9d6, 0xacbcf940, 0x32d86ce3, 0x45df5c75, 0xdcd60dcf, 0xabd13d59,
+    0x26d930ac, 0x51de003a, 0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423,
+    0xcfba9599, 0xb8bda50f, 0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
+    0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d, 0x76dc4190, 0x01db7106,
+    0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f, 0x9fbfe4a5, 0xe8b8d433,
+    0x7807c9a2, 0x0f00f934, 0x9609a88e, 0xe10e9818, 0x7f6a0dbb, 0x086d3d2d,
+    0x91646c97, 0xe6635c01, 0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e,
+    0x6c0695ed, 0x1b01a57b, 0x8208f4c1, 0xf50fc457, 0x65b0d9c6, 0x12b7e950,
+    0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3, 0xfbd44c65,
+    0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2, 0x4adfa541, 0x3dd895d7,
+    0xa4d1c46d, 0xd3d6f4fb, 0x4369e96a, 0x346ed9fc, 0xad678846, 0xda60b8d0,
+    0x44042d73, 0x33031de5, 0xaa0a4c5f, 0xdd0d7cc9, 0x5005713c, 0x270241aa,
+    0xbe0b1010, 0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
+    0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17, 0x2eb40d81,
+    0xb7bd5c3b, 0xc0ba6cad, 0xedb88320, 0x9abfb3b6, 0x03b6e20c, 0x74b1d29a,
+    0xead54739, 0x9dd277af, 0x04db2615, 0x73dc1683, 0xe3630b12, 0x94643b84,
+    0x0d6d6a3e, 0x7a6a5aa8, 0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1,
+    0xf00f9344, 0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb,
+    0x196c3671, 0x6e6b06e7, 0xfed41b76, 0x89d32be0, 0x10da7a5a, 0x67dd4acc,
+    0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5, 0xd6d6a3e8, 0xa1d1937e,
+    0x38d8c2c4, 0x4fdff252, 0xd1bb67f1, 0xa6bc5767, 0x3fb506dd, 0x48b2364b,
+    0xd80d2bda, 0xaf0a1b4c, 0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55,
+    0x316e8eef, 0x4669be79, 0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
+    0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f, 0xc5ba3bbe, 0xb2bd0b28,
+    0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31, 0x2cd99e8b, 0x5bdeae1d,
+    0x9b64c2b0, 0xec63f226, 0x756aa39c, 0x026d930a, 0x9c0906a9, 0xeb0e363f,
+    0x72076785, 0x05005713, 0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38,
+    0x92d28e9b, 0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21, 0x86d3d2d4, 0xf1d4e242,
+    0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1, 0x18b74777,
+    0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c, 0x8f659eff, 0xf862ae69,
+    0x616bffd3, 0x166ccf45, 0xa00ae278, 0xd70dd2ee, 0x4e048354, 0x3903b3c2,
+    0xa7672661, 0xd06016f7, 0x4969474d, 0x3e6e77db, 0xaed16a4a, 0xd9d65adc,
+    0x40df0b66, 0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
+    0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605, 0xcdd70693,
+    0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94,
+    0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d,
+  },
+  {
+    0x00000000, 0x191b3141, 0x32366282, 0x2b2d53c3, 0x646cc504, 0x7d77f445,
+    0x565aa786, 0x4f4196c7, 0xc8d98a08, 0xd1c2bb49, 0xfaefe88a, 0xe3f4d9cb,
+    0xacb54f0c, 0xb5ae7e4d, 0x9e832d8e, 0x87981ccf, 0x4ac21251, 0x53d92310,
+    0x78f470d3, 0x61ef4192, 0x2eaed755, 0x37b5e614, 0x1c98b5d7, 0x05838496,
+    0x821b9859, 0x9b00a918, 0xb02dfadb, 0xa936cb9a, 0xe6775d5d, 0xff6c6c1c,
+    0xd4413fdf, 0xcd5a0e9e, 0x958424a2, 0x8c9f15e3, 0xa7b24620, 0xbea97761,
+    0xf1e8e1a6, 0xe8f3d0e7, 0xc3de8324, 0xdac5b265, 0x5d5daeaa, 0x44469feb,
+    0x6f6bcc28, 0x7670fd69, 0x39316bae, 0x202a5aef, 0x0b07092c, 0x121c386d,
+    0xdf4636f3, 0xc65d07b2, 0xed705471, 0xf46b6530, 0xbb2af3f7, 0xa231c2b6,
+    0x891c9175, 0x9007a034, 0x179fbcfb, 0x0e848dba, 0x25a9de79, 0x3cb2ef38,
+    0x73f379ff, 0x6ae848be, 0x41c51b7d, 0x58de2a3c, 0xf0794f05, 0xe9627e44,
+    0xc24f2d87, 0xdb541cc6, 0x94158a01, 0x8d0ebb40, 0xa623e883, 0xbf38d9c2,
+    0x38a0c50d, 0x21bbf44c, 0x0a96a78f, 0x138d96ce, 0x5ccc0009, 0x45d73148,
+    0x6efa628b, 0x77e153ca, 0xbabb5d54, 0xa3a06c15, 0x888d3fd6, 0x91960e97,
+    0xded79850, 0xc7cca911, 0xece1fad2, 0xf5facb93, 0x7262d75c, 0x6b79e61d,
+    0x4054b5de, 0x594f849f, 0x160e1258, 0x0f152319, 0x243870da, 0x3d23419b,
+    0x65fd6ba7, 0x7ce65ae6, 0x57cb0925, 0x4ed03864, 0x0191aea3, 0x188a9fe2,
+    0x33a7cc21, 0x2abcfd60, 0xad24e1af, 0xb43fd0ee, 0x9f12832d, 0x8609b26c,
+    0xc94824ab, 0xd05315ea, 0xfb7e4629, 0xe2657768, 0x2f3f79f6, 0x362448b7,
+    0x1d091b74, 0x04122a35, 0x4b53bcf2, 0x52488db3, 0x7965de70, 0x607eef31,
+    0xe7e6f3fe, 0xfefdc2bf, 0xd5d0917c, 0xcccba03d, 0x838a36fa, 0x9a9107bb,
+    0xb1bc5478, 0xa8a76539, 0x3b83984b, 0x2298a90a, 0x09b5fac9, 0x10aecb88,
+    0x5fef5d4f, 0x46f46c0e, 0x6dd93fcd, 0x74c20e8c, 0xf35a1243, 0xea412302,
+    0xc16c70c1, 0xd8774180, 0x9736d747, 0x8e2de606, 0xa500b5c5, 0xbc1b8484,
+    0x71418a1a, 0x685abb5b, 0x4377e898, 0x5a6cd9d9, 0x152d4f1e, 0x0c367e5f,
+    0x271b2d9c, 0x3e001cdd, 0xb9980012, 0xa0833153, 0x8bae6290, 0x92b553d1,
+    0xddf4c516, 0xc4eff457, 0xefc2a794, 0xf6d996d5, 0xae07bce9, 0xb71c8da8,
+    0x9c31de6b, 0x852aef2a, 0xca6b79ed, 0xd37048ac, 0xf85d1b6f, 0xe1462a2e,
+    0x66de36e1, 0x7fc507a0, 0x54e85463, 0x4df36522, 0x02b2f3e5, 0x1ba9c2a4,
+    0x30849167, 0x299fa026, 0xe4c5aeb8, 0xfdde9ff9, 0xd6f3cc3a, 0xcfe8fd7b,
+    0x80a96bbc, 0x99b25afd, 0xb29f093e, 0xab84387f, 0x2c1c24b0, 0x350715f1,
+    0x1e2a4632, 0x07317773, 0x4870e1b4, 0x516bd0f5, 0x7a468336, 0x635db277,
+    0xcbfad74e, 0xd2e1e60f, 0xf9ccb5cc, 0xe0d7848d, 0xaf96124a, 0xb68d230b,
+    0x9da070c8, 0x84bb4189, 0x03235d46, 0x1a386c07, 0x31153fc4, 0x280e0e85,
+    0x674f9842, 0x7e54a903, 0x5579fac0, 0x4c62cb81, 0x8138c51f, 0x9823f45e,
+    0xb30ea79d, 0xaa1596dc, 0xe554001b, 0xfc4f315a, 0xd7626299, 0xce7953d8,
+    0x49e14f17, 0x50fa7e56, 0x7bd72d95, 0x62cc1cd4, 0x2d8d8a13, 0x3496bb52,
+    0x1fbbe891, 0x06a0d9d0, 0x5e7ef3ec, 0x4765c2ad, 0x6c48916e, 0x7553a02f,
+    0x3a1236e8, 0x230907a9, 0x0824546a, 0x113f652b, 0x96a779e4, 0x8fbc48a5,
+    0xa4911b66, 0xbd8a2a27, 0xf2cbbce0, 0xebd08da1, 0xc0fdde62, 0xd9e6ef23,
+    0x14bce1bd, 0x0da7d0fc, 0x268a833f, 0x3f91b27e, 0x70d024b9, 0x69cb15f8,
+    0x42e6463b, 0x5bfd777a, 0xdc656bb5, 0xc57e5af4, 0xee530937, 0xf7483876,
+    0xb809aeb1, 0xa1129ff0, 0x8a3fcc33, 0x9324fd72,
+  },
+  {
+    0x00000000, 0x01c26a37, 0x0384d46e, 0x0246be59, 0x0709a8dc, 0x06cbc2eb,
+    0x048d7cb2, 0x054f1685, 0x0e1351b8, 0x0fd13b8f, 0x0d9785d6, 0x0c55efe1,
+    0x091af964, 0x08d89353, 0x0a9e2d0a, 0x0b5c473d, 0x1c26a370, 0x1de4c947,
+    0x1fa2771e, 0x1e601d29, 0x1b2f0bac, 0x1aed619b, 0x18abdfc2, 0x1969b5f5,
+    0x1235f2c8, 0x13f798ff, 0x11b126a6, 0x10734c91, 0x153c5a14, 0x14fe3023,
+    0x16b88e7a, 0x177ae44d, 0x384d46e0, 0x398f2cd7, 0x3bc9928e, 0x3a0bf8b9,
+    0x3f44ee3c, 0x3e86840b, 0x3cc03a52, 0x3d025065, 0x365e1758, 0x379c7d6f,
+    0x35dac336, 0x3418a901, 0x3157bf84, 0x3095d5b3, 0x32d36bea, 0x331101dd,
+    0x246be590, 0x25a98fa7, 0x27ef31fe, 0x262d5bc9, 0x23624d4c, 0x22a0277b,
+    0x20e69922, 0x2124f315, 0x2a78b428, 0x2bbade1f, 0x29fc6046, 0x283e0a71,
+    0x2d711cf4, 0x2cb376c3, 0x2ef5c89a, 0x2f37a2ad, 0x709a8dc0, 0x7158e7f7,
+    0x731e59ae, 0x72dc3399, 0x7793251c, 0x76514f2b, 0x7417f172, 0x75d59b45,
+    0x7e89dc78, 0x7f4bb64f, 0x7d0d0816, 0x7ccf6221, 0x798074a4, 0x78421e93,
+    0x7a04a0ca, 0x7bc6cafd, 0x6cbc2eb0, 0x6d7e4487, 0x6f38fade, 0x6efa90e9,
+    0x6bb5866c, 0x6a77ec5b, 0x68315202, 0x69f33835, 0x62af7f08, 0x636d153f,
+    0x612bab66, 0x60e9c151, 0x65a6d7d4, 0x6464bde3, 0x662203ba, 0x67e0698d,
+    0x48d7cb20, 0x4915a117, 0x4b531f4e, 0x4a917579, 0x4fde63fc, 0x4e1c09cb,
+    0x4c5ab792, 0x4d98dda5, 0x46c49a98, 0x4706f0af, 0x45404ef6, 0x448224c1,
+    0x41cd3244, 0x400f5873, 0x4249e62a, 0x438b8c1d, 0x54f16850, 0x55330267,
+    0x5775bc3e, 0x56b7d609, 0x53f8c08c, 0x523aaabb, 0x507c14e2, 0x51be7ed5,
+    0x5ae239e8, 0x5b2053df, 0x5966ed86, 0x58a487b1, 0x5deb9134, 0x5c29fb03,
+    0x5e6f455a, 0x5fad2f6d, 0xe1351b80, 0xe0f771b7, 0xe2b1cfee, 0xe373a5d9,
+    0xe63cb35c, 0xe7fed96b, 0xe5b86732, 0xe47a0d05, 0xef264a38, 0xeee4200f,
+    0xeca29e56, 0xed60f461, 0xe82fe2e4, 0xe9ed88d3, 0xebab368a, 0xea695cbd,
+    0xfd13b8f0, 0xfcd1d2c7, 0xfe976c9e, 0xff5506a9, 0xfa1a102c, 0xfbd87a1b,
+    0xf99ec442, 0xf85cae75, 0xf300e948, 0xf2c2837f, 0xf0843d26, 0xf1465711,
+    0xf4094194, 0xf5cb2ba3, 0xf78d95fa, 0xf64fffcd, 0xd9785d60, 0xd8ba3757,
+    0xdafc890e, 0xdb3ee339, 0xde71f5bc, 0xdfb39f8b, 0xddf521d2, 0xdc374be5,
+    0xd76b0cd8, 0xd6a966ef, 0xd4efd8b6, 0xd52db281, 0xd062a404, 0xd1a0ce33,
+    0xd3e6706a, 0xd2241a5d, 0xc55efe10, 0xc49c9427, 0xc6da2a7e, 0xc7184049,
+    0xc25756cc, 0xc3953cfb, 0xc1d382a2, 0xc011e895, 0xcb4dafa8, 0xca8fc59f,
+    0xc8c97bc6, 0xc90b11f1, 0xcc440774, 0xcd866d43, 0xcfc0d31a, 0xce02b92d,
+    0x91af9640, 0x906dfc77, 0x922b422e, 0x93e92819, 0x96a63e9c, 0x976454ab,
+    0x9522eaf2, 0x94e080c5, 0x9fbcc7f8, 0x9e7eadcf, 0x9c381396, 0x9dfa79a1,
+    0x98b56f24, 0x99770513, 0x9b31bb4a, 0x9af3d17d, 0x8d893530, 0x8c4b5f07,
+    0x8e0de15e, 0x8fcf8b69, 0x8a809dec, 0x8b42f7db, 0x89044982, 0x88c623b5,
+    0x839a6488, 0x82580ebf, 0x801eb0e6, 0x81dcdad1, 0x8493cc54, 0x8551a663,
+    0x8717183a, 0x86d5720d, 0xa9e2d0a0, 0xa820ba97, 0xaa6604ce, 0xaba46ef9,
+    0xaeeb787c, 0xaf29124b, 0xad6fac12, 0xacadc625, 0xa7f18118, 0xa633eb2f,
+    0xa4755576, 0xa5b73f41, 0xa0f829c4, 0xa13a43f3, 0xa37cfdaa, 0xa2be979d,
+    0xb5c473d0, 0xb40619e7, 0xb640a7be, 0xb782cd89, 0xb2cddb0c, 0xb30fb13b,
+    0xb1490f62, 0xb08b6555, 0xbbd72268, 0xba15485f, 0xb853f606, 0xb9919c31,
+    0xbcde8ab4, 0xbd1ce083, 0xbf5a5eda, 0xbe9834ed,
+  },
+  {
+    0x00000000, 0xb8bc6765, 0xaa09c88b, 0x12b5afee, 0x8f629757, 0x37def032,
+    0x256b5fdc, 0x9dd738b9, 0xc5b428ef, 0x7d084f8a, 0x6fbde064, 0xd7018701,
+    0x4ad6bfb8, 0xf26ad8dd, 0xe0df7733, 0x58631056, 0x5019579f, 0xe8a530fa,
+    0xfa109f14, 0x42acf871, 0xdf7bc0c8, 0x67c7a7ad, 0x75720843, 0xcdce6f26,
+    0x95ad7f70, 0x2d111815, 0x3fa4b7fb, 0x8718d09e, 0x1acfe827, 0xa2738f42,
+    0xb0c620ac, 0x087a47c9, 0xa032af3e, 0x188ec85b, 0x0a3b67b5, 0xb28700d0,
+    0x2f503869, 0x97ec5f0c, 0x8559f0e2, 0x3de59787, 0x658687d1, 0xdd3ae0b4,
+    0xcf8f4f5a, 0x7733283f, 0xeae41086, 0x525877e3, 0x40edd80d, 0xf851bf68,
+    0xf02bf8a1, 0x48979fc4, 0x5a22302a, 0xe29e574f, 0x7f496ff6, 0xc7f50893,
+    0xd540a77d, 0x6dfcc018, 0x359fd04e, 0x8d23b72b, 0x9f9618c5, 0x272a7fa0,
+    0xbafd4719, 0x0241207c, 0x10f48f92, 0xa848e8f7, 0x9b14583d, 0x23a83f58,
+    0x311d90b6, 0x89a1f7d3, 0x1476cf6a, 0xaccaa80f, 0xbe7f07e1, 0x06c36084,
+    0x5ea070d2, 0xe61c17b7, 0xf4a9b859, 0x4c15df3c, 0xd1c2e785, 0x697e80e0,
+    0x7bcb2f0e, 0xc377486b, 0xcb0d0fa2, 0x73b168c7, 0x6104c729, 0xd9b8a04c,
+    0x446f98f5, 0xfcd3ff90, 0xee66507e, 0x56da371b, 0x0eb9274d, 0xb6054028,
+    0xa4b0efc6, 0x1c0c88a3, 0x81dbb01a, 0x3967d77f, 0x2bd27891, 0x936e1ff4,
+    0x3b26f703, 0x839a9066, 0x912f3f88, 0x299358ed, 0xb4446054, 0x0cf80731,
+    0x1e4da8df, 0xa6f1cfba, 0xfe92dfec, 0x462eb889, 0x549b1767, 0xec277002,
+    0x71f048bb, 0xc94c2fde, 0xdbf98030, 0x6345e755, 0x6b3fa09c, 0xd383c7f9,
+    0xc1366817, 0x798a0f72, 0xe45d37cb, 0x5ce150ae, 0x4e54ff40, 0xf6e89825,
+    0xae8b8873, 0x1637ef16, 0x048240f8, 0xbc3e279d, 0x21e91f24, 0x99557841,
+    0x8be0d7af, 0x335cb0ca, 0xed59b63b, 0x55e5d15e, 0x47507eb0, 0xffec19d5,
+    0x623b216c, 0xda874609, 0xc832e9e7, 0x708e8e82, 0x28ed9ed4, 0x9051f9b1,
+    0x82e4565f, 0x3a58313a, 0xa78f0983, 0x1f336ee6, 0x0d86c108, 0xb53aa66d,
+    0xbd40e1a4, 0x05fc86c1, 0x1749292f, 0xaff54e4a, 0x322276f3, 0x8a9e1196,
+    0x982bbe78, 0x2097d91d, 0x78f4c94b, 0xc048ae2e, 0xd2fd01c0, 0x6a4166a5,
+    0xf7965e1c, 0x4f2a3979, 0x5d9f9697, 0xe523f1f2, 0x4d6b1905, 0xf5d77e60,
+    0xe762d18e, 0x5fdeb6eb, 0xc2098e52, 0x7ab5e937, 0x680046d9, 0xd0bc21bc,
+    0x88df31ea, 0x3063568f, 0x22d6f961, 0x9a6a9e04, 0x07bda6bd, 0xbf01c1d8,
+    0xadb46e36, 0x15080953, 0x1d724e9a, 0xa5ce29ff, 0xb77b8611, 0x0fc7e174,
+    0x9210d9cd, 0x2aacbea8, 0x38191146, 0x80a57623, 0xd8c66675, 0x607a0110,
+    0x72cfaefe, 0xca73c99b, 0x57a4f122, 0xef189647, 0xfdad39a9, 0x45115ecc,
+    0x764dee06, 0xcef18963, 0xdc44268d, 0x64f841e8, 0xf92f7951, 0x41931e34,
+    0x5326b1da, 0xeb9ad6bf, 0xb3f9c6e9, 0x0b45a18c, 0x19f00e62, 0xa14c6907,
+    0x3c9b51be, 0x842736db, 0x96929935, 0x2e2efe50, 0x2654b999, 0x9ee8defc,
+    0x8c5d7112, 0x34e11677, 0xa9362ece, 0x118a49ab, 0x033fe645, 0xbb838120,
+    0xe3e09176, 0x5b5cf613, 0x49e959fd, 0xf1553e98, 0x6c820621, 0xd43e6144,
+    0xc68bceaa, 0x7e37a9cf, 0xd67f4138, 0x6ec3265d, 0x7c7689b3, 0xc4caeed6,
+    0x591dd66f, 0xe1a1b10a, 0xf3141ee4, 0x4ba87981, 0x13cb69d7, 0xab770eb2,
+    0xb9c2a15c, 0x017ec639, 0x9ca9fe80, 0x241599e5, 0x36a0360b, 0x8e1c516e,
+    0x866616a7, 0x3eda71c2, 0x2c6fde2c, 0x94d3b949, 0x090481f0, 0xb1b8e695,
+    0xa30d497b, 0x1bb12e1e, 0x43d23e48, 0xfb6e592d, 0xe9dbf6c3, 0x516791a6,
+    0xccb0a91f, 0x740cce7a, 0x66b96194, 0xde0506f1,
+  },
+  {
+    0x00000000, 0x3d6029b0, 0x7ac05360, 0x47a07ad0, 0xf580a6c0, 0xc8e08f70,
+    0x8f40f5a0, 0xb220dc10, 0x30704bc1, 0x0d106271, 0x4ab018a1, 0x77d03111,
+    0xc5f0ed01, 0xf890c4b1, 0xbf30be61, 0x825097d1, 0x60e09782, 0x5d80be32,
+    0x1a20c4e2, 0x2740ed52, 0x95603142, 0xa80018f2, 0xefa06222, 0xd2c04b92,
+    0x5090dc43, 0x6df0f5f3, 0x2a508f23, 0x1730a693, 0xa5107a83, 0x98705333,
+    0xdfd029e3, 0xe2b00053, 0xc1c12f04, 0xfca106b4, 0xbb017c64, 0x866155d4,
+    0x344189c4, 0x0921a074, 0x4e81daa4, 0x73e1f314, 0xf1b164c5, 0xccd14d75,
+    0x8b7137a5, 0xb6111e15, 0x0431c205, 0x3951ebb5, 0x7ef19165, 0x4391b8d5,
+    0xa121b886, 0x9c419136, 0xdbe1ebe6, 0xe681c256, 0x54a11e46, 0x69c137f6,
+    0x2e614d26, 0x13016496, 0x9151f347, 0xac31daf7, 0xeb91a027, 0xd6f18997,
+    0x64d15587, 0x59b17c37, 0x1e1106e7, 0x23712f57, 0x58f35849, 0x659371f9,
+    0x22330b29, 0x1f532299, 0xad73fe89, 0x9013d739, 0xd7b3ade9, 0xead38459,
+    0x68831388, 0x55e33a38, 0x124340e8, 0x2f236958, 0x9d03b548, 0xa0639cf8,
+    0xe7c3e628, 0xdaa3cf98, 0x3813cfcb, 0x0573e67b, 0x42d39cab, 0x7fb3b51b,
+    0xcd93690b, 0xf0f340bb, 0xb7533a6b, 0x8a3313db, 0x0863840a, 0x3503adba,
+    0x72a3d76a, 0x4fc3feda, 0xfde322ca, 0xc0830b7a, 0x872371aa, 0xba43581a,
+    0x9932774d, 0xa4525efd, 0xe3f2242d, 0xde920d9d, 0x6cb2d18d, 0x51d2f83d,
+    0x167282ed, 0x2b12ab5d, 0xa9423c8c, 0x9422153c, 0xd3826fec, 0xeee2465c,
+    0x5cc29a4c, 0x61a2b3fc, 0x2602c92c, 0x1b62e09c, 0xf9d2e0cf, 0xc4b2c97f,
+    0x8312b3af, 0xbe729a1f, 0x0c52460f, 0x31326fbf, 0x7692156f, 0x4bf23cdf,
+    0xc9a2ab0e, 0xf4c282be, 0xb362f86e, 0x8e02d1de, 0x3c220dce, 0x0142247e,
+    0x46e25eae, 0x7b82771e, 0xb1e6b092, 0x8c869922, 0xcb26e3f2, 0xf646ca42,
+    0x44661652, 0x79063fe2, 0x3ea64532, 0x03c66c82, 0x8196fb53, 0xbcf6d2e3,
+    0xfb56a833, 0xc6368183, 0x74165d93, 0x49767423, 0x0ed60ef3, 0x33b62743,
+    0xd1062710, 0xec660ea0, 0xabc67470, 0x96a65dc0, 0x248681d0, 0x19e6a860,
+    0x5e46d2b0, 0x6326fb00, 0xe1766cd1, 0xdc164561, 0x9bb63fb1, 0xa6d61601,
+    0x14f6ca11, 0x2996e3a1, 0x6e369971, 0x5356b0c1, 0x70279f96, 0x4d47b626,
+    0x0ae7ccf6, 0x3787e546, 0x85a73956, 0xb8c710e6, 0xff676a36, 0xc2074386,
+    0x4057d457, 0x7d37fde7, 0x3a978737, 0x07f7ae87, 0xb5d77297, 0x88b75b27,
+    0xcf1721f7, 0xf2770847, 0x10c70814, 0x2da721a4, 0x6a075b74, 0x576772c4,
+    0xe547aed4, 0xd8278764, 0x9f87fdb4, 0xa2e7d404, 0x20b743d5, 0x1dd76a65,
+    0x5a7710b5, 0x67173905, 0xd537e515, 0xe857cca5, 0xaff7b675, 0x92979fc5,
+    0xe915e8db, 0xd475c16b, 0x93d5bbbb, 0xaeb5920b, 0x1c954e1b, 0x21f567ab,
+    0x66551d7b, 0x5b3534cb, 0xd965a31a, 0xe4058aaa, 0xa3a5f07a, 0x9ec5d9ca,
+    0x2ce505da, 0x11852c6a, 0x562556ba, 0x6b457f0a, 0x89f57f59, 0xb49556e9,
+    0xf3352c39, 0xce550589, 0x7c75d999, 0x4115f029, 0x06b58af9, 0x3bd5a349,
+    0xb9853498, 0x84e51d28, 0xc34567f8, 0xfe254e48, 0x4c059258, 0x7165bbe8,
+    0x36c5c138, 0x0ba5e888, 0x28d4c7df, 0x15b4ee6f, 0x521494bf, 0x6f74bd0f,
+    0xdd54611f, 0xe03448af, 0xa794327f, 0x9af41bcf, 0x18a48c1e, 0x25c4a5ae,
+    0x6264df7e, 0x5f04f6ce, 0xed242ade, 0xd044036e, 0x97e479be, 0xaa84500e,
+    0x4834505d, 0x755479ed, 0x32f4033d, 0x0f942a8d, 0xbdb4f69d, 0x80d4df2d,
+    0xc774a5fd, 0xfa148c4d, 0x78441b9c, 0x4524322c, 0x028448fc, 0x3fe4614c,
+    0x8dc4bd5c, 0xb0a494ec, 0xf704ee3c, 0xca64c78c,
+  },
+  {
+    0x00000000, 0xcb5cd3a5, 0x4dc8a10b, 0x869472ae, 0x9b914216, 0x50cd91b3,
+    0xd659e31d, 0x1d0530b8, 0xec53826d, 0x270f51c8, 0xa19b2366, 0x6ac7f0c3,
+    0x77c2c07b, 0xbc9e13de, 0x3a0a6170, 0xf156b2d5, 0x03d6029b, 0xc88ad13e,
+    0x4e1ea390, 0x85427035, 0x9847408d, 0x531b9328, 0xd58fe186, 0x1ed33223,
+    0xef8580f6, 0x24d95353, 0xa24d21fd, 0x6911f258, 0x7414c2e0, 0xbf481145,
+    0x39dc63eb, 0xf280b04e, 0x07ac0536, 0xccf0d693, 0x4a64a43d, 0x81387798,
+    0x9c3d4720, 0x57619485, 0xd1f5e62b, 0x1aa9358e, 0xebff875b, 0x20a354fe,
+    0xa6372650, 0x6d6bf5f5, 0x706ec54d, 0xbb3216e8, 0x3da66446, 0xf6fab7e3,
+    0x047a07ad, 0xcf26d408, 0x49b2a6a6, 0x82ee7503, 0x9feb45bb, 0x54b7961e,
+    0xd223e4b0, 0x197f3715, 0xe82985c0, 0x23755665, 0xa5e124cb, 0x6ebdf76e,
+    0x73b8c7d6, 0xb8e41473, 0x3e7066dd, 0xf52cb578, 0x0f580a6c, 0xc404d9c9,
+    0x4290ab67, 0x89cc78c2, 0x94c9487a, 0x5f959bdf, 0xd901e971, 0x125d3ad4,
+    0xe30b8801, 0x28575ba4, 0xaec3290a, 0x659ffaaf, 0x789aca17, 0xb3c619b2,
+    0x35526b1c, 0xfe0eb8b9, 0x0c8e08f7, 0xc7d2db52, 0x4146a9fc, 0x8a1a7a59,
+    0x971f4ae1, 0x5c439944, 0xdad7ebea, 0x118b384f, 0xe0dd8a9a, 0x2b81593f,
+    0xad152b91, 0x6649f834, 0x7b4cc88c, 0xb0101b29, 0x36846987, 0xfdd8ba22,
+    0x08f40f5a, 0xc3a8dcff, 0x453cae51, 0x8e607df4, 0x93654d4c, 0x58399ee9,
+    0xdeadec47, 0x15f13fe2, 0xe4a78d37, 0x2ffb5e92, 0xa96f2c3c, 0x6233ff99,
+    0x7f36cf21, 0xb46a1c84, 0x32fe6e2a, 0xf9a2bd8f, 0x0b220dc1, 0xc07ede64,
+    0x46eaacca, 0x8db67f6f, 0x90b34fd7, 0x5bef9c72, 0xdd7beedc, 0x16273d79,
+    0xe7718fac, 0x2c2d5c09, 0xaab92ea7, 0x61e5fd02, 0x7ce0cdba, 0xb7bc1e1f,
+    0x31286cb1, 0xfa74bf14, 0x1eb014d8, 0xd5ecc77d, 0x5378b5d3, 0x98246676,
+    0x852156ce, 0x4e7d856b, 0xc8e9f7c5, 0x03b52460, 0xf2e396b5, 0x39bf4510,
+    0xbf2b37be, 0x7477e41b, 0x6972d4a3, 0xa22e0706, 0x24ba75a8, 0xefe6a60d,
+    0x1d661643, 0xd63ac5e6, 0x50aeb748, 0x9bf264ed, 0x86f75455, 0x4dab87f0,
+    0xcb3ff55e, 0x006326fb, 0xf135942e, 0x3a69478b, 0xbcfd3525, 0x77a1e680,
+    0x6aa4d638, 0xa1f8059d, 0x276c7733, 0xec30a496, 0x191c11ee, 0xd240c24b,
+    0x54d4b0e5, 0x9f886340, 0x828d53f8, 0x49d1805d, 0xcf45f2f3, 0x04192156,
+    0xf54f9383, 0x3e134026, 0xb8873288, 0x73dbe12d, 0x6eded195, 0xa5820230,
+    0x2316709e, 0xe84aa33b, 0x1aca1375, 0xd196c0d0, 0x5702b27e, 0x9c5e61db,
+    0x815b5163, 0x4a0782c6, 0xcc93f068, 0x07cf23cd, 0xf6999118, 0x3dc542bd,
+    0xbb513013, 0x700de3b6, 0x6d08d30e, 0xa65400ab, 0x20c07205, 0xeb9ca1a0,
+    0x11e81eb4, 0xdab4cd11, 0x5c20bfbf, 0x977c6c1a, 0x8a795ca2, 0x41258f07,
+    0xc7b1fda9, 0x0ced2e0c, 0xfdbb9cd9, 0x36e74f7c, 0xb0733dd2, 0x7b2fee77,
+    0x662adecf, 0xad760d6a, 0x2be27fc4, 0xe0beac61, 0x123e1c2f, 0xd962cf8a,
+    0x5ff6bd24, 0x94aa6e81, 0x89af5e39, 0x42f38d9c, 0xc467ff32, 0x0f3b2c97,
+    0xfe6d9e42, 0x35314de7, 0xb3a53f49, 0x78f9ecec, 0x65fcdc54, 0xaea00ff1,
+    0x28347d5f, 0xe368aefa, 0x16441b82, 0xdd18c827, 0x5b8cba89, 0x90d0692c,
+    0x8dd55994, 0x46898a31, 0xc01df89f, 0x0b412b3a, 0xfa1799ef, 0x314b4a4a,
+    0xb7df38e4, 0x7c83eb41, 0x6186dbf9, 0xaada085c, 0x2c4e7af2, 0xe712a957,
+    0x15921919, 0xdececabc, 0x585ab812, 0x93066bb7, 0x8e035b0f, 0x455f88aa,
+    0xc3cbfa04, 0x089729a1, 0xf9c19b74, 0x329d48d1, 0xb4093a7f, 0x7f55e9da,
+    0x6250d962, 0xa90c0ac7, 0x2f987869, 0xe4c4abcc,
+  },
+  {
+    0x00000000, 0xa6770bb4, 0x979f1129, 0x31e81a9d, 0xf44f2413, 0x52382fa7,
+    0x63d0353a, 0xc5a73e8e, 0x33ef4e67, 0x959845d3, 0xa4705f4e, 0x020754fa,
+    0xc7a06a74, 0x61d761c0, 0x503f7b5d, 0xf64870e9, 0x67de9cce, 0xc1a9977a,
+    0xf0418de7, 0x56368653, 0x9391b8dd, 0x35e6b369, 0x040ea9f4, 0xa279a240,
+    0x5431d2a9, 0xf246d91d, 0xc3aec380, 0x65d9c834, 0xa07ef6ba, 0x0609fd0e,
+    0x37e1e793, 0x9196ec27, 0xcfbd399c, 0x69ca3228, 0x582228b5, 0xfe552301,
+    0x3bf21d8f, 0x9d85163b, 0xac6d0ca6, 0x0a1a0712, 0xfc5277fb, 0x5a257c4f,
+    0x6bcd66d2, 0xcdba6d66, 0x081d53e8, 0xae6a585c, 0x9f8242c1, 0x39f54975,
+    0xa863a552, 0x0e14aee6, 0x3ffcb47b, 0x998bbfcf, 0x5c2c8141, 0xfa5b8af5,
+    0xcbb39068, 0x6dc49bdc, 0x9b8ceb35, 0x3dfbe081, 0x0c13fa1c, 0xaa64f1a8,
+    0x6fc3cf26, 0xc9b4c492, 0xf85cde0f, 0x5e2bd5bb, 0x440b7579, 0xe27c7ecd,
+    0xd3946450, 0x75e36fe4, 0xb044516a, 0x16335ade, 0x27db4043, 0x81ac4bf7,
+    0x77e43b1e, 0xd19330aa, 0xe07b2a37, 0x460c2183, 0x83ab1f0d, 0x25dc14b9,
+    0x14340e24, 0xb2430590, 0x23d5e9b7, 0x85a2e203, 0xb44af89e, 0x123df32a,
+    0xd79acda4, 0x71edc610, 0x4005dc8d, 0xe672d739, 0x103aa7d0, 0xb64dac64,
+    0x87a5b6f9, 0x21d2bd4d, 0xe47583c3, 0x42028877, 0x73ea92ea, 0xd59d995e,
+    0x8bb64ce5, 0x2dc14751, 0x1c295dcc, 0xba5e5678, 0x7ff968f6, 0xd98e6342,
+    0xe86679df, 0x4e11726b, 0xb8590282, 0x1e2e0936, 0x2fc613ab, 0x89b1181f,
+    0x4c162691, 0xea612d25, 0xdb8937b8, 0x7dfe3c0c, 0xec68d02b, 0x4a1fdb9f,
+    0x7bf7c102, 0xdd80cab6, 0x1827f438, 0xbe50ff8c, 0x8fb8e511, 0x29cfeea5,
+    0xdf879e4c, 0x79f095f8, 0x48188f65, 0xee6f84d1, 0x2bc8ba5f, 0x8dbfb1eb,
+    0xbc57ab76, 0x1a20a0c2, 0x8816eaf2, 0x2e61e146, 0x1f89fbdb, 0xb9fef06f,
+    0x7c59cee1, 0xda2ec555, 0xebc6dfc8, 0x4db1d47c, 0xbbf9a495, 0x1d8eaf21,
+    0x2c66b5bc, 0x8a11be08, 0x4fb68086, 0xe9c18b32, 0xd82991af, 0x7e5e9a1b,
+    0xefc8763c, 0x49bf7d88, 0x78576715, 0xde206ca1, 0x1b87522f, 0xbdf0599b,
+    0x8c184306, 0x2a6f48b2, 0xdc27385b, 0x7a5033ef, 0x4bb82972, 0xedcf22c6,
+    0x28681c48, 0x8e1f17fc, 0xbff70d61, 0x198006d5, 0x47abd36e, 0xe1dcd8da,
+    0xd034c247, 0x7643c9f3, 0xb3e4f77d, 0x1593fcc9, 0x247be654, 0x820cede0,
+    0x74449d09, 0xd23396bd, 0xe3db8c20, 0x45ac8794, 0x800bb91a, 0x267cb2ae,
+    0x1794a833, 0xb1e3a387, 0x20754fa0, 0x86024414, 0xb7ea5e89, 0x119d553d,
+    0xd43a6bb3, 0x724d6007, 0x43a57a9a, 0xe5d2712e, 0x139a01c7, 0xb5ed0a73,
+    0x840510ee, 0x22721b5a, 0xe7d525d4, 0x41a22e60, 0x704a34fd, 0xd63d3f49,
+    0xcc1d9f8b, 0x6a6a943f, 0x5b828ea2, 0xfdf58516, 0x3852bb98, 0x9e25b02c,
+    0xafcdaab1, 0x09baa105, 0xfff2d1ec, 0x5985da58, 0x686dc0c5, 0xce1acb71,
+    0x0bbdf5ff, 0xadcafe4b, 0x9c22e4d6, 0x3a55ef62, 0xabc30345, 0x0db408f1,
+    0x3c5c126c, 0x9a2b19d8, 0x5f8c2756, 0xf9fb2ce2, 0xc813367f, 0x6e643dcb,
+    0x982c4d22, 0x3e5b4696, 0x0fb35c0b, 0xa9c457bf, 0x6c636931, 0xca146285,
+    0xfbfc7818, 0x5d8b73ac, 0x03a0a617, 0xa5d7ada3, 0x943fb73e, 0x3248bc8a,
+    0xf7ef8204, 0x519889b0, 0x6070932d, 0xc6079899, 0x304fe870, 0x9638e3c4,
+    0xa7d0f959, 0x01a7f2ed, 0xc400cc63, 0x6277c7d7, 0x539fdd4a, 0xf5e8d6fe,
+    0x647e3ad9, 0xc209316d, 0xf3e12bf0, 0x55962044, 0x90311eca, 0x3646157e,
+    0x07ae0fe3, 0xa1d90457, 0x579174be, 0xf1e67f0a, 0xc00e6597, 0x66796e23,
+    0xa3de50ad, 0x05a95b19, 0x34414184, 0x92364a30,
+  },
+  {
+    0x00000000, 0xccaa009e, 0x4225077d, 0x8e8f07e3, 0x844a0efa, 0x48e00e64,
+    0xc66f0987, 0x0ac50919, 0xd3e51bb5, 0x1f4f1b2b, 0x91c01cc8, 0x5d6a1c56,
+    0x57af154f, 0x9b0515d1, 0x158a1232, 0xd92012ac, 0x7cbb312b, 0xb01131b5,
+    0x3e9e3656, 0xf23436c8, 0xf8f13fd1, 0x345b3f4f, 0xbad438ac, 0x767e3832,
+    0xaf5e2a9e, 0x63f42a00, 0xed7b2de3, 0x21d12d7d, 0x2b142464, 0xe7be24fa,
+    0x69312319, 0xa59b2387, 0xf9766256, 0x35dc62c8, 0xbb53652b, 0x77f965b5,
+    0x7d3c6cac, 0xb1966c32, 0x3f196bd1, 0xf3b36b4f, 0x2a9379e3, 0xe639797d,
+    0x68b67e9e, 0xa41c7e00, 0xaed97719, 0x62737787, 0xecfc7064, 0x205670fa,
+    0x85cd537d, 0x496753e3, 0xc7e85400, 0x0b42549e, 0x01875d87, 0xcd2d5d19,
+    0x43a25afa, 0x8f085a64, 0x562848c8, 0x9a824856, 0x140d4fb5, 0xd8a74f2b,
+    0xd2624632, 0x1ec846ac, 0x9047414f, 0x5ced41d1, 0x299dc2ed, 0xe537c273,
+    0x6bb8c590, 0xa712c50e, 0xadd7cc17, 0x617dcc89, 0xeff2cb6a, 0x2358cbf4,
+    0xfa78d958, 0x36d2d9c6, 0xb85dde25, 0x74f7debb, 0x7e32d7a2, 0xb298d73c,
+    0x3c17d0df, 0xf0bdd041, 0x5526f3c6, 0x998cf358, 0x1703f4bb, 0xdba9f425,
+    0xd16cfd3c, 0x1dc6fda2, 0x9349fa41, 0x5fe3fadf, 0x86c3e873, 0x4a69e8ed,
+    0xc4e6ef0e, 0x084cef90, 0x0289e689, 0xce23e617, 0x40ace1f4, 0x8c06e16a,
+    0xd0eba0bb, 0x1c41a025, 0x92cea7c6, 0x5e64a758, 0x54a1ae41, 0x980baedf,
+    0x1684a93c, 0xda2ea9a2, 0x030ebb0e, 0xcfa4bb90, 0x412bbc73, 0x8d81bced,
+    0x8744b5f4, 0x4beeb56a, 0xc561b289, 0x09cbb217, 0xac509190, 0x60fa910e,
+    0xee7596ed, 0x22df9673, 0x281a9f6a, 0xe4b09ff4, 0x6a3f9817, 0xa6959889,
+    0x7fb58a25, 0xb31f8abb, 0x3d908d58, 0xf13a8dc6, 0xfbff84df, 0x37558441,
+    0xb9da83a2, 0x7570833c, 0x533b85da, 0x9f918544, 0x111e82a7, 0xddb48239,
+    0xd7718b20, 0x1bdb8bbe, 0x95548c5d, 0x59fe8cc3, 0x80de9e6f, 0x4c749ef1,
+    0xc2fb9912, 0x0e51998c, 0x04949095, 0xc83e900b, 0x46b197e8, 0x8a1b9776,
+    0x2f80b4f1, 0xe32ab46f, 0x6da5b38c, 0xa10fb312, 0xabcaba0b, 0x6760ba95,
+    0xe9efbd76, 0x2545bde8, 0xfc65af44, 0x30cfafda, 0xbe40a839, 0x72eaa8a7,
+    0x782fa1be, 0xb485a120, 0x3a0aa6c3, 0xf6a0a65d, 0xaa4de78c, 0x66e7e712,
+    0xe868e0f1, 0x24c2e06f, 0x2e07e976, 0xe2ade9e8, 0x6c22ee0b, 0xa088ee95,
+    0x79a8fc39, 0xb502fca7, 0x3b8dfb44, 0xf727fbda, 0xfde2f2c3, 0x3148f25d,
+    0xbfc7f5be, 0x736df520, 0xd6f6d6a7, 0x1a5cd639, 0x94d3d1da, 0x5879d144,
+    0x52bcd85d, 0x9e16d8c3, 0x1099df20, 0xdc33dfbe, 0x0513cd12, 0xc9b9cd8c,
+    0x4736ca6f, 0x8b9ccaf1, 0x8159c3e8, 0x4df3c376, 0xc37cc495, 0x0fd6c40b,
+    0x7aa64737, 0xb60c47a9, 0x3883404a, 0xf42940d4, 0xfeec49cd, 0x32464953,
+    0xbcc94eb0, 0x70634e2e, 0xa9435c82, 0x65e95c1c, 0xeb665bff, 0x27cc5b61,
+    0x2d095278, 0xe1a352e6, 0x6f2c5505, 0xa386559b, 0x061d761c, 0xcab77682,
+    0x44387161, 0x889271ff, 0x825778e6, 0x4efd7878, 0xc0727f9b, 0x0cd87f05,
+    0xd5f86da9, 0x19526d37, 0x97dd6ad4, 0x5b776a4a, 0x51b26353, 0x9d1863cd,
+    0x1397642e, 0xdf3d64b0, 0x83d02561, 0x4f7a25ff, 0xc1f5221c, 0x0d5f2282,
+    0x079a2b9b, 0xcb302b05, 0x45bf2ce6, 0x89152c78, 0x50353ed4, 0x9c9f3e4a,
+    0x121039a9, 0xdeba3937, 0xd47f302e, 0x18d530b0, 0x965a3753, 0x5af037cd,
+    0xff6b144a, 0x33c114d4, 0xbd4e1337, 0x71e413a9, 0x7b211ab0, 0xb78b1a2e,
+    0x39041dcd, 0xf5ae1d53, 0x2c8e0fff, 0xe0240f61, 0x6eab0882, 0xa201081c,
+    0xa8c40105, 0x646e019b, 0xeae10678, 0x264b06e6,
+  },
+};
+
+#ifdef HAVE_PCLMUL
+
+/* Compute the CRC-32 of BUF/LEN using carry-less multiplication, as
+   described in Gopal et al., "Fast CRC Computation for Generic
+   Polynomials Using PCLMULQDQ Instruction".  CRC is the inverted
+   value, as in elf_crc32.  LEN must be at least 64 and a multiple of
+   16.  */
+
+static uint32_t __attribute__ ((target ("pclmul,sse4.1")))
+elf_crc32_pclmul (uint32_t crc, const unsigned char *buf, size_t len)
+{
+  const __m128i k1k2 = _mm_set_epi64x (0x01c6e41596, 0x0154442bd4);
+  const __m128i k3k4 = _mm_set_epi64x (0x00ccaa009e, 0x01751997d0);
+  const __m128i k5k0 = _mm_set_epi64x (0, 0x0163cd6124);
+  const __m128i poly = _mm_set_epi64x (0x01f7011641, 0x01db710641);
+  const __m128i mask32 = _mm_setr_epi32 (~0, 0, ~0, 0);
+  __m128i x1, x2, x3, x4, x5, x6, x7, x8;
+
+  x1 = _mm_loadu_si128 ((const __m128i *) (buf + 0x00));
+  x2 = _mm_loadu_si128 ((const __m128i *) (buf + 0x10));
+  x3 = _mm_loadu_si128 ((const __m128i *) (buf + 0x20));
+  x4 = _mm_loadu_si128 ((const __m128i *) (buf + 0x30));
+  x1 = _mm_xor_si128 (x1, _mm_cvtsi32_si128 ((int) crc));
+  buf += 64;
+  len -= 64;
+
+  /* Fold 64 bytes at a time into four 128-bit accumulators.  */
+  while (len >= 64)
+    {
+      x5 = _mm_clmulepi64_si128 (x1, k1k2, 0x00);
+      x6 = _mm_clmulepi64_si128 (x2, k1k2, 0x00);
+      x7 = _mm_clmulepi64_si128 (x3, k1k2, 0x00);
+      x8 = _mm_clmulepi64_si128 (x4, k1k2, 0x00);
+      x1 = _mm_clmulepi64_si128 (x1, k1k2, 0x11);
+      x2 = _mm_clmulepi64_si128 (x2, k1k2, 0x11);
+      x3 = _mm_clmulepi64_si128 (x3, k1k2, 0x11);
+      x4 = _mm_clmulepi64_si128 (x4, k1k2, 0x11);
+      x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x5),
+			  _mm_loadu_si128 ((const __m128i *) (buf + 0x00)));
+      x2 = _mm_xor_si128 (_mm_xor_si128 (x2, x6),
+			  _mm_loadu_si128 ((const __m128i *) (buf + 0x10)));
+      x3 = _mm_xor_si128 (_mm_xor_si128 (x3, x7),
+			  _mm_loadu_si128 ((const __m128i *) (buf + 0x20)));
+      x4 = _mm_xor_si128 (_mm_xor_si128 (x4, x8),
+			  _mm_loadu_si128 ((const __m128i *) (buf + 0x30)));
+      buf += 64;
+      len -= 64;
+    }
+
+  /* Fold the accumulators into one, then fold in any remaining 16
+     byte blocks.  */
+  x5 = _mm_clmulepi64_si128 (x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128 (x1, k3k4, 0x11);
+  x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x2), x5);
+  x5 = _mm_clmulepi64_si128 (x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128 (x1, k3k4, 0x11);
+  x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x3), x5);
+  x5 = _mm_clmulepi64_si128 (x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128 (x1, k3k4, 0x11);
+  x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x4), x5);
+  while (len >= 16)
+    {
+      x5 = _mm_clmulepi64_si128 (x1, k3k4, 0x00);
+      x1 = _mm_clmulepi64_si128 (x1, k3k4, 0x11);
+      x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x5),
+			  _mm_loadu_si128 ((const __m128i *) buf));
+      buf += 16;
+      len -= 16;
+    }
+
+  /* Fold 128 bits down to 64.  */
+  x2 = _mm_clmulepi64_si128 (x1, k3k4, 0x10);
+  x1 = _mm_xor_si128 (_mm_srli_si128 (x1, 8), x2);
+  x2 = _mm_srli_si128 (x1, 4);
+  x1 = _mm_and_si128 (x1, mask32);
+  x1 = _mm_clmulepi64_si128 (x1, k5k0, 0x00);
+  x1 = _mm_xor_si128 (x1, x2);
+
+  /* Barrett reduction to 32 bits.  */
+  x2 = _mm_and_si128 (x1, mask32);
+  x2 = _mm_clmulepi64_si128 (x2, poly, 0x10);
+  x2 = _mm_and_si128 (x2, mask32);
+  x2 = _mm_clmulepi64_si128 (x2, poly, 0x00);
+  x1 = _mm_xor_si128 (x1, x2);
+
+  return (uint32_t) _mm_extract_epi32 (x1, 1);
+}
+
+#endif /* HAVE_PCLMUL */
+
 /* Compute the CRC-32 of BUF/LEN.  This uses the CRC used for
    .gnu_debuglink files.  */
 
 static uint32_t
 elf_crc32 (uint32_t crc, const unsigned char *buf, size_t len)
 {
-  static const uint32_t crc32_table[256] =
-    {
-      0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419,
-      0x706af48f, 0xe963a535, 0x9e6495a3, 0x0edb8832, 0x79dcb8a4,
-      0xe0d5e91e, 0x97d2d988, 0x09b64c2b, 0x7eb17cbd, 0xe7b82d07,
-      0x90bf1d91, 0x1db71064, 0x6ab020f2, 0xf3b97148, 0x84be41de,
-      0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7, 0x136c9856,
-      0x646ba8c0, 0xfd62f97a, 0x8a65c9ec, 0x14015c4f, 0x63066cd9,
-      0xfa0f3d63, 0x8d080df5, 0x3b6e20c8, 0x4c69105e, 0xd56041e4,
-      0xa2677172, 0x3c03e4d1, 0x4b04d447, 0xd20d85fd, 0xa50ab56b,
-      0x35b5a8fa, 0x42b2986c, 0xdbbbc9d6, 0xacbcf940, 0x32d86ce3,
-      0x45df5c75, 0xdcd60dcf, 0xabd13d59, 0x26d930ac, 0x51de003a,
-      0xc8d75180, 0xbfd06116, 0x21b4f4b5, 0x56b3c423, 0xcfba9599,
-      0xb8bda50f, 0x2802b89e, 0x5f058808, 0xc60cd9b2, 0xb10be924,
-      0x2f6f7c87, 0x58684c11, 0xc1611dab, 0xb6662d3d, 0x76dc4190,
-      0x01db7106, 0x98d220bc, 0xefd5102a, 0x71b18589, 0x06b6b51f,
-      0x9fbfe4a5, 0xe8b8d433, 0x7807c9a2, 0x0f00f934, 0x9609a88e,
-      0xe10e9818, 0x7f6a0dbb, 0x086d3d2d, 0x91646c97, 0xe6635c01,
-      0x6b6b51f4, 0x1c6c6162, 0x856530d8, 0xf262004e, 0x6c0695ed,
-      0x1b01a57b, 0x8208f4c1, 0xf50fc457, 0x65b0d9c6, 0x12b7e950,
-      0x8bbeb8ea, 0xfcb9887c, 0x62dd1ddf, 0x15da2d49, 0x8cd37cf3,
-      0xfbd44c65, 0x4db26158, 0x3ab551ce, 0xa3bc0074, 0xd4bb30e2,
-      0x4adfa541, 0x3dd895d7, 0xa4d1c46d, 0xd3d6f4fb, 0x4369e96a,
-      0x346ed9fc, 0xad678846, 0xda60b8d0, 0x44042d73, 0x33031de5,
-      0xaa0a4c5f, 0xdd0d7cc9, 0x5005713c, 0x270241aa, 0xbe0b1010,
-      0xc90c2086, 0x5768b525, 0x206f85b3, 0xb966d409, 0xce61e49f,
-      0x5edef90e, 0x29d9c998, 0xb0d09822, 0xc7d7a8b4, 0x59b33d17,
-      0x2eb40d81, 0xb7bd5c3b, 0xc0ba6cad, 0xedb88320, 0x9abfb3b6,
-      0x03b6e20c, 0x74b1d29a, 0xead54739, 0x9dd277af, 0x04db2615,
-      0x73dc1683, 0xe3630b12, 0x94643b84, 0x0d6d6a3e, 0x7a6a5aa8,
-      0xe40ecf0b, 0x9309ff9d, 0x0a00ae27, 0x7d079eb1, 0xf00f9344,
-      0x8708a3d2, 0x1e01f268, 0x6906c2fe, 0xf762575d, 0x806567cb,
-      0x196c3671, 0x6e6b06e7, 0xfed41b76, 0x89d32be0, 0x10da7a5a,
-      0x67dd4acc, 0xf9b9df6f, 0x8ebeeff9, 0x17b7be43, 0x60b08ed5,
-      0xd6d6a3e8, 0xa1d1937e, 0x38d8c2c4, 0x4fdff252, 0xd1bb67f1,
-      0xa6bc5767, 0x3fb506dd, 0x48b2364b, 0xd80d2bda, 0xaf0a1b4c,
-      0x36034af6, 0x41047a60, 0xdf60efc3, 0xa867df55, 0x316e8eef,
-      0x4669be79, 0xcb61b38c, 0xbc66831a, 0x256fd2a0, 0x5268e236,
-      0xcc0c7795, 0xbb0b4703, 0x220216b9, 0x5505262f, 0xc5ba3bbe,
-      0xb2bd0b28, 0x2bb45a92, 0x5cb36a04, 0xc2d7ffa7, 0xb5d0cf31,
-      0x2cd99e8b, 0x5bdeae1d, 0x9b64c2b0, 0xec63f226, 0x756aa39c,
-      0x026d930a, 0x9c0906a9, 0xeb0e363f, 0x72076785, 0x05005713,
-      0x95bf4a82, 0xe2b87a14, 0x7bb12bae, 0x0cb61b38, 0x92d28e9b,
-      0xe5d5be0d, 0x7cdcefb7, 0x0bdbdf21, 0x86d3d2d4, 0xf1d4e242,
-      0x68ddb3f8, 0x1fda836e, 0x81be16cd, 0xf6b9265b, 0x6fb077e1,
-      0x18b74777, 0x88085ae6, 0xff0f6a70, 0x66063bca, 0x11010b5c,
-      0x8f659eff, 0xf862ae69, 0x616bffd3, 0x166ccf45, 0xa00ae278,
-      0xd70dd2ee, 0x4e048354, 0x3903b3c2, 0xa7672661, 0xd06016f7,
-      0x4969474d, 0x3e6e77db, 0xaed16a4a, 0xd9d65adc, 0x40df0b66,
-      0x37d83bf0, 0xa9bcae53, 0xdebb9ec5, 0x47b2cf7f, 0x30b5ffe9,
-      0xbdbdf21c, 0xcabac28a, 0x53b39330, 0x24b4a3a6, 0xbad03605,
-      0xcdd70693, 0x54de5729, 0x23d967bf, 0xb3667a2e, 0xc4614ab8,
-      0x5d681b02, 0x2a6f2b94, 0xb40bbe37, 0xc30c8ea1, 0x5a05df1b,
-      0x2d02ef8d
-    };
   const unsigned char *end;
 
   crc = ~crc;
+
+#ifdef HAVE_PCLMUL
+  if (len >= 64
+      && __builtin_cpu_supports ("pclmul")
+      && __builtin_cpu_supports ("sse4.1"))
+    {
+      size_t fold;
+
+      fold = len & ~(size_t) 15;
+      crc = elf_crc32_pclmul (crc, buf, fold);
+      buf += fold;
+      len -= fold;
+    }
+#endif
+
+  /* Slicing by 8: each table lookup gives the contribution of one
+     byte followed by the remaining bytes of the group.  */
+  while (len >= 8)
+    {
+      uint32_t one;
+      uint32_t two;
+
+      one = crc ^ ((uint32_t) buf[0]
+		   | ((uint32_t) buf[1] << 8)
+		   | ((uint32_t) buf[2] << 16)
+		   | ((uint32_t) buf[3] << 24));
+      two = ((uint32_t) buf[4]
+	     | ((uint32_t) buf[5] << 8)
+	     | ((uint32_t) buf[6] << 16)
+	     | ((uint32_t) buf[7] << 24));
+      crc = (elf_crc32_tables[7][one & 0xff]
+	     ^ elf_crc32_tables[6][(one >> 8) & 0xff]
+	     ^ elf_crc32_tables[5][(one >> 16) & 0xff]
+	     ^ elf_crc32_tables[4][one >> 24]
+	     ^ elf_crc32_tables[3][two & 0xff]
+	     ^ elf_crc32_tables[2][(two >> 8) & 0xff]
+	     ^ elf_crc32_tables[1][(two >> 16) & 0xff]
+	     ^ elf_crc32_tables[0][two >> 24]);
+      buf += 8;
+      len -= 8;
+    }
+
   for (end = buf + len; buf < end; ++ buf)
-    crc = crc32_table[(crc ^ *buf) & 0xff] ^ (crc >> 8);
+    crc = elf_crc32_tables[0][(crc ^ *buf) & 0xff] ^ (crc >> 8);
   return ~crc;
 }
 
@@ -711,6 +1217,7 @@ elf_initialize_syminfo (struct backtrace_state *state,
   sdata->next = NULL;
   sdata->symbols = elf_symbols;
   sdata->count = elf_symbol_count;
+  sdata->dwarf = NULL;
 
   return 1;
 }
@@ -757,13 +1264,12 @@ elf_add_syminfo_data (struct backtrace_state *state,
     }
 }
 
-/* Return the symbol name and value for an ADDR.  */
+/* Find the symbol for ADDR.  Set *PEDATA to the module it was found
+   in.  Returns NULL if there is no symbol.  */
 
-static void
-elf_syminfo (struct backtrace_state *state, uintptr_t addr,
-	     backtrace_syminfo_callback callback,
-	     backtrace_error_callback error_callback ATTRIBUTE_UNUSED,
-	     void *data)
+static struct elf_symbol *
+elf_find_symbol (struct backtrace_state *state, uintptr_t addr,
+		 struct elf_syminfo_data **pedata)
 {
   struct elf_syminfo_data *edata;
   struct elf_symbol *sym = NULL;
@@ -802,12 +1308,139 @@ elf_syminfo (struct backtrace_state *state, uintptr_t addr,
 	}
     }
 
+  *pedata = edata;
+  return sym;
+}
+
+/* Return the symbol name and value for an ADDR.  */
+
+static void
+elf_syminfo (struct backtrace_state *state, uintptr_t addr,
+	     backtrace_syminfo_callback callback,
+	     backtrace_error_callback error_callback ATTRIBUTE_UNUSED,
+	     void *data)
+{
+  struct elf_syminfo_data *edata;
+  struct elf_symbol *sym;
+
+  sym = elf_find_symbol (state, addr, &edata);
   if (sym == NULL)
     callback (data, addr, NULL, 0, 0);
   else
     callback (data, addr, sym->name, sym->address, sym->size);
 }
 
+/* Data passed through elf_resolve_callback.  */
+
+struct elf_resolve_data
+{
+  backtrace_resolve_callback callback;
+  backtrace_error_callback error_callback;
+  void *data;
+  /* The symbol for the PC, or NULL.  */
+  struct elf_symbol *sym;
+};
+
+/* Add the symbol to the file/line information for one frame.  */
+
+static int
+elf_resolve_callback (void *data, uintptr_t pc, const char *filename,
+		      int lineno, const char *function)
+{
+  struct elf_resolve_data *rdata = (struct elf_resolve_data *) data;
+  struct elf_symbol *sym;
+
+  sym = rdata->sym;
+  if (sym == NULL)
+    return rdata->callback (rdata->data, pc, filename, lineno, function,
+			    NULL, 0, 0);
+  return rdata->callback (rdata->data, pc, filename, lineno, function,
+			  sym->name, sym->address, sym->size);
+}
+
+/* Pass an error to the caller of elf_resolve.  */
+
+static void
+elf_resolve_error_callback (void *data, const char *msg, int errnum)
+{
+  struct elf_resolve_data *rdata = (struct elf_resolve_data *) data;
+
+  rdata->error_callback (rdata->data, msg, errnum);
+}
+
+/* Return the file/line and symbol information for PC.  The symbol
+   table search tells us which module PC is in, so usually only that
+   module's DWARF data is searched.  The pairing of symbol table and
+   DWARF data is remembered in the symbol table data once a lookup
+   succeeds.  If the paired DWARF data does not have PC, only the
+   other modules whose DWARF data spans PC are searched.  */
+
+static int
+elf_resolve (struct backtrace_state *state, uintptr_t pc,
+	     backtrace_resolve_callback callback,
+	     backtrace_error_callback error_callback, void *data)
+{
+  struct elf_syminfo_data *edata;
+  struct elf_resolve_data rdata;
+  struct dwarf_data *cached;
+  struct dwarf_data *ddata;
+  int found;
+  int ret;
+
+  rdata.callback = callback;
+  rdata.error_callback = error_callback;
+  rdata.data = data;
+  rdata.sym = elf_find_symbol (state, pc, &edata);
+  if (rdata.sym == NULL)
+    return state->fileline_fn (state, pc, elf_resolve_callback,
+			       elf_resolve_error_callback, &rdata);
+
+  if (!state->threaded)
+    cached = edata->dwarf;
+  else
+    cached = backtrace_atomic_load_pointer (&edata->dwarf);
+
+  if (cached != NULL)
+    {
+      ret = backtrace_dwarf_lookup (state, cached, pc, elf_resolve_callback,
+				    elf_resolve_error_callback, &rdata,
+				    &found);
+      if (ret != 0 || found)
+	return ret;
+    }
+
+  /* The address ranges of modules can overlap, and the code named by
+     one symbol table need not all be described by one module's DWARF
+     data, so try each module whose range spans PC.  For a module
+     without DWARF data, such as a stripped library, there is usually
+     none, and this is only a few comparisons per module.  */
+  for (ddata = backtrace_dwarf_find (state, NULL, pc);
+       ddata != NULL;
+       ddata = backtrace_dwarf_find (state, ddata, pc))
+    {
+      if (ddata == cached)
+	continue;
+      ret = backtrace_dwarf_lookup (state, ddata, pc, elf_resolve_callback,
+				    elf_resolve_error_callback, &rdata,
+				    &found);
+      if (ret != 0)
+	return ret;
+      if (found)
+	{
+	  if (cached == NULL && !state->frozen)
+	    {
+	      if (!state->threaded)
+		edata->dwarf = ddata;
+	      else
+		backtrace_atomic_store_pointer (&edata->dwarf, ddata);
+	    }
+	  return 0;
+	}
+    }
+
+  return elf_resolve_callback (&rdata, pc, NULL, 0, NULL);
+}
+
 /* Return whether FILENAME is a symlink.  */
 
 static int
@@ -857,6 +1490,79 @@ elf_readlink (struct backtrace_state *state, const char *filename,
     }
 }
 
+/* A directory that may hold separate debug info files, and whether it
+   exists.  Most systems have no separate debug info for most modules,
+   and often no debug directories at all, so remembering which
+   directories are missing saves an open call per candidate file per
+   module.  */
+
+struct elf_debug_dir
+{
+  /* The next directory.  */
+  struct elf_debug_dir *next;
+  /* The directory name, ending with a slash.  */
+  char *name;
+  /* The length of NAME.  */
+  size_t len;
+  /* Whether the directory exists.  */
+  int exists;
+};
+
+/* Report whether the directory DIR, of length LEN and ending with a
+   slash, exists.  The result is remembered in STATE.  Returns 1 if we
+   can't tell, so that the caller goes ahead and tries the file.  */
+
+static int
+elf_debug_dir_exists (struct backtrace_state *state, const char *dir,
+		      size_t len)
+{
+  struct elf_debug_dir *p;
+  struct stat st;
+
+  if (!state->threaded)
+    p = (struct elf_debug_dir *) state->debug_dir_data;
+  else
+    p = backtrace_atomic_load_pointer (&state->debug_dir_data);
+  for (; p != NULL; p = p->next)
+    {
+      if (p->len == len && memcmp (p->name, dir, len) == 0)
+	return p->exists;
+    }
+
+  p = ((struct elf_debug_dir *)
+       backtrace_alloc (state, sizeof *p + len + 1, NULL, NULL));
+  if (p == NULL)
+    return 1;
+  p->name = (char *) (p + 1);
+  memcpy (p->name, dir, len);
+  p->name[len] = '\0';
+  p->len = len;
+  p->exists = stat (p->name, &st) == 0 && S_ISDIR (st.st_mode);
+
+  if (!state->threaded)
+    {
+      p->next = (struct elf_debug_dir *) state->debug_dir_data;
+      state->debug_dir_data = p;
+    }
+  else
+    {
+      /* Entries are never removed, so pushing on the front of the
+	 list is safe.  If two threads check the same directory, both
+	 entries are kept.  */
+      while (1)
+	{
+	  struct elf_debug_dir *head;
+
+	  head = backtrace_atomic_load_pointer (&state->debug_dir_data);
+	  p->next = head;
+	  if (__sync_bool_compare_and_swap (&state->debug_dir_data, head, p))
+	    break;
+	}
+    }
+
+  return p->exists;
+}
+
 #define SYSTEM_BUILD_ID_DIR "/usr/lib/debug/.build-id/"
 
 /* Open a separate debug info file, using the build ID to find it.
@@ -906,7 +1612,14 @@ elf_open_debugfile_by_buildid (struct backtrace_state *state,
   memcpy (t, suffix, suffix_len);
   t[suffix_len] = '\0';
 
-  ret = backtrace_open (bd_filename, error_callback, data, &does_not_exist);
+  /* Skip the open if there is no build ID directory, or no
+     subdirectory for the first byte of this build ID.  */
+  if (!elf_debug_dir_exists (state, bd_filename, prefix_len)
+      || !elf_debug_dir_exists (state, bd_filename, prefix_len + 3))
+    ret = -1;
+  else
+    ret = backtrace_open (bd_filename, error_callback, data,
+			  &does_not_exist);
 
   backtrace_free (state, bd_filename, len, error_callback, data);
 
@@ -930,6 +1643,7 @@ elf_try_debugfile (struct backtrace_state *state, const char *prefix,
   size_t debuglink_len;
   size_t try_len;
   char *try;
+  const char *slash;
   int does_not_exist;
   int ret;
 
@@ -944,7 +1658,11 @@ elf_try_debugfile (struct backtrace_state *state, const char *prefix,
   memcpy (try + prefix_len + prefix2_len, debuglink_name, debuglink_len);
   try[prefix_len + prefix2_len + debuglink_len] = '\0';
 
-  ret = backtrace_open (try, error_callback, data, &does_not_exist);
+  slash = strrchr (try, '/');
+  if (slash != NULL && !elf_debug_dir_exists (state, try, slash - try + 1))
+    ret = -1;
+  else
+    ret = backtrace_open (try, error_callback, data, &does_not_exist);
 
   backtrace_free (state, try, try_len, error_callback, data);
 
@@ -1163,10 +1881,43 @@ elf_fetch_bits (const unsigned char **ppin, const unsigned char *pinend,
   return 1;
 }
 
+/* Near the start of a zstd bitstream, where elf_fetch_bits_backward can't
+   read a whole word, read a byte at a time so that we never read before
+   PINEND.  This is kept out of line so that the common case stays small
+   enough to inline.  */
+
+static void __attribute__ ((noinline))
+elf_fetch_bytes_backward (const unsigned char **ppin,
+			  const unsigned char *pinend,
+			  uint64_t *pval, unsigned int *pbits)
+{
+  const unsigned char *pin;
+  uint64_t val;
+  unsigned int bits;
+
+  pin = *ppin;
+  val = *pval;
+  bits = *pbits;
+  while (bits <= 56 && pin > pinend)
+    {
+      --pin;
+      val <<= 8;
+      val |= (uint64_t)*pin;
+      bits += 8;
+    }
+  *ppin = pin;
+  *pval = val;
+  *pbits = bits;
+}
+
 /* This is like elf_fetch_bits, but it fetchs the bits backward, and ensures at
-   least 16 bits.  This is for zstd.  */
+   least 16 bits.  This is for zstd.  When it has to read, it reads a whole
+   64-bit word if it can, leaving at least 56 bits in *PVAL, so that the
+   callers' inner loops can decode several symbols per read.  The bits in
+   *PVAL above *PBITS are not cleared, so callers must mask what they
+   extract.  */
 
-static int
+static inline int
 elf_fetch_bits_backward (const unsigned char **ppin,
 			 const unsigned char *pinend,
 			 uint64_t *pval, unsigned int *pbits)
@@ -1174,41 +1925,51 @@ elf_fetch_bits_backward (const unsigned char **ppin,
   unsigned int bits;
   const unsigned char *pin;
   uint64_t val;
-  uint32_t next;
 
   bits = *pbits;
   if (bits >= 16)
     return 1;
   pin = *ppin;
-  val = *pval;
 
-  if (unlikely (pin <= pinend))
-    return 1;
+  if (pin - pinend >= 8)
+    {
+      unsigned int bytes;
 
-  pin -= 4;
+      /* The unread bits are the low BITS bits of the bytes starting at
+	 PIN.  The 8 bytes starting at PIN - BYTES still hold all of
+	 them, now with BYTES * 8 new bits below, and end no later than
+	 the last byte holding an unread bit.  Right after
+	 elf_fetch_backward_init that is the last byte of the stream, so
+	 we must not read past it.  */
+      bytes = (64 - bits) >> 3;
+      pin -= bytes;
 
 #if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) \
   && defined(__ORDER_BIG_ENDIAN__)				\
   && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__			\
       || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
-  /* We've ensured that PIN is aligned.  */
-  next = *(const uint32_t *)pin;
+      memcpy (&val, pin, sizeof val);
 
 #if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
-  next = __builtin_bswap32 (next);
+      val = __builtin_bswap64 (val);
 #endif
 #else
-  next = pin[0] | (pin[1] << 8) | (pin[2] << 16) | (pin[3] << 24);
+      val = ((uint64_t) pin[0]
+	     | ((uint64_t) pin[1] << 8)
+	     | ((uint64_t) pin[2] << 16)
+	     | ((uint64_t) pin[3] << 24)
+	     | ((uint64_t) pin[4] << 32)
+	     | ((uint64_t) pin[5] << 40)
+	     | ((uint64_t) pin[6] << 48)
+	     | ((uint64_t) pin[7] << 56));
 #endif
 
-  val <<= 32;
-  val |= next;
-  bits += 32;
-
-  if (unlikely (pin < pinend))
+      bits += bytes * 8;
+    }
+  else
     {
-      val >>= (pinend - pin) * 8;
-      bits -= (pinend - pin) * 8;
+      val = *pval;
+      elf_fetch_bytes_backward (&pin, pinend, &val, &bits);
     }
 
   *ppin = pin;
@@ -1228,8 +1989,6 @@ elf_fetch_backward_init (const unsigned char **ppin,
 {
   const unsigned char *pin;
   unsigned int stream_start;
-  uint64_t val;
-  unsigned int bits;
 
   pin = *ppin;
   stream_start = (unsigned int)*pin;
@@ -1238,25 +1997,9 @@ elf_fetch_backward_init (const unsigned char **ppin,
       elf_uncompress_failed ();
       return 0;
     }
-  val = 0;
-  bits = 0;
-
-  /* Align to a 32-bit boundary.  */
-  while ((((uintptr_t)pin) & 3) != 0)
-    {
-      val <<= 8;
-      val |= (uint64_t)*pin;
-      bits += 8;
-      --pin;
-    }
-
-  val <<= 8;
-  val |= (uint64_t)*pin;
-  bits += 8;
 
-  *ppin = pin;
-  *pval = val;
-  *pbits = bits;
+  *pval = (uint64_t)stream_start;
+  *pbits = 8;
   if (!elf_fetch_bits_backward (ppin, pinend, pval, pbits))
     return 0;
 
@@ -1812,6 +2555,295 @@ static const uint16_t elf_zlib_default_dist_table[0x100] =
   0x803, 0x813, 0x80b, 0x81b, 0x807, 0x817, 0x80f, 0x81f,
 };
 
+/* Refill *PVAL so that it holds at least 56 bits, reading 8 bytes
+   from *PPIN without checking the alignment or the end of the input;
+   the caller must ensure that there are at least 8 bytes left.  The
+   bits in *PVAL above *PBITS are left holding the start of the next
+   byte, which is harmless because the next refill stores the same
+   bits in the same place.  */
+
+static inline void
+elf_zlib_refill (const unsigned char **ppin, uint64_t *pval,
+		 unsigned int *pbits)
+{
+  const unsigned char *pin;
+  uint64_t next;
+  unsigned int bits;
+
+  pin = *ppin;
+  bits = *pbits;
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) \
+    && defined(__ORDER_BIG_ENDIAN__) \
+    && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__ \
+        || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+  memcpy (&next, pin, sizeof next);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  next = __builtin_bswap64 (next);
+#endif
+#else
+  next = ((uint64_t) pin[0]
+	  | ((uint64_t) pin[1] << 8)
+	  | ((uint64_t) pin[2] << 16)
+	  | ((uint64_t) pin[3] << 24)
+	  | ((uint64_t) pin[4] << 32)
+	  | ((uint64_t) pin[5] << 40)
+	  | ((uint64_t) pin[6] << 48)
+	  | ((uint64_t) pin[7] << 56));
+#endif
+
+  *pval |= next << bits;
+  *ppin = pin + ((63 - bits) >> 3);
+  *pbits = bits | 56;
+}
+
+/* The fast path of the main inflation loop.  This decodes symbols
+   from the current block using the tables TLIT and TDIST for as long
+   as there are at least 8 bytes of input and room for the longest
+   match plus 8 bytes of output.  That lets it refill 64 bits at a
+   time without checking for the end of the input, decode several
+   literals per refill, and copy matches 8 bytes at a time.  Sets
+   *PDONE if it sees the end of the block.  On return *PPIN is aligned
+   for elf_fetch_bits again.  Returns 1 on success, 0 on error.  */
+
+static int
+elf_zlib_inflate_fast (const unsigned char **ppin,
+		       const unsigned char *pinend,
+		       uint64_t *pval, unsigned int *pbits,
+		       const uint16_t *tlit, const uint16_t *tdist,
+		       unsigned char *porigout, unsigned char **ppout,
+		       unsigned char *poutend, int *pdone)
+{
+  const unsigned char *pin;
+  uint64_t val;
+  unsigned int bits;
+  unsigned char *pout;
+
+  pin = *ppin;
+  val = *pval;
+  bits = *pbits;
+  pout = *ppout;
+  *pdone = 0;
+
+  while (pinend - pin >= 8 && poutend - pout >= 258 + 8)
+    {
+      uint16_t t;
+      unsigned int b;
+      uint16_t v;
+      unsigned int lit;
+      unsigned int dist;
+      unsigned int len;
+
+      /* This leaves at least 56 bits, which is enough for a length
+	 code, its extra bits, a distance code, and its extra bits.  */
+      elf_zlib_refill (&pin, &val, &bits);
+
+      t = tlit[val & 0xff];
+      b = (t >> ZLIB_HUFFMAN_BITS_SHIFT) & ZLIB_HUFFMAN_BITS_MASK;
+      v = t & ZLIB_HUFFMAN_VALUE_MASK;
+
+      if ((t & (1U << ZLIB_HUFFMAN_SECONDARY_SHIFT)) == 0)
+	{
+	  lit = v;
+	  val >>= b + 1;
+	  bits -= b + 1;
+	}
+      else
+	{
+	  t = tlit[v + 0x100 + ((val >> 8) & ((1U << b) - 1))];
+	  b = (t >> ZLIB_HUFFMAN_BITS_SHIFT) & ZLIB_HUFFMAN_BITS_MASK;
+	  lit = t & ZLIB_HUFFMAN_VALUE_MASK;
+	  val >>= b + 8;
+	  bits -= b + 8;
+	}
+
+      if (lit < 256)
+	{
+	  *pout++ = lit;
+
+	  /* Keep decoding literals out of the bits we already have.
+	     Stop without consuming anything at the first code that is
+	     not a literal, so that it is decoded after a refill.  At
+	     most 56 literals fit in the bits, well within the output
+	     space we checked for.  */
+	  while (bits >= 15)
+	    {
+	      unsigned int used;
+
+	      t = tlit[val & 0xff];
+	      b = (t >> ZLIB_HUFFMAN_BITS_SHIFT) & ZLIB_HUFFMAN_BITS_MASK;
+	      v = t & ZLIB_HUFFMAN_VALUE_MASK;
+
+	      if ((t & (1U << ZLIB_HUFFMAN_SECONDARY_SHIFT)) == 0)
+		{
+		  lit = v;
+		  used = b + 1;
+		}
+	      else
+		{
+		  t = tlit[v + 0x100 + ((val >> 8) & ((1U << b) - 1))];
+		  b = (t >> ZLIB_HUFFMAN_BITS_SHIFT) & ZLIB_HUFFMAN_BITS_MASK;
+		  lit = t & ZLIB_HUFFMAN_VALUE_MASK;
+		  used = b + 8;
+		}
+
+	      if (lit >= 256)
+		break;
+
+	      *pout++ = lit;
+	      val >>= used;
+	      bits -= used;
+	    }
+
+	  continue;
+	}
+
+      if (lit == 256)
+	{
+	  *pdone = 1;
+	  break;
+	}
+
+      /* Convert lit into a length, as in elf_zlib_inflate.  */
+
+      if (lit < 265)
+	len = lit - 257 + 3;
+      else if (lit == 285)
+	len = 258;
+      else if (unlikely (lit > 285))
+	{
+	  elf_uncompress_failed ();
+	  return 0;
+	}
+      else
+	{
+	  unsigned int extra;
+
+	  lit -= 265;
+	  extra = (lit >> 2) + 1;
+	  len = (lit & 3) << extra;
+	  len += 11;
+	  len += ((1U << (extra - 1)) - 1) << 3;
+	  len += val & ((1U << extra) - 1);
+	  val >>= extra;
+	  bits -= extra;
+	}
+
+      t = tdist[val & 0xff];
+      b = (t >> ZLIB_HUFFMAN_BITS_SHIFT) & ZLIB_HUFFMAN_BITS_MASK;
+      v = t & ZLIB_HUFFMAN_VALUE_MASK;
+
+      if ((t & (1U << ZLIB_HUFFMAN_SECONDARY_SHIFT)) == 0)
+	{
+	  dist = v;
+	  val >>= b + 1;
+	  bits -= b + 1;
+	}
+      else
+	{
+	  t = tdist[v + 0x100 + ((val >> 8) & ((1U << b) - 1))];
+	  b = (t >> ZLIB_HUFFMAN_BITS_SHIFT) & ZLIB_HUFFMAN_BITS_MASK;
+	  dist = t & ZLIB_HUFFMAN_VALUE_MASK;
+	  val >>= b + 8;
+	  bits -= b + 8;
+	}
+
+      if (unlikely (dist > 29))
+	{
+	  elf_uncompress_failed ();
+	  return 0;
+	}
+      else if (dist < 4)
+	dist = dist + 1;
+      else
+	{
+	  unsigned int extra;
+
+	  dist -= 4;
+	  extra = (dist >> 1) + 1;
+	  dist = (dist & 1) << extra;
+	  dist += 5;
+	  dist += ((1U << (extra - 1)) - 1) << 2;
+	  dist += val & ((1U << extra) - 1);
+	  val >>= extra;
+	  bits -= extra;
+	}
+
+      if (unlikely ((size_t) (pout - porigout) < dist))
+	{
+	  elf_uncompress_failed ();
+	  return 0;
+	}
+
+      /* We checked above that there are at least 8 bytes of output
+	 space past the longest match, so we may copy in 8 byte chunks
+	 and write a little past the end of the match.  That works even
+	 when the source overlaps the destination, as long as the
+	 source is at least 8 bytes back.  */
+      if (dist >= 8)
+	{
+	  const unsigned char *from;
+	  unsigned char *to;
+	  unsigned char *end;
+
+	  from = pout - dist;
+	  to = pout;
+	  end = pout + len;
+	  do
+	    {
+	      memcpy (to, from, 8);
+	      to += 8;
+	      from += 8;
+	    }
+	  while (to < end);
+	  pout = end;
+	}
+      else if (dist == 1)
+	{
+	  memset (pout, pout[-1], len);
+	  pout += len;
+	}
+      else
+	{
+	  const unsigned char *from;
+	  unsigned int i;
+
+	  from = pout - dist;
+	  for (i = 0; i < len; ++i)
+	    pout[i] = from[i];
+	  pout += len;
+	}
+    }
+
+  /* Hand back the bits that have not been consumed, with PIN aligned
+     as elf_fetch_bits expects.  First give back whole bytes that have
+     been read but not used, then read forward a byte at a time.  */
+
+  while ((((uintptr_t) pin) & 3) != 0 && bits >= 8)
+    {
+      --pin;
+      bits -= 8;
+    }
+  val &= ((uint64_t) 1 << bits) - 1;
+  while ((((uintptr_t) pin) & 3) != 0)
+    {
+      if (unlikely (pin >= pinend))
+	{
+	  elf_uncompress_failed ();
+	  return 0;
+	}
+      val |= (uint64_t) *pin << bits;
+      bits += 8;
+      ++pin;
+    }
+
+  *ppin = pin;
+  *pval = val;
+  *pbits = bits;
+  *ppout = pout;
+  return 1;
+}
+
 /* Inflate a zlib stream from PIN/SIN to POUT/SOUT.  Return 1 on
    success, 0 on some error parsing the stream.  */
 
@@ -2304,8 +3336,21 @@ elf_zlib_inflate (const unsigned char *pin, size_t sin, uint16_t *zdebug_table,
 	      tdist = zdebug_table + ZLIB_HUFFMAN_TABLE_SIZE;
 	    }
 
-	  /* Inflate values until the end of the block.  This is the
-	     main loop of the inflation code.  */
+	  /* Inflate values until the end of the block.  Most of the
+	     block is handled by the fast loop; this is the main loop of
+	     the inflation code, which handles whatever is left near the
+	     end of the input or output.  */
+
+	  {
+	    int done;
+
+	    if (!elf_zlib_inflate_fast (&pin, pinend, &val, &bits, tlit,
+					tdist, porigout, &pout, poutend,
+					&done))
+	      return 0;
+	    if (done)
+	      continue;
+	  }
 
 	  while (1)
 	    {
@@ -2512,6 +3557,60 @@ elf_zlib_inflate (const unsigned char *pin, size_t sin, uint16_t *zdebug_table,
   return 1;
 }
 
+#ifdef __SSE2__
+
+/* Add CHUNKS 16 byte blocks at P into the Adler-32 sums *PS1 and
+   *PS2.  CHUNKS * 16 must be no more than 5552, so that the sums
+   can't overflow.  */
+
+static void
+elf_zlib_adler32_sse2 (uint32_t *ps1, uint32_t *ps2, const unsigned char *p,
+		       size_t chunks)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i whi = _mm_setr_epi16 (16, 15, 14, 13, 12, 11, 10, 9);
+  const __m128i wlo = _mm_setr_epi16 (8, 7, 6, 5, 4, 3, 2, 1);
+  __m128i vs1;
+  __m128i vs2;
+  __m128i vprev;
+  uint32_t s1;
+  uint32_t s2;
+
+  s1 = *ps1;
+  s2 = *ps2 + s1 * 16 * (uint32_t) chunks;
+
+  /* VS1 is the sum of the bytes.  VPREV is the sum of VS1 before
+     each block; every byte in an earlier block adds 16 to S2 for
+     each later block.  VS2 is the position weighted sum within each
+     block.  */
+  vs1 = zero;
+  vs2 = zero;
+  vprev = zero;
+  while (chunks > 0)
+    {
+      __m128i b;
+
+      b = _mm_loadu_si128 ((const __m128i *) p);
+      vprev = _mm_add_epi32 (vprev, vs1);
+      vs1 = _mm_add_epi32 (vs1, _mm_sad_epu8 (b, zero));
+      vs2 = _mm_add_epi32 (vs2,
+			   _mm_madd_epi16 (_mm_unpacklo_epi8 (b, zero), whi));
+      vs2 = _mm_add_epi32 (vs2,
+			   _mm_madd_epi16 (_mm_unpackhi_epi8 (b, zero), wlo));
+      p += 16;
+      --chunks;
+    }
+
+  vs2 = _mm_add_epi32 (vs2, _mm_slli_epi32 (vprev, 4));
+  vs1 = _mm_add_epi32 (vs1, _mm_shuffle_epi32 (vs1, _MM_SHUFFLE (1, 0, 3, 2)));
+  vs2 = _mm_add_epi32 (vs2, _mm_shuffle_epi32 (vs2, _MM_SHUFFLE (1, 0, 3, 2)));
+  vs2 = _mm_add_epi32 (vs2, _mm_shuffle_epi32 (vs2, _MM_SHUFFLE (2, 3, 0, 1)));
+  *ps1 = s1 + (uint32_t) _mm_cvtsi128_si32 (vs1);
+  *ps2 = s2 + (uint32_t) _mm_cvtsi128_si32 (vs2);
+}
+
+#endif /* __SSE2__ */
+
 /* Verify the zlib checksum.  The checksum is in the 4 bytes at
    CHECKBYTES, and the uncompressed data is at UNCOMPRESSED /
    UNCOMPRESSED_SIZE.  Returns 1 on success, 0 on failure.  */
@@ -2541,6 +3640,10 @@ elf_zlib_verify_checksum (const unsigned char *checkbytes,
   hsz = uncompressed_size;
   while (hsz >= 5552)
     {
+#ifdef __SSE2__
+      elf_zlib_adler32_sse2 (&s1, &s2, p, 5552 / 16);
+      p += 5552;
+#else
       for (i = 0; i < 5552; i += 16)
 	{
 	  /* Manually unroll loop 16 times.  */
@@ -2577,11 +3680,17 @@ elf_zlib_verify_checksum (const unsigned char *checkbytes,
 	  s1 = s1 + *p++;
 	  s2 = s2 + s1;
 	}
+#endif
       hsz -= 5552;
       s1 %= 65521;
       s2 %= 65521;
     }
 
+#ifdef __SSE2__
+  elf_zlib_adler32_sse2 (&s1, &s2, p, hsz / 16);
+  p += hsz & ~(size_t) 15;
+  hsz &= 15;
+#else
   while (hsz >= 16)
     {
       /* Manually unroll loop 16 times.  */
@@ -2620,6 +3729,7 @@ elf_zlib_verify_checksum (const unsigned char *checkbytes,
 
       hsz -= 16;
     }
+#endif
 
   for (i = 0; i < hsz; ++i)
     {
@@ -4296,6 +5406,7 @@ elf_zstd_unpack_seq_decode (int mode,
 	decode->table_bits = 0;
 	if (!conv (&entry, 0, table))
 	  return 0;
+	decode->table = table;
       }
       break;
 
@@ -4332,6 +5443,26 @@ elf_zstd_unpack_seq_decode (int mode,
   return 1;
 }
 
+/* Copy LEN bytes from SRC to DST in 16 byte chunks, which may write up to 15
+   bytes past DST + LEN and read up to 15 bytes past SRC + LEN.  The caller
+   must ensure that that is safe, and that SRC is either ahead of DST or at
+   least 16 bytes behind it.  */
+
+static inline void
+elf_zstd_wildcopy (unsigned char *dst, const unsigned char *src, size_t len)
+{
+  unsigned char *end;
+
+  end = dst + len;
+  do
+    {
+      memcpy (dst, src, 16);
+      dst += 16;
+      src += 16;
+    }
+  while (dst < end);
+}
+
 /* Decompress a zstd stream from PIN/SIN to POUT/SOUT.  Code based on RFC 8878.
    Return 1 on success, 0 on error.  */
 
@@ -4650,6 +5781,16 @@ elf_zstd_decompress (const unsigned char *pin, size_t sin,
 						 &match_decode))
 		  return 0;
 	      }
+	    else
+	      {
+		/* The block is just literals, and there is no sequence
+		   bitstream to read.  */
+		if (literal_count > 0 && plit != pout)
+		  memmove (pout, plit, literal_count);
+		pout += literal_count;
+		pin = pblockend;
+		break;
+	      }
 
 	    pback = pblockend - 1;
 	    if (!elf_fetch_backward_init (&pback, pin, &val, &bits))
@@ -4843,55 +5984,68 @@ elf_zstd_decompress (const unsigned char *pin, size_t sin,
 
 		literal_count -= literal;
 
-		/* Often LITERAL is small, so handle small cases quickly.  */
-		switch (literal)
+		/* The literals are at the end of the output buffer, ahead of
+		   POUT.  If there is room, copy them in 16 byte chunks,
+		   which may write a little past the end without reaching
+		   the literals we haven't used yet.  */
+		if ((size_t)(plit - pout) >= 16 && literal_count >= 16)
 		  {
-		  case 8:
-		    *pout++ = *plit++;
-		    ATTRIBUTE_FALLTHROUGH;
-		  case 7:
-		    *pout++ = *plit++;
-		    ATTRIBUTE_FALLTHROUGH;
-		  case 6:
-		    *pout++ = *plit++;
-		    ATTRIBUTE_FALLTHROUGH;
-		  case 5:
-		    *pout++ = *plit++;
-		    ATTRIBUTE_FALLTHROUGH;
-		  case 4:
-		    *pout++ = *plit++;
-		    ATTRIBUTE_FALLTHROUGH;
-		  case 3:
-		    *pout++ = *plit++;
-		    ATTRIBUTE_FALLTHROUGH;
-		  case 2:
-		    *pout++ = *plit++;
-		    ATTRIBUTE_FALLTHROUGH;
-		  case 1:
-		    *pout++ = *plit++;
-		    break;
-
-		  case 0:
-		    break;
-
-		  default:
-		    if (unlikely ((size_t)(plit - pout) < literal))
+		    elf_zstd_wildcopy (pout, plit, literal);
+		    pout += literal;
+		    plit += literal;
+		  }
+		else
+		  {
+		    /* Often LITERAL is small, so handle small cases quickly.  */
+		    switch (literal)
 		      {
-			uint32_t move;
+		      case 8:
+			*pout++ = *plit++;
+			ATTRIBUTE_FALLTHROUGH;
+		      case 7:
+			*pout++ = *plit++;
+			ATTRIBUTE_FALLTHROUGH;
+		      case 6:
+			*pout++ = *plit++;
+			ATTRIBUTE_FALLTHROUGH;
+		      case 5:
+			*pout++ = *plit++;
+			ATTRIBUTE_FALLTHROUGH;
+		      case 4:
+			*pout++ = *plit++;
+			ATTRIBUTE_FALLTHROUGH;
+		      case 3:
+			*pout++ = *plit++;
+			ATTRIBUTE_FALLTHROUGH;
+		      case 2:
+			*pout++ = *plit++;
+			ATTRIBUTE_FALLTHROUGH;
+		      case 1:
+			*pout++ = *plit++;
+			break;
+
+		      case 0:
+			break;
 
-			move = plit - pout;
-			while (literal > move)
+		      default:
+			if (unlikely ((size_t)(plit - pout) < literal))
 			  {
-			    memcpy (pout, plit, move);
-			    pout += move;
-			    plit += move;
-			    literal -= move;
+			    uint32_t move;
+
+			    move = plit - pout;
+			    while (literal > move)
+			      {
+				memcpy (pout, plit, move);
+				pout += move;
+				plit += move;
+				literal -= move;
+			      }
 			  }
-		      }
 
-		    memcpy (pout, plit, literal);
-		    pout += literal;
-		    plit += literal;
+			memcpy (pout, plit, literal);
+			pout += literal;
+			plit += literal;
+		      }
 		  }
 
 		if (match > 0)
@@ -4910,11 +6064,24 @@ elf_zstd_decompress (const unsigned char *pin, size_t sin,
 			return 0;
 		      }
 
-		    if (offset >= match)
+		    if (offset >= 16 && (size_t)(plit - pout) >= match + 16)
+		      {
+			/* As for the literals, copy in 16 byte chunks.  The
+			   source is at least 16 bytes back, so each chunk
+			   has been written before it is read.  */
+			elf_zstd_wildcopy (pout, pout - offset, match);
+			pout += match;
+		      }
+		    else if (offset >= match)
 		      {
 			memcpy (pout, pout - offset, match);
 			pout += match;
 		      }
+		    else if (offset == 1)
+		      {
+			memset (pout, pout[-1], match);
+			pout += match;
+		      }
 		    else
 		      {
 			while (match > 0)
@@ -5389,89 +6556,89 @@ elf_lzma_varint (const unsigned char *compressed, size_t compressed_size,
     }
 }
 
+/* The state of the LZMA range decoder.  The decoder functions below
+   are inline and take a pointer to a local variable of this type, so
+   the compiler can keep the fields in registers in the main decode
+   loop.  */
+
+struct elf_lzma_range
+{
+  /* The next byte of compressed input.  */
+  const unsigned char *next;
+  /* The end of the compressed input.  */
+  const unsigned char *end;
+  /* The current range.  */
+  uint32_t range;
+  /* The current code.  */
+  uint32_t code;
+};
+
 /* Normalize the LZMA range decoder, pulling in an extra input byte if
    needed.  */
 
-static void
-elf_lzma_range_normalize (const unsigned char *compressed,
-			  size_t compressed_size, size_t *poffset,
-			  uint32_t *prange, uint32_t *pcode)
+static inline void
+elf_lzma_range_normalize (struct elf_lzma_range *rc)
 {
-  if (*prange < (1U << 24))
+  if (rc->range < (1U << 24))
     {
-      if (unlikely (*poffset >= compressed_size))
+      if (unlikely (rc->next >= rc->end))
 	{
 	  /* We assume this will be caught elsewhere.  */
 	  elf_uncompress_failed ();
 	  return;
 	}
-      *prange <<= 8;
-      *pcode <<= 8;
-      *pcode += compressed[*poffset];
-      ++*poffset;
+      rc->range <<= 8;
+      rc->code = (rc->code << 8) | *rc->next;
+      ++rc->next;
     }
 }
 
 /* Read and return a single bit from the LZMA stream, reading and
-   updating *PROB.  Each bit comes from the range coder.  */
+   updating *PROB.  Each bit comes from the range coder.  The bits of
+   a literal are hard to predict, so this updates the state using a
+   mask rather than branching on the bit.  */
 
-static int
-elf_lzma_bit (const unsigned char *compressed, size_t compressed_size,
-	      uint16_t *prob, size_t *poffset, uint32_t *prange,
-	      uint32_t *pcode)
+static inline int
+elf_lzma_bit (struct elf_lzma_range *rc, uint16_t *prob)
 {
   uint32_t bound;
-
-  elf_lzma_range_normalize (compressed, compressed_size, poffset,
-			    prange, pcode);
-  bound = (*prange >> 11) * (uint32_t) *prob;
-  if (*pcode < bound)
-    {
-      *prange = bound;
-      *prob += ((1U << 11) - *prob) >> 5;
-      return 0;
-    }
-  else
-    {
-      *prange -= bound;
-      *pcode -= bound;
-      *prob -= *prob >> 5;
-      return 1;
-    }
+  uint32_t p;
+  uint32_t mask;
+  int bit;
+
+  elf_lzma_range_normalize (rc);
+  p = *prob;
+  bound = (rc->range >> 11) * p;
+  bit = rc->code >= bound;
+  mask = - (uint32_t) bit;
+  rc->range = bound + ((rc->range - bound - bound) & mask);
+  rc->code -= bound & mask;
+  *prob = (uint16_t) (p - ((p >> 5) & mask)
+		      + ((((1U << 11) - p) >> 5) & ~mask));
+  return bit;
 }
 
 /* Read an integer of size BITS from the LZMA stream, most significant
    bit first.  The bits are predicted using PROBS.  */
 
-static uint32_t
-elf_lzma_integer (const unsigned char *compressed, size_t compressed_size,
-		  uint16_t *probs, uint32_t bits, size_t *poffset,
-		  uint32_t *prange, uint32_t *pcode)
+static inline uint32_t
+elf_lzma_integer (struct elf_lzma_range *rc, uint16_t *probs, uint32_t bits)
 {
   uint32_t sym;
   uint32_t i;
 
   sym = 1;
   for (i = 0; i < bits; i++)
-    {
-      int bit;
-
-      bit = elf_lzma_bit (compressed, compressed_size, probs + sym, poffset,
-			  prange, pcode);
-      sym <<= 1;
-      sym += bit;
-    }
+    sym = (sym << 1) + elf_lzma_bit (rc, probs + sym);
   return sym - (1 << bits);
 }
 
 /* Read an integer of size BITS from the LZMA stream, least
    significant bit first.  The bits are predicted using PROBS.  */
 
-static uint32_t
-elf_lzma_reverse_integer (const unsigned char *compressed,
-			  size_t compressed_size, uint16_t *probs,
-			  uint32_t bits, size_t *poffset, uint32_t *prange,
-			  uint32_t *pcode)
+static inline uint32_t
+elf_lzma_reverse_integer (struct elf_lzma_range *rc, uint16_t *probs,
+			  uint32_t bits)
 {
   uint32_t sym;
   uint32_t val;
@@ -5483,8 +6650,7 @@ elf_lzma_reverse_integer (const unsigned char *compressed,
     {
       int bit;
 
-      bit = elf_lzma_bit (compressed, compressed_size, probs + sym, poffset,
-			  prange, pcode);
+      bit = elf_lzma_bit (rc, probs + sym);
       sym <<= 1;
       sym += bit;
       val += bit << i;
@@ -5495,10 +6661,9 @@ elf_lzma_reverse_integer (const unsigned char *compressed,
 /* Read a length from the LZMA stream.  IS_REP picks either LZMA_MATCH
    or LZMA_REP probabilities.  */
 
-static uint32_t
-elf_lzma_len (const unsigned char *compressed, size_t compressed_size,
-	      uint16_t *probs, int is_rep, unsigned int pos_state,
-	      size_t *poffset, uint32_t *prange, uint32_t *pcode)
+static inline uint32_t
+elf_lzma_len (struct elf_lzma_range *rc, uint16_t *probs, int is_rep,
+	      unsigned int pos_state)
 {
   uint16_t *probs_choice;
   uint16_t *probs_sym;
@@ -5508,14 +6673,12 @@ elf_lzma_len (const unsigned char *compressed, size_t compressed_size,
   probs_choice = probs + (is_rep
 			  ? LZMA_REP_LEN_CHOICE
 			  : LZMA_MATCH_LEN_CHOICE);
-  if (elf_lzma_bit (compressed, compressed_size, probs_choice, poffset,
-		    prange, pcode))
+  if (elf_lzma_bit (rc, probs_choice))
     {
       probs_choice = probs + (is_rep
 			      ? LZMA_REP_LEN_CHOICE2
 			      : LZMA_MATCH_LEN_CHOICE2);
-      if (elf_lzma_bit (compressed, compressed_size, probs_choice,
-			poffset, prange, pcode))
+      if (elf_lzma_bit (rc, probs_choice))
 	{
 	  probs_sym = probs + (is_rep
 			       ? LZMA_REP_LEN_HIGH (0)
@@ -5541,8 +6704,7 @@ elf_lzma_len (const unsigned char *compressed, size_t compressed_size,
       len = 2;
     }
 
-  len += elf_lzma_integer (compressed, compressed_size, probs_sym, bits,
-			   poffset, prange, pcode);
+  len += elf_lzma_integer (rc, probs_sym, bits);
   return len;
 }
 
@@ -5777,8 +6939,12 @@ elf_uncompress_lzma_block (const unsigned char *compressed,
 	{
 	  size_t uncompressed_chunk_start;
 	  size_t uncompressed_chunk_size;
+	  size_t uncompressed_chunk_end;
 	  size_t compressed_chunk_size;
-	  size_t limit;
+	  struct elf_lzma_range rc;
+	  const unsigned char *plimit;
+	  unsigned int pos_mask;
+	  unsigned int lit_pos_mask;
 
 	  /* An LZMA chunk.  This starts with an uncompressed size and
 	     a compressed size.  */
@@ -5880,32 +7046,33 @@ elf_uncompress_lzma_block (const unsigned char *compressed,
 
 	  /* This is the main LZMA decode loop.  */
 
-	  limit = off + compressed_chunk_size;
-	  *poffset = off;
-	  while (*poffset < limit)
+	  rc.next = compressed + off;
+	  rc.end = compressed + compressed_size;
+	  rc.range = range;
+	  rc.code = code;
+	  plimit = rc.next + compressed_chunk_size;
+	  uncompressed_chunk_end = (uncompressed_chunk_start
+				    + uncompressed_chunk_size);
+	  pos_mask = (1U << pb) - 1;
+	  lit_pos_mask = (1U << lp) - 1;
+	  while (rc.next < plimit)
 	    {
 	      unsigned int pos_state;
 
-	      if (unlikely (uncompressed_offset
-			    == (uncompressed_chunk_start
-				+ uncompressed_chunk_size)))
+	      if (unlikely (uncompressed_offset == uncompressed_chunk_end))
 		{
 		  /* We've decompressed all the expected bytes.  */
 		  break;
 		}
 
-	      pos_state = ((uncompressed_offset - dict_start_offset)
-			   & ((1 << pb) - 1));
+	      pos_state = (uncompressed_offset - dict_start_offset) & pos_mask;
 
-	      if (elf_lzma_bit (compressed, compressed_size,
-				probs + LZMA_IS_MATCH (lstate, pos_state),
-				poffset, &range, &code))
+	      if (elf_lzma_bit (&rc,
+				probs + LZMA_IS_MATCH (lstate, pos_state)))
 		{
 		  uint32_t len;
 
-		  if (elf_lzma_bit (compressed, compressed_size,
-				    probs + LZMA_IS_REP (lstate),
-				    poffset, &range, &code))
+		  if (elf_lzma_bit (&rc, probs + LZMA_IS_REP (lstate)))
 		    {
 		      int short_rep;
 		      uint32_t next_dist;
@@ -5913,17 +7080,13 @@ elf_uncompress_lzma_block (const unsigned char *compressed,
 		      /* Repeated match.  */
 
 		      short_rep = 0;
-		      if (elf_lzma_bit (compressed, compressed_size,
-					probs + LZMA_IS_REP0 (lstate),
-					poffset, &range, &code))
+		      if (elf_lzma_bit (&rc, probs + LZMA_IS_REP0 (lstate)))
 			{
-			  if (elf_lzma_bit (compressed, compressed_size,
-					    probs + LZMA_IS_REP1 (lstate),
-					    poffset, &range, &code))
+			  if (elf_lzma_bit (&rc,
+					    probs + LZMA_IS_REP1 (lstate)))
 			    {
-			      if (elf_lzma_bit (compressed, compressed_size,
-						probs + LZMA_IS_REP2 (lstate),
-						poffset, &range, &code))
+			      if (elf_lzma_bit (&rc,
+						probs + LZMA_IS_REP2 (lstate)))
 				{
 				  next_dist = dist[3];
 				  dist[3] = dist[2];
@@ -5944,11 +7107,10 @@ elf_uncompress_lzma_block (const unsigned char *compressed,
 			}
 		      else
 			{
-			  if (!elf_lzma_bit (compressed, compressed_size,
-					    (probs
-					     + LZMA_IS_REP0_LONG (lstate,
-								  pos_state)),
-					    poffset, &range, &code))
+			  uint16_t *prob;
+
+			  prob = probs + LZMA_IS_REP0_LONG (lstate, pos_state);
+			  if (!elf_lzma_bit (&rc, prob))
 			    short_rep = 1;
 			}
 
@@ -5960,9 +7122,7 @@ elf_uncompress_lzma_block (const unsigned char *compressed,
 		      if (short_rep)
 			len = 1;
 		      else
-			len = elf_lzma_len (compressed, compressed_size,
-					    probs, 1, pos_state, poffset,
-					    &range, &code);
+			len = elf_lzma_len (&rc, probs, 1, pos_state);
 		    }
 		  else
 		    {
@@ -5979,20 +7139,14 @@ elf_uncompress_lzma_block (const unsigned char *compressed,
 		      dist[3] = dist[2];
 		      dist[2] = dist[1];
 		      dist[1] = dist[0];
-		      len = elf_lzma_len (compressed, compressed_size,
-					  probs, 0, pos_state, poffset,
-					  &range, &code);
+		      len = elf_lzma_len (&rc, probs, 0, pos_state);
 
 		      if (len < 4 + 2)
 			dist_state = len - 2;
 		      else
 			dist_state = 3;
 		      probs_dist = probs + LZMA_DIST_SLOT (dist_state, 0);
-		      dist_slot = elf_lzma_integer (compressed,
-						    compressed_size,
-						    probs_dist, 6,
-						    poffset, &range,
-						    &code);
+		      dist_slot = elf_lzma_integer (&rc, probs_dist, 6);
 		      if (dist_slot < LZMA_DIST_MODEL_START)
 			dist[0] = dist_slot;
 		      else
@@ -6008,12 +7162,9 @@ elf_uncompress_lzma_block (const unsigned char *compressed,
 					    + LZMA_DIST_SPECIAL(dist[0]
 								- dist_slot
 								- 1));
-			      dist[0] +=
-				elf_lzma_reverse_integer (compressed,
-							  compressed_size,
-							  probs_dist,
-							  limit, poffset,
-							  &range, &code);
+			      dist[0] += elf_lzma_reverse_integer (&rc,
+								   probs_dist,
+								   limit);
 			    }
 			  else
 			    {
@@ -6025,25 +7176,19 @@ elf_uncompress_lzma_block (const unsigned char *compressed,
 				{
 				  uint32_t mask;
 
-				  elf_lzma_range_normalize (compressed,
-							    compressed_size,
-							    poffset,
-							    &range, &code);
-				  range >>= 1;
-				  code -= range;
-				  mask = -(code >> 31);
-				  code += range & mask;
+				  elf_lzma_range_normalize (&rc);
+				  rc.range >>= 1;
+				  rc.code -= rc.range;
+				  mask = -(rc.code >> 31);
+				  rc.code += rc.range & mask;
 				  dist0 <<= 1;
 				  dist0 += mask + 1;
 				}
 			      dist0 <<= 4;
 			      probs_dist = probs + LZMA_DIST_ALIGN (0);
-			      dist0 +=
-				elf_lzma_reverse_integer (compressed,
-							  compressed_size,
-							  probs_dist, 4,
-							  poffset,
-							  &range, &code);
+			      dist0 += elf_lzma_reverse_integer (&rc,
+								 probs_dist,
+								 4);
 			      dist[0] = dist0;
 			    }
 			}
@@ -6109,13 +7254,11 @@ elf_uncompress_lzma_block (const unsigned char *compressed,
 		    prev = 0;
 		  low = prev >> (8 - lc);
 		  high = (((uncompressed_offset - dict_start_offset)
-			   & ((1 << lp) - 1))
+			   & lit_pos_mask)
 			  << lc);
 		  lit_probs = probs + LZMA_LITERAL (low + high, 0);
 		  if (lstate < 7)
-		    sym = elf_lzma_integer (compressed, compressed_size,
-					    lit_probs, 8, poffset, &range,
-					    &code);
+		    sym = elf_lzma_integer (&rc, lit_probs, 8);
 		  else
 		    {
 		      unsigned int match;
@@ -6136,9 +7279,7 @@ elf_uncompress_lzma_block (const unsigned char *compressed,
 			  match <<= 1;
 			  idx = bit + match_bit + sym;
 			  sym <<= 1;
-			  if (elf_lzma_bit (compressed, compressed_size,
-					    lit_probs + idx, poffset,
-					    &range, &code))
+			  if (elf_lzma_bit (&rc, lit_probs + idx))
 			    {
 			      ++sym;
 			      bit &= match_bit;
@@ -6168,10 +7309,11 @@ elf_uncompress_lzma_block (const unsigned char *compressed,
 		}
 	    }
 
-	  elf_lzma_range_normalize (compressed, compressed_size, poffset,
-				    &range, &code);
+	  elf_lzma_range_normalize (&rc);
 
-	  off = *poffset;
+	  off = rc.next - compressed;
+	  range = rc.range;
+	  code = rc.code;
 	}
     }
 
@@ -6491,6 +7633,85 @@ backtrace_uncompress_lzma (struct backtrace_state *state,
 			      uncompressed_size);
 }
 
+/* A .gnu_debugaltlink file that has been read.  Distributions that
+   use dwz point many shared libraries at the same file, so we read it
+   once, the first time we see its build ID, and share the DWARF
+   data.  */
+
+struct elf_altlink
+{
+  /* The next altlink file.  */
+  struct elf_altlink *next;
+  /* The build ID of the file.  */
+  char *buildid_data;
+  /* The size of the build ID.  */
+  uint32_t buildid_size;
+  /* The DWARF data read from the file.  */
+  struct dwarf_data *dwarf;
+};
+
+/* Return the DWARF data for the altlink file with the given build ID,
+   or NULL if it has not been read.  */
+
+static struct dwarf_data *
+elf_find_altlink (struct backtrace_state *state, const char *buildid_data,
+		  uint32_t buildid_size)
+{
+  struct elf_altlink *p;
+
+  if (!state->threaded)
+    p = (struct elf_altlink *) state->altlink_data;
+  else
+    p = backtrace_atomic_load_pointer (&state->altlink_data);
+  for (; p != NULL; p = p->next)
+    {
+      if (p->buildid_size == buildid_size
+	  && memcmp (p->buildid_data, buildid_data, buildid_size) == 0)
+	return p->dwarf;
+    }
+  return NULL;
+}
+
+/* Remember the DWARF data of an altlink file.  Failure only means
+   that the file may be read again, so it is not reported.  */
+
+static void
+elf_add_altlink (struct backtrace_state *state, const char *buildid_data,
+		 uint32_t buildid_size, struct dwarf_data *dwarf)
+{
+  struct elf_altlink *p;
+
+  p = ((struct elf_altlink *)
+       backtrace_alloc (state, sizeof *p + buildid_size, NULL, NULL));
+  if (p == NULL)
+    return;
+  p->buildid_data = (char *) (p + 1);
+  memcpy (p->buildid_data, buildid_data, buildid_size);
+  p->buildid_size = buildid_size;
+  p->dwarf = dwarf;
+
+  if (!state->threaded)
+    {
+      p->next = (struct elf_altlink *) state->altlink_data;
+      state->altlink_data = p;
+    }
+  else
+    {
+      /* Entries are never removed, so pushing on the front of the
+	 list is safe.  If two threads read the same file, both
+	 entries are kept.  */
+      while (1)
+	{
+	  struct elf_altlink *head;
+
+	  head = backtrace_atomic_load_pointer (&state->altlink_data);
+	  p->next = head;
+	  if (__sync_bool_compare_and_swap (&state->altlink_data, head, p))
+	    break;
+	}
+    }
+}
+
 /* Add the backtrace data for one ELF file.  Returns 1 on success,
    0 on failure (in both cases descriptor is closed) or -1 if exe
    is non-zero and the ELF file is ET_DYN, which tells the caller that
@@ -6785,11 +8006,14 @@ elf_add (struct backtrace_state *state, const char *filename, int descriptor,
 
 	  if (with_buildid_size != 0)
 	    {
-	      if (buildid_size != with_buildid_size)
-		goto fail;
-
-	      if (memcmp (buildid_data, with_buildid_data, buildid_size) != 0)
-		goto fail;
+	      if (buildid_size != with_buildid_size
+		  || (memcmp (buildid_data, with_buildid_data, buildid_size)
+		      != 0))
+		{
+		  if (!debuginfo)
+		    error_callback (data, "build ID mismatch", 0);
+		  goto fail;
+		}
 	    }
 	}
 
@@ -6875,6 +8099,13 @@ elf_add (struct backtrace_state *state, const char *filename, int descriptor,
 	}
     }
 
+  /* A file whose build ID was requested must have one.  */
+  if (with_buildid_size != 0 && !debuginfo && buildid_data == NULL)
+    {
+      error_callback (data, "no build ID", 0);
+      goto fail;
+    }
+
   /* A debuginfo file may not have a useful .opd section, but we can use the
      one from the original executable.  */
   if (opd == NULL)
@@ -7007,7 +8238,10 @@ elf_add (struct backtrace_state *state, const char *filename, int descriptor,
     }
 
   struct dwarf_data *fileline_altlink = NULL;
-  if (debugaltlink_name != NULL)
+  if (debugaltlink_name != NULL && debugaltlink_buildid_size > 0)
+    fileline_altlink = elf_find_altlink (state, debugaltlink_buildid_data,
+					 debugaltlink_buildid_size);
+  if (debugaltlink_name != NULL && fileline_altlink == NULL)
     {
       int d;
 
@@ -7021,6 +8255,11 @@ elf_add (struct backtrace_state *state, const char *filename, int descriptor,
 			 error_callback, data, fileline_fn, found_sym,
 			 found_dwarf, &fileline_altlink, 0, 1,
 			 debugaltlink_buildid_data, debugaltlink_buildid_size);
+	  if (ret > 0
+	      && fileline_altlink != NULL
+	      && debugaltlink_buildid_size > 0)
+	    elf_add_altlink (state, debugaltlink_buildid_data,
+			     debugaltlink_buildid_size, fileline_altlink);
 	  elf_release_view (state, &debugaltlink_view, error_callback, data);
 	  debugaltlink_view_valid = 0;
 	  if (ret < 0)
@@ -7323,6 +8562,227 @@ elf_add (struct backtrace_state *state, const char *filename, int descriptor,
   return 0;
 }
 
+/* A module that a threaded state has read.  When independent users
+   in one process, such as a crash handler and a language runtime,
+   each create a state, the later states share the symbol table and
+   DWARF data of modules that an earlier state has read, rather than
+   reading and parsing the files again.  Only threaded states take
+   part, as a shared module may be used by several threads.  Nothing
+   is ever removed, as states are never freed.  */
+
+struct elf_shared_module
+{
+  /* The next module.  */
+  struct elf_shared_module *next;
+  /* The identity of the file.  */
+  dev_t dev;
+  ino_t ino;
+  off_t size;
+  time_t mtime;
+  /* The address at which the file is loaded.  */
+  struct libbacktrace_base_address base_address;
+  /* The symbol table data that reading the file added.  */
+  struct elf_syminfo_data **syminfo;
+  size_t syminfo_count;
+  /* The DWARF data that reading the file added.  */
+  struct dwarf_data **dwarf;
+  size_t dwarf_count;
+};
+
+/* The modules read by all threaded states in the process.  */
+
+static struct elf_shared_module *elf_shared_modules;
+
+/* Return the shared module for the file described by ST loaded at
+   BASE_ADDRESS, or NULL.  */
+
+static struct elf_shared_module *
+elf_find_shared_module (const struct stat *st,
+			struct libbacktrace_base_address base_address)
+{
+  struct elf_shared_module *m;
+
+  for (m = backtrace_atomic_load_pointer (&elf_shared_modules);
+       m != NULL;
+       m = m->next)
+    {
+      if (m->dev == st->st_dev
+	  && m->ino == st->st_ino
+	  && m->size == st->st_size
+	  && m->mtime == st->st_mtime
+	  && memcmp (&m->base_address, &base_address,
+		     sizeof base_address) == 0)
+	return m;
+    }
+  return NULL;
+}
+
+/* Record the symbol table and DWARF data that reading a file added to
+   STATE after SYM_TAIL and DWARF_TAIL, which were the last entries
+   before the file was read.  Failure only means that the file will be
+   read again by other states, so it is not reported.  */
+
+static void
+elf_record_shared_module (struct backtrace_state *state,
+			  const struct stat *st,
+			  struct libbacktrace_base_address base_address,
+			  struct elf_syminfo_data *sym_tail,
+			  struct dwarf_data *dwarf_tail)
+{
+  struct elf_syminfo_data *sym_first;
+  struct dwarf_data *dwarf_first;
+  struct elf_syminfo_data *sp;
+  struct dwarf_data *dp;
+  size_t syminfo_count;
+  size_t dwarf_count;
+  struct elf_shared_module *m;
+  size_t i;
+
+  if (sym_tail == NULL)
+    sym_first = backtrace_atomic_load_pointer (&state->syminfo_data);
+  else
+    sym_first = backtrace_atomic_load_pointer (&sym_tail->next);
+  syminfo_count = 0;
+  for (sp = sym_first;
+       sp != NULL;
+       sp = backtrace_atomic_load_pointer (&sp->next))
+    ++syminfo_count;
+
+  dwarf_first = backtrace_dwarf_next (state, dwarf_tail);
+  dwarf_count = 0;
+  for (dp = dwarf_first; dp != NULL; dp = backtrace_dwarf_next (state, dp))
+    ++dwarf_count;
+
+  m = ((struct elf_shared_module *)
+       backtrace_alloc (state,
+			(sizeof *m
+			 + syminfo_count * sizeof (struct elf_syminfo_data *)
+			 + dwarf_count * sizeof (struct dwarf_data *)),
+			NULL, NULL));
+  if (m == NULL)
+    return;
+
+  m->dev = st->st_dev;
+  m->ino = st->st_ino;
+  m->size = st->st_size;
+  m->mtime = st->st_mtime;
+  m->base_address = base_address;
+  m->syminfo = (struct elf_syminfo_data **) (void *) (m + 1);
+  m->syminfo_count = syminfo_count;
+  m->dwarf = (struct dwarf_data **) (void *) (m->syminfo + syminfo_count);
+  m->dwarf_count = dwarf_count;
+
+  for (sp = sym_first, i = 0; i < syminfo_count; sp = sp->next, ++i)
+    m->syminfo[i] = sp;
+  for (dp = dwarf_first, i = 0;
+       i < dwarf_count;
+       dp = backtrace_dwarf_next (state, dp), ++i)
+    m->dwarf[i] = dp;
+
+  while (1)
+    {
+      struct elf_shared_module *head;
+
+      head = backtrace_atomic_load_pointer (&elf_shared_modules);
+      m->next = head;
+      if (__sync_bool_compare_and_swap (&elf_shared_modules, head, m))
+	break;
+    }
+}
+
+/* Add the data recorded in M to STATE.  Returns 1 on success, 0 on
+   failure.  */
+
+static int
+elf_use_shared_module (struct backtrace_state *state,
+		       const struct elf_shared_module *m,
+		       backtrace_error_callback error_callback, void *data,
+		       fileline *fileline_fn, int *found_sym,
+		       int *found_dwarf)
+{
+  size_t i;
+
+  *found_sym = 0;
+  *found_dwarf = 0;
+
+  for (i = 0; i < m->syminfo_count; ++i)
+    {
+      struct elf_syminfo_data *sdata;
+
+      sdata = ((struct elf_syminfo_data *)
+	       backtrace_alloc (state, sizeof *sdata, error_callback, data));
+      if (sdata == NULL)
+	return 0;
+      *sdata = *m->syminfo[i];
+      sdata->next = NULL;
+      sdata->dwarf = NULL;
+      elf_add_syminfo_data (state, sdata);
+      *found_sym = 1;
+    }
+
+  for (i = 0; i < m->dwarf_count; ++i)
+    {
+      if (!backtrace_dwarf_share (state, m->dwarf[i], error_callback, data,
+				  fileline_fn))
+	return 0;
+      *found_dwarf = 1;
+    }
+
+  return 1;
+}
+
+/* Add the backtrace data for one module, sharing it with other
+   threaded states that have read the same file.  The arguments and
+   result are as for elf_add.  */
+
+static int
+elf_add_module (struct backtrace_state *state, const char *filename,
+		int descriptor, struct libbacktrace_base_address base_address,
+		backtrace_error_callback error_callback, void *data,
+		fileline *fileline_fn, int *found_sym, int *found_dwarf,
+		int exe)
+{
+  struct stat st;
+  struct elf_shared_module *m;
+  struct elf_syminfo_data *sym_tail;
+  struct elf_syminfo_data *sp;
+  struct dwarf_data *dwarf_tail;
+  struct dwarf_data *dp;
+  int ret;
+
+  if (!state->threaded || fstat (descriptor, &st) < 0)
+    return elf_add (state, filename, descriptor, NULL, 0, base_address,
+		    NULL, error_callback, data, fileline_fn, found_sym,
+		    found_dwarf, NULL, exe, 0, NULL, 0);
+
+  m = elf_find_shared_module (&st, base_address);
+  if (m != NULL)
+    {
+      backtrace_close (descriptor, error_callback, data);
+      return elf_use_shared_module (state, m, error_callback, data,
+				    fileline_fn, found_sym, found_dwarf);
+    }
+
+  sym_tail = NULL;
+  for (sp = backtrace_atomic_load_pointer (&state->syminfo_data);
+       sp != NULL;
+       sp = backtrace_atomic_load_pointer (&sp->next))
+    sym_tail = sp;
+  dwarf_tail = NULL;
+  for (dp = backtrace_dwarf_next (state, NULL);
+       dp != NULL;
+       dp = backtrace_dwarf_next (state, dp))
+    dwarf_tail = dp;
+
+  ret = elf_add (state, filename, descriptor, NULL, 0, base_address, NULL,
+		 error_callback, data, fileline_fn, found_sym, found_dwarf,
+		 NULL, exe, 0, NULL, 0);
+  if (ret == 1)
+    elf_record_shared_module (state, &st, base_address, sym_tail,
+			      dwarf_tail);
+  return ret;
+}
+
 /* Data passed to phdr_callback.  */
 
 struct phdr_data
@@ -7382,9 +8842,9 @@ phdr_callback (struct dl_phdr_info *info, size_t size ATTRIBUTE_UNUSED,
     }
 
   base_address.m = info->dlpi_addr;
-  if (elf_add (pd->state, filename, descriptor, NULL, 0, base_address, NULL,
-	       pd->error_callback, pd->data, &elf_fileline_fn, pd->found_sym,
-	       &found_dwarf, NULL, 0, 0, NULL, 0))
+  if (elf_add_module (pd->state, filename, descriptor, base_address,
+		      pd->error_callback, pd->data, &elf_fileline_fn,
+		      pd->found_sym, &found_dwarf, 0))
     {
       if (found_dwarf)
 	{
@@ -7396,6 +8856,84 @@ phdr_callback (struct dl_phdr_info *info, size_t size ATTRIBUTE_UNUSED,
   return 0;
 }
 
+/* Initialize the backtrace data from a list of ELF files that need
+   not be loaded in this process.  */
+
+int
+backtrace_initialize_modules (struct backtrace_state *state,
+			      const struct backtrace_module *modules,
+			      int count,
+			      backtrace_error_callback error_callback,
+			      void *data)
+{
+#ifndef __FDPIC__
+  int found_sym;
+  int loaded;
+  fileline elf_fileline_fn;
+  int i;
+
+  found_sym = 0;
+  loaded = 0;
+  elf_fileline_fn = elf_nodebug;
+  for (i = 0; i < count; ++i)
+    {
+      const struct backtrace_module *module;
+      int descriptor;
+      struct libbacktrace_base_address base_address;
+      fileline module_fileline_fn;
+      int module_found_dwarf;
+
+      module = &modules[i];
+      descriptor = backtrace_open (module->filename, error_callback, data,
+				   NULL);
+      if (descriptor < 0)
+	continue;
+
+      base_address.m = module->base_address;
+      module_found_dwarf = 0;
+      if (!elf_add (state, module->filename, descriptor, NULL, 0,
+		    base_address, NULL, error_callback, data,
+		    &module_fileline_fn, &found_sym, &module_found_dwarf,
+		    NULL, 0, 0,
+		    module->build_id_size != 0 ? module->build_id : NULL,
+		    (uint32_t) module->build_id_size))
+	continue;
+
+      ++loaded;
+      if (module_found_dwarf)
+	elf_fileline_fn = module_fileline_fn;
+    }
+
+  if (loaded == 0)
+    {
+      error_callback (data, "no module could be read", 0);
+      return 0;
+    }
+
+  if (!state->threaded)
+    {
+      state->syminfo_fn = found_sym ? elf_syminfo : elf_nosyms;
+      state->fileline_fn = elf_fileline_fn;
+      if (found_sym)
+	state->resolve_fn = elf_resolve;
+    }
+  else
+    {
+      backtrace_atomic_store_pointer (&state->syminfo_fn,
+				      found_sym ? elf_syminfo : elf_nosyms);
+      backtrace_atomic_store_pointer (&state->fileline_fn, elf_fileline_fn);
+      if (found_sym)
+	backtrace_atomic_store_pointer (&state->resolve_fn, elf_resolve);
+    }
+
+  return 1;
+#else /* defined (__FDPIC__) */
+  error_callback (data, "offline symbolization not supported with FDPIC",
+		  0);
+  return 0;
+#endif /* defined (__FDPIC__) */
+}
+
 /* Initialize the backtrace data we need from an ELF executable.  At
    the ELF level, all we need to do is find the debug info
    sections.  */
@@ -7419,9 +8957,9 @@ backtrace_initialize (struct backtrace_state *state, const char *filename,
       struct libbacktrace_base_address zero_base_address;
 
       memset (&zero_base_address, 0, sizeof zero_base_address);
-      ret = elf_add (state, filename, descriptor, NULL, 0, zero_base_address,
-		     NULL, error_callback, data, &elf_fileline_fn, &found_sym,
-		     &found_dwarf, NULL, 1, 0, NULL, 0);
+      ret = elf_add_module (state, filename, descriptor, zero_base_address,
+			    error_callback, data, &elf_fileline_fn,
+			    &found_sym, &found_dwarf, 1);
       if (!ret)
 	return 0;
     }
@@ -7440,14 +8978,20 @@ backtrace_initialize (struct backtrace_state *state, const char *filename,
   if (!state->threaded)
     {
       if (found_sym)
-	state->syminfo_fn = elf_syminfo;
+	{
+	  state->syminfo_fn = elf_syminfo;
+	  state->resolve_fn = elf_resolve;
+	}
       else if (state->syminfo_fn == NULL)
 	state->syminfo_fn = elf_nosyms;
     }
   else
     {
       if (found_sym)
-	backtrace_atomic_store_pointer (&state->syminfo_fn, elf_syminfo);
+	{
+	  backtrace_atomic_store_pointer (&state->syminfo_fn, elf_syminfo);
+	  backtrace_atomic_store_pointer (&state->resolve_fn, elf_resolve);
+	}
       else
 	(void) __sync_bool_compare_and_swap (&state->syminfo_fn, NULL,
 					     elf_nosyms);
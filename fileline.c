@@ -211,9 +211,10 @@ windows_get_executable_path (char *buf, backtrace_error_callback error_callback,
 /* Initialize the fileline information from the executable.  Returns 1
    on success, 0 on failure.  */
 
-static int
-fileline_initialize (struct backtrace_state *state,
-		     backtrace_error_callback error_callback, void *data)
+int
+backtrace_fileline_initialize (struct backtrace_state *state,
+			       backtrace_error_callback error_callback,
+			       void *data)
 {
   int failed;
   fileline fileline_fn;
@@ -353,7 +354,7 @@ backtrace_pcinfo (struct backtrace_state *state, uintptr_t pc,
 		  backtrace_full_callback callback,
 		  backtrace_error_callback error_callback, void *data)
 {
-  if (!fileline_initialize (state, error_callback, data))
+  if (!backtrace_fileline_initialize (state, error_callback, data))
     return 0;
 
   if (state->fileline_initialization_failed)
@@ -362,6 +363,35 @@ backtrace_pcinfo (struct backtrace_state *state, uintptr_t pc,
   return state->fileline_fn (state, pc, callback, error_callback, data);
 }
 
+/* Find the file name, line number, and function name for an array
+   of PCs.  */
+
+int
+backtrace_pcinfo_array (struct backtrace_state *state, const uintptr_t *pcs,
+			int count, backtrace_full_callback callback,
+			backtrace_error_callback error_callback, void *data)
+{
+  fileline fileline_fn;
+  int i;
+
+  if (!backtrace_fileline_initialize (state, error_callback, data))
+    return 0;
+
+  if (state->fileline_initialization_failed)
+    return 0;
+
+  fileline_fn = state->fileline_fn;
+  for (i = 0; i < count; ++i)
+    {
+      int ret;
+
+      ret = fileline_fn (state, pcs[i], callback, error_callback, data);
+      if (ret != 0)
+	return ret;
+    }
+  return 0;
+}
+
 /* Given a PC, find the symbol for it, and its value.  */
 
 int
@@ -369,7 +399,7 @@ backtrace_syminfo (struct backtrace_state *state, uintptr_t pc,
 		   backtrace_syminfo_callback callback,
 		   backtrace_error_callback error_callback, void *data)
 {
-  if (!fileline_initialize (state, error_callback, data))
+  if (!backtrace_fileline_initialize (state, error_callback, data))
     return 0;
 
   if (state->fileline_initialization_failed)
@@ -379,6 +409,105 @@ backtrace_syminfo (struct backtrace_state *state, uintptr_t pc,
   return 1;
 }
 
+/* Data passed through the callbacks of backtrace_resolve when the
+   object file format has no combined lookup.  */
+
+struct resolve_data
+{
+  struct backtrace_state *state;
+  backtrace_resolve_callback callback;
+  backtrace_error_callback error_callback;
+  void *data;
+  /* Whether the symbol has been looked up yet.  */
+  int have_sym;
+  /* The symbol found for the PC.  */
+  const char *symname;
+  uintptr_t symval;
+  uintptr_t symsize;
+};
+
+/* The syminfo callback for backtrace_resolve.  */
+
+static void
+resolve_syminfo_callback (void *data, uintptr_t pc ATTRIBUTE_UNUSED,
+			  const char *symname, uintptr_t symval,
+			  uintptr_t symsize)
+{
+  struct resolve_data *rdata = (struct resolve_data *) data;
+
+  rdata->symname = symname;
+  rdata->symval = symval;
+  rdata->symsize = symsize;
+}
+
+/* The error callback for backtrace_resolve, which passes the
+   caller's data.  */
+
+static void
+resolve_error_callback (void *data, const char *msg, int errnum)
+{
+  struct resolve_data *rdata = (struct resolve_data *) data;
+
+  rdata->error_callback (rdata->data, msg, errnum);
+}
+
+/* The fileline callback for backtrace_resolve.  The symbol is looked
+   up for the first frame and reused for the inlined ones.  */
+
+static int
+resolve_fileline_callback (void *data, uintptr_t pc, const char *filename,
+			   int lineno, const char *function)
+{
+  struct resolve_data *rdata = (struct resolve_data *) data;
+
+  if (!rdata->have_sym && rdata->state->syminfo_fn != NULL)
+    {
+      rdata->state->syminfo_fn (rdata->state, pc, resolve_syminfo_callback,
+				resolve_error_callback, rdata);
+      rdata->have_sym = 1;
+    }
+
+  return rdata->callback (rdata->data, pc, filename, lineno, function,
+			  rdata->symname, rdata->symval, rdata->symsize);
+}
+
+/* Given a PC, find the file name, line number, function name and
+   symbol.  */
+
+int
+backtrace_resolve (struct backtrace_state *state, uintptr_t pc,
+		   backtrace_resolve_callback callback,
+		   backtrace_error_callback error_callback, void *data)
+{
+  resolve resolve_fn;
+  struct resolve_data rdata;
+
+  if (!backtrace_fileline_initialize (state, error_callback, data))
+    return 0;
+
+  if (state->fileline_initialization_failed)
+    return 0;
+
+  if (!state->threaded)
+    resolve_fn = state->resolve_fn;
+  else
+    resolve_fn = backtrace_atomic_load_pointer (&state->resolve_fn);
+
+  if (resolve_fn != NULL)
+    return resolve_fn (state, pc, callback, error_callback, data);
+
+  rdata.state = state;
+  rdata.callback = callback;
+  rdata.error_callback = error_callback;
+  rdata.data = data;
+  rdata.have_sym = 0;
+  rdata.symname = NULL;
+  rdata.symval = 0;
+  rdata.symsize = 0;
+  return state->fileline_fn (state, pc, resolve_fileline_callback,
+			     resolve_error_callback, &rdata);
+}
+
 /* A backtrace_syminfo_callback that can call into a
    backtrace_full_callback, used when we have a symbol table but no
    debug info.  */
@@ -0,0 +1,421 @@
+/* fptest.c -- Test for libbacktrace frame pointer and eh_frame unwinding.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    (1) Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    (2) Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in
+    the documentation and/or other materials provided with the
+    distribution.
+
+    (3) The name of the author may not be used to
+    endorse or promote products derived from this software without
+    specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.  */
+
+
+/* Test that unwinding using frame pointers, and using the built-in
+   eh_frame unwinder, gets the same results as the unwind library, and
+   compare the speed of all three.  This file must be compiled with
+   -fno-omit-frame-pointer.  */
+
+#include "config.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "backtrace.h"
+#include "backtrace-supported.h"
+
+#include "testlib.h"
+
+#ifndef HAVE_CLOCK_GETTIME
+
+typedef int xclockid_t;
+
+static int
+xclock_gettime (xclockid_t id ATTRIBUTE_UNUSED,
+		struct timespec *ts ATTRIBUTE_UNUSED)
+{
+  errno = EINVAL;
+  return -1;
+}
+
+#define clockid_t xclockid_t
+#define clock_gettime xclock_gettime
+#undef CLOCK_REALTIME
+#define CLOCK_REALTIME 0
+
+#endif /* !defined(HAVE_CLOCK_GETTIME) */
+
+#ifdef CLOCK_PROCESS_CPUTIME_ID
+#define FPTEST_CLOCK_GETTIME_ARG CLOCK_PROCESS_CPUTIME_ID
+#else
+#define FPTEST_CLOCK_GETTIME_ARG CLOCK_REALTIME
+#endif
+
+/* The number of frames we record.  */
+
+#define MAX_FRAMES 64
+
+/* The depth of the stack used for the timing test.  */
+
+#define BENCH_DEPTH 32
+
+/* The unwind modes that we test, other than the default.  */
+
+static const struct
+{
+  int mode;
+  const char *name;
+  /* Whether this mode should find all the frames that the unwind
+     library finds.  */
+  int all;
+} modes[] =
+{
+  { BACKTRACE_UNWIND_FRAME_POINTER, "frame pointer", 0 },
+  { BACKTRACE_UNWIND_EH_FRAME, "eh_frame", 1 }
+};
+
+#define MODE_COUNT (sizeof modes / sizeof modes[0])
+
+/* Whether each entry in modes is supported.  */
+
+static int supported[MODE_COUNT];
+
+/* The number of backtraces taken for each timing trial.  */
+
+#define BENCH_ITERATIONS 2000
+
+/* A backtrace_simple callback that records PCs, and stops when the
+   buffer is full.  */
+
+static int
+callback_collect (void *vdata, uintptr_t pc)
+{
+  struct sdata *data = (struct sdata *) vdata;
+
+  data->addrs[data->index] = pc;
+  ++data->index;
+  return data->index >= data->max ? 1 : 0;
+}
+
+/* Whether collect uses backtrace_capture rather than
+   backtrace_simple.  */
+
+static int use_capture;
+
+/* Collect a backtrace using MODE into DATA.  Returns non-zero on
+   failure.  */
+
+static int __attribute__ ((noinline))
+collect (int mode, struct sdata *data)
+{
+  data->index = 0;
+  data->failed = 0;
+  if (!backtrace_set_unwind_mode (state, mode, error_callback_two, data))
+    return 1;
+  backtrace_update_modules (state);
+  if (use_capture)
+    data->index = backtrace_capture (state, 0, data->addrs, data->max);
+  else
+    backtrace_simple (state, 0, callback_collect, error_callback_two, data);
+  return data->failed;
+}
+
+static int f1 (int, struct sdata *) __attribute__ ((noinline, noclone));
+static int f2 (int, struct sdata *) __attribute__ ((noinline, noclone));
+static int f3 (int, struct sdata *) __attribute__ ((noinline, noclone));
+
+/* Test that unwinding using MODE reports the same frames as the
+   unwind library.  If ALL is zero, only compare the frames in this
+   file.  If CAPTURE is non-zero, test backtrace_capture rather than
+   backtrace_simple.  */
+
+static void __attribute__ ((noinline, noclone))
+test1 (int mode, const char *name, int all, int capture)
+{
+  const char *fn;
+  uintptr_t addrs[2][MAX_FRAMES];
+  struct sdata data[2];
+  int failed;
+  size_t count;
+  size_t i;
+
+  for (i = 0; i < 2; ++i)
+    {
+      data[i].addrs = &addrs[i][0];
+      data[i].max = MAX_FRAMES;
+    }
+
+  fn = capture ? "backtrace_capture" : "backtrace_simple";
+  use_capture = capture;
+
+  /* Returning a value here and elsewhere avoids a tailcall which
+     would mess up the backtrace.  */
+  failed = f1 (BACKTRACE_UNWIND_DEFAULT, &data[0]) - 6 != 0;
+  if (!failed)
+    failed = f1 (mode, &data[1]) - 6 != 0;
+
+  /* Frames outside this file may not have frame pointers, so for
+     frame pointer unwinding only compare the ones that are the same
+     for both calls: collect, f3, f2, f1.  */
+  count = 4;
+  if (!failed && (data[0].index < count || data[1].index < count))
+    {
+      fprintf (stderr, "test1 %s %s: not enough frames: %zu, %zu\n",
+	       fn, name, data[0].index, data[1].index);
+      failed = 1;
+    }
+
+  if (!failed && all)
+    {
+      /* The unwind library may report a final frame with a PC of 0
+	 for the outermost function, which we don't.  */
+      if (data[0].index > data[1].index
+	  && addrs[0][data[0].index - 1] == (uintptr_t) -1)
+	--data[0].index;
+
+      if (data[0].index != data[1].index)
+	{
+	  fprintf (stderr, "test1 %s %s: got %zu frames, want %zu\n",
+		   fn, name, data[1].index, data[0].index);
+	  failed = 1;
+	}
+      count = data[0].index;
+    }
+
+  for (i = 0; !failed && i < count; ++i)
+    {
+      /* Frame 4 is this function, which calls f1 from two different
+	 places.  */
+      if (i == 4)
+	continue;
+      if (addrs[0][i] != addrs[1][i])
+	{
+	  fprintf (stderr,
+		   "test1 %s %s: frame %zu: unwind %#lx, %s %#lx\n",
+		   fn, name, i, (unsigned long) addrs[0][i], name,
+		   (unsigned long) addrs[1][i]);
+	  failed = 1;
+	}
+    }
+
+  printf ("%s: %s %s\n", failed ? "FAIL" : "PASS", fn, name);
+  if (failed)
+    ++failures;
+  use_capture = 0;
+}
+
+static int
+f1 (int mode, struct sdata *data)
+{
+  return f2 (mode, data) + 1;
+}
+
+static int
+f2 (int mode, struct sdata *data)
+{
+  return f3 (mode, data) + 2;
+}
+
+static int
+f3 (int mode, struct sdata *data)
+{
+  return collect (mode, data) + 3;
+}
+
+/* Given a set of TRIALS timings, discard the lowest and highest
+   values and return the mean average of the rest.  */
+
+static size_t
+average_time (const size_t *times, size_t trials)
+{
+  size_t imax;
+  size_t max;
+  size_t imin;
+  size_t min;
+  size_t i;
+  size_t sum;
+
+  imin = 0;
+  imax = 0;
+  min = times[0];
+  max = times[0];
+  for (i = 1; i < trials; ++i)
+    {
+      if (times[i] < min)
+	{
+	  imin = i;
+	  min = times[i];
+	}
+      if (times[i] > max)
+	{
+	  imax = i;
+	  max = times[i];
+	}
+    }
+
+  sum = 0;
+  for (i = 0; i < trials; ++i)
+    {
+      if (i != imax && i != imin)
+	sum += times[i];
+    }
+  return sum / (trials - 2);
+}
+
+/* Time BENCH_ITERATIONS backtraces using MODE.  Store the number of
+   frames seen in *FRAMES.  Returns the time in nanoseconds, or 0 if
+   the clock is not available.  */
+
+static size_t __attribute__ ((noinline))
+bench_once (int mode, size_t *frames)
+{
+  uintptr_t addrs[MAX_FRAMES];
+  struct sdata data;
+  struct timespec ts1;
+  struct timespec ts2;
+  size_t ret;
+  int i;
+
+  data.addrs = &addrs[0];
+  data.max = MAX_FRAMES;
+
+  if (clock_gettime (FPTEST_CLOCK_GETTIME_ARG, &ts1) < 0)
+    return 0;
+
+  *frames = 0;
+  for (i = 0; i < BENCH_ITERATIONS; ++i)
+    {
+      collect (mode, &data);
+      *frames += data.index;
+    }
+
+  if (clock_gettime (FPTEST_CLOCK_GETTIME_ARG, &ts2) < 0)
+    return 0;
+
+  ret = (ts2.tv_sec - ts1.tv_sec) * 1000000000;
+  ret += ts2.tv_nsec - ts1.tv_nsec;
+  return ret;
+}
+
+static int bench (int) __attribute__ ((noinline, noclone));
+
+/* Call bench through a pointer, so that the compiler does not turn
+   the recursion into a loop.  */
+
+static int (* volatile bench_fn) (int) = bench;
+
+/* Recurse to DEPTH and then run the timing test.  */
+
+static int
+bench (int depth)
+{
+  const size_t trials = 16;
+  size_t utimes[16];
+  size_t mtimes[MODE_COUNT][16];
+  size_t uframes;
+  size_t mframes[MODE_COUNT];
+  size_t utime;
+  size_t i;
+  size_t j;
+
+  if (depth > 0)
+    return bench_fn (depth - 1) + 1;
+
+  uframes = 0;
+  for (i = 0; i < trials; ++i)
+    {
+      utimes[i] = bench_once (BACKTRACE_UNWIND_DEFAULT, &uframes);
+      if (utimes[i] == 0)
+	return 0;
+      for (j = 0; j < MODE_COUNT; ++j)
+	{
+	  if (!supported[j])
+	    continue;
+	  mtimes[j][i] = bench_once (modes[j].mode, &mframes[j]);
+	  if (mtimes[j][i] == 0)
+	    return 0;
+	}
+    }
+
+  utime = average_time (utimes, trials);
+  printf ("%-14s: %zu ns, %g frames/s\n", "unwind", utime,
+	  (double) uframes * 1e9 / (double) utime);
+  for (j = 0; j < MODE_COUNT; ++j)
+    {
+      size_t mtime;
+
+      if (!supported[j])
+	continue;
+      mtime = average_time (mtimes[j], trials);
+      printf ("%-14s: %zu ns, %g frames/s, ratio %g\n", modes[j].name,
+	      mtime, (double) mframes[j] * 1e9 / (double) mtime,
+	      (double) utime / (double) mtime);
+    }
+
+  return 0;
+}
+
+/* An error callback that ignores the error.  */
+
+static void
+error_callback_ignore (void *data ATTRIBUTE_UNUSED,
+		       const char *msg ATTRIBUTE_UNUSED,
+		       int errnum ATTRIBUTE_UNUSED)
+{
+}
+
+int
+main (int argc ATTRIBUTE_UNUSED, char **argv)
+{
+  state = backtrace_create_state (argv[0], BACKTRACE_SUPPORTS_THREADS,
+				  error_callback_create, NULL);
+
+#if BACKTRACE_SUPPORTED
+  {
+    size_t i;
+    int any;
+
+    any = 0;
+    for (i = 0; i < MODE_COUNT; ++i)
+      {
+	supported[i] = backtrace_set_unwind_mode (state, modes[i].mode,
+						  error_callback_ignore,
+						  NULL);
+	if (!supported[i])
+	  printf ("UNSUPPORTED: backtrace_simple %s\n", modes[i].name);
+	else
+	  {
+	    test1 (modes[i].mode, modes[i].name, modes[i].all, 0);
+	    test1 (modes[i].mode, modes[i].name, modes[i].all, 1);
+	    any = 1;
+	  }
+      }
+    if (any)
+      bench (BENCH_DEPTH);
+  }
+#endif
+
+  exit (failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
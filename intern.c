@@ -0,0 +1,334 @@
+/* intern.c -- Intern stack backtraces.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    (1) Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    (2) Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in
+    the documentation and/or other materials provided with the
+    distribution.
+
+    (3) The name of the author may not be used to
+    endorse or promote products derived from this software without
+    specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.  */
+
+
+#include "config.h"
+
+#include <string.h>
+#include <sys/types.h>
+
+#include "backtrace.h"
+#include "internal.h"
+
+/* A table of interned stacks.  All the memory is allocated when the
+   table is created, so interning a stack never allocates and is
+   async-signal-safe.  The table is an open addressing hash table of
+   stack IDs, and each ID indexes an array of entries that point into
+   a shared pool of PCs.  Entries are only ever added.  A thread adds
+   a stack by reserving space in the PC pool and an entry, filling
+   them in, and then publishing the ID in an empty hash slot with a
+   compare and swap.  */
+
+/* An interned stack.  */
+
+struct backtrace_stack_entry
+{
+  /* The hash of the PCs.  */
+  uint32_t hash;
+  /* The number of PCs.  */
+  int count;
+  /* The index of the first PC in the pool.  */
+  int offset;
+  /* Set to 1 once the entry has been published in the hash table.  */
+  int ready;
+};
+
+struct backtrace_stack_table
+{
+  /* The state used to capture stacks.  */
+  struct backtrace_state *state;
+  /* The hash table of stack IDs.  A zero entry is empty.  */
+  int *slots;
+  /* The number of slots minus one.  The number of slots is a power of
+     two.  */
+  size_t slot_mask;
+  /* The stacks, indexed by ID - 1.  */
+  struct backtrace_stack_entry *entries;
+  /* The size of ENTRIES.  */
+  int max_entries;
+  /* The number of entries that have been reserved.  */
+  int entry_count;
+  /* The pool of PCs.  */
+  uintptr_t *pcs;
+  /* The size of PCS.  */
+  int max_pcs;
+  /* The number of PCs that have been reserved.  */
+  int pc_count;
+};
+
+/* Hash COUNT PCs.  */
+
+static uint32_t
+stack_hash (const uintptr_t *pcs, int count)
+{
+  uint64_t h;
+  int i;
+
+  h = (uint64_t) count;
+  for (i = 0; i < count; ++i)
+    {
+      h ^= (uint64_t) pcs[i];
+      h *= 0x9e3779b97f4a7c15ULL;
+      h ^= h >> 29;
+    }
+  return (uint32_t) (h ^ (h >> 32));
+}
+
+/* Atomically add N to *P, unless that would exceed MAX.  Returns the
+   old value, or -1 if there is no room.  */
+
+static int
+stack_reserve (int *p, int n, int max)
+{
+  while (1)
+    {
+      int old;
+
+      old = backtrace_atomic_load_int (p);
+      if (n > max - old)
+	return -1;
+      if (__sync_bool_compare_and_swap (p, old, old + n))
+	return old;
+    }
+}
+
+/* Create a stack table.  */
+
+struct backtrace_stack_table *
+backtrace_stack_table_create (struct backtrace_state *state, int max_stacks,
+			      int max_pcs,
+			      backtrace_error_callback error_callback,
+			      void *data)
+{
+  struct backtrace_stack_table *table;
+  size_t nslots;
+
+#ifndef HAVE_SYNC_FUNCTIONS
+  error_callback (data, "stack table requires atomic operations", 0);
+  return NULL;
+#endif
+
+  if (max_stacks <= 0 || max_pcs <= 0 || max_stacks > 0x10000000)
+    {
+      error_callback (data, "invalid stack table size", 0);
+      return NULL;
+    }
+
+  /* Keep the hash table at most half full.  */
+  nslots = 16;
+  while (nslots < (size_t) max_stacks * 2)
+    nslots <<= 1;
+
+  table = ((struct backtrace_stack_table *)
+	   backtrace_alloc (state, sizeof *table, error_callback, data));
+  if (table == NULL)
+    return NULL;
+  memset (table, 0, sizeof *table);
+  table->state = state;
+
+  table->slots = ((int *)
+		  backtrace_alloc (state, nslots * sizeof (int),
+				   error_callback, data));
+  if (table->slots == NULL)
+    goto fail;
+  memset (table->slots, 0, nslots * sizeof (int));
+  table->slot_mask = nslots - 1;
+
+  table->entries = ((struct backtrace_stack_entry *)
+		    backtrace_alloc (state,
+				     ((size_t) max_stacks
+				      * sizeof (struct backtrace_stack_entry)),
+				     error_callback, data));
+  if (table->entries == NULL)
+    goto fail;
+  memset (table->entries, 0,
+	  (size_t) max_stacks * sizeof (struct backtrace_stack_entry));
+  table->max_entries = max_stacks;
+
+  table->pcs = ((uintptr_t *)
+		backtrace_alloc (state, (size_t) max_pcs * sizeof (uintptr_t),
+				 error_callback, data));
+  if (table->pcs == NULL)
+    goto fail;
+  table->max_pcs = max_pcs;
+
+  return table;
+
+ fail:
+  if (table->entries != NULL)
+    backtrace_free (state, table->entries,
+		    ((size_t) max_stacks
+		     * sizeof (struct backtrace_stack_entry)),
+		    error_callback, data);
+  if (table->slots != NULL)
+    backtrace_free (state, table->slots, nslots * sizeof (int),
+		    error_callback, data);
+  backtrace_free (state, table, sizeof *table, error_callback, data);
+  return NULL;
+}
+
+/* Intern a stack.  */
+
+uint32_t
+backtrace_stack_intern (struct backtrace_stack_table *table,
+			const uintptr_t *pcs, int count)
+{
+  uint32_t hash;
+  size_t i;
+  size_t probes;
+  int id;
+
+  if (count <= 0)
+    return 0;
+
+  hash = stack_hash (pcs, count);
+  id = 0;
+  i = hash & table->slot_mask;
+  for (probes = 0; probes <= table->slot_mask; ++probes)
+    {
+      int *slot;
+      int sid;
+
+      slot = &table->slots[i];
+      sid = backtrace_atomic_load_int (slot);
+
+      if (sid == 0)
+	{
+	  if (id == 0)
+	    {
+	      struct backtrace_stack_entry *e;
+	      int ientry;
+	      int ipc;
+
+	      /* Reserve and fill in a new entry.  If we lose the race
+		 for this slot below, we keep the entry for the next
+		 empty slot; if the winner turns out to have the same
+		 stack, the entry is never published.  The PCs are
+		 reserved first: an entry reserved with no room for its
+		 PCs would be lost for good, while PC space is only lost
+		 when every entry is already in use.  */
+	      ipc = stack_reserve (&table->pc_count, count, table->max_pcs);
+	      if (ipc < 0)
+		return 0;
+	      ientry = stack_reserve (&table->entry_count, 1,
+				      table->max_entries);
+	      if (ientry < 0)
+		return 0;
+	      memcpy (&table->pcs[ipc], pcs, count * sizeof (uintptr_t));
+	      e = &table->entries[ientry];
+	      e->hash = hash;
+	      e->count = count;
+	      e->offset = ipc;
+	      id = ientry + 1;
+	    }
+
+	  if (__sync_bool_compare_and_swap (slot, 0, id))
+	    {
+	      backtrace_atomic_store_int (&table->entries[id - 1].ready, 1);
+	      return (uint32_t) id;
+	    }
+
+	  sid = backtrace_atomic_load_int (slot);
+	}
+
+      {
+	const struct backtrace_stack_entry *e;
+
+	e = &table->entries[sid - 1];
+	if (e->hash == hash
+	    && e->count == count
+	    && memcmp (&table->pcs[e->offset], pcs,
+		       count * sizeof (uintptr_t)) == 0)
+	  return (uint32_t) sid;
+      }
+
+      i = (i + 1) & table->slot_mask;
+    }
+
+  return 0;
+}
+
+/* Capture the current stack and intern it.  */
+
+uint32_t __attribute__((noinline))
+backtrace_stack_capture (struct backtrace_stack_table *table, int skip)
+{
+  uintptr_t pcs[BACKTRACE_STACK_MAX_DEPTH];
+  int count;
+
+  count = backtrace_capture (table->state, skip + 1, pcs,
+			     BACKTRACE_STACK_MAX_DEPTH);
+  return backtrace_stack_intern (table, pcs, count);
+}
+
+/* Return the PCs of the stack with ID.  */
+
+int
+backtrace_stack_get (struct backtrace_stack_table *table, uint32_t id,
+		     const uintptr_t **pcs)
+{
+  struct backtrace_stack_entry *e;
+
+  if (id == 0
+      || id > (uint32_t) backtrace_atomic_load_int (&table->entry_count))
+    return 0;
+  e = &table->entries[id - 1];
+  if (!backtrace_atomic_load_int (&e->ready))
+    return 0;
+  *pcs = &table->pcs[e->offset];
+  return e->count;
+}
+
+/* Call CALLBACK for each interned stack.  */
+
+int
+backtrace_stack_iterate (struct backtrace_stack_table *table,
+			 backtrace_stack_callback callback, void *data)
+{
+  int count;
+  int i;
+
+  count = backtrace_atomic_load_int (&table->entry_count);
+  for (i = 0; i < count; ++i)
+    {
+      struct backtrace_stack_entry *e;
+      int ret;
+
+      e = &table->entries[i];
+      if (!backtrace_atomic_load_int (&e->ready))
+	continue;
+      ret = callback (data, (uint32_t) i + 1, &table->pcs[e->offset],
+		      e->count);
+      if (ret != 0)
+	return ret;
+    }
+  return 0;
+}
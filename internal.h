@@ -121,6 +121,32 @@ extern void backtrace_atomic_store_int (int *, int);
 #endif /* !defined (HAVE_SYNC_FUNCTIONS) */
 #endif /* !defined (HAVE_ATOMIC_FUNCTIONS) */
 
+/* Whether we know how to unwind using frame pointers.  This requires
+   the frame record layout used on these processors, where the frame
+   pointer points at the saved caller frame pointer followed by the
+   return address, and a way to find the bounds of the thread stack.  */
+
+#if (defined (__x86_64__) || defined (__i386__) || defined (__aarch64__)) \
+  && defined (HAVE_TLS) && defined (HAVE_PTHREAD_GETATTR_NP)
+#define BACKTRACE_FRAME_POINTER_UNWIND 1
+#else
+#define BACKTRACE_FRAME_POINTER_UNWIND 0
+#endif
+
+/* Whether we have the built-in unwinder that reads .eh_frame_hdr.
+   This requires a way to find the unwind tables of the loaded
+   modules, the stack bounds as for frame pointer unwinding, and the
+   atomic functions to share the rule cache between threads.  It is
+   only implemented for x86_64 so far.  */
+
+#if defined (__x86_64__) \
+  && defined (HAVE_TLS) && defined (HAVE_PTHREAD_GETATTR_NP) \
+  && defined (HAVE_DL_ITERATE_PHDR) && defined (HAVE_ATOMIC_FUNCTIONS)
+#define BACKTRACE_EH_FRAME_UNWIND 1
+#else
+#define BACKTRACE_EH_FRAME_UNWIND 0
+#endif
+
 /* The type of the function that collects file/line information.  This
    is like backtrace_pcinfo.  */
 
@@ -135,6 +161,14 @@ typedef void (*syminfo) (struct backtrace_state *state, uintptr_t pc,
 			 backtrace_syminfo_callback callback,
 			 backtrace_error_callback error_callback, void *data);
 
+/* The type of the function that collects file/line and symbol
+   information together.  This is optional; when it is not set
+   backtrace_resolve uses the fileline and syminfo functions.  */
+
+typedef int (*resolve) (struct backtrace_state *state, uintptr_t pc,
+			backtrace_resolve_callback callback,
+			backtrace_error_callback error_callback, void *data);
+
 /* What the backtrace state pointer points to.  */
 
 struct backtrace_state
@@ -155,12 +189,35 @@ struct backtrace_state
   syminfo syminfo_fn;
   /* The data to pass to SYMINFO_FN.  */
   void *syminfo_data;
+  /* The function that returns file/line and symbol information, or
+     NULL.  It uses FILELINE_DATA and SYMINFO_DATA.  */
+  resolve resolve_fn;
   /* Whether initializing the file/line information failed.  */
   int fileline_initialization_failed;
+  /* Whether backtrace_state_freeze has been called.  Once set, all
+     the debug info has been read, and nothing allocated before the
+     call is written again.  */
+  int frozen;
+  /* How backtrace_simple walks the stack: a BACKTRACE_UNWIND_
+     value.  */
+  int unwind_mode;
+  /* The modules registered for the built-in unwinder.  */
+  struct backtrace_eh_module *eh_modules;
+  /* The unwind rule cache for the built-in unwinder.  */
+  struct backtrace_eh_cache *eh_cache;
+  /* The .gnu_debugaltlink files that have been read, so that the
+     modules that refer to one can share its DWARF data.  */
+  void *altlink_data;
+  /* The directories checked for separate debug info files, and
+     whether they exist.  */
+  void *debug_dir_data;
   /* The lock for the freelist.  */
   int lock_alloc;
   /* The freelist when using mmap.  */
   struct backtrace_freelist_struct *freelist;
+  /* The lock and freelist used once the state is frozen, kept in a
+     page of their own when using mmap.  */
+  struct backtrace_frozen_alloc *frozen_alloc;
 };
 
 /* Open a file for reading.  Returns -1 on error.  If DOES_NOT_EXIST
@@ -229,6 +286,14 @@ extern void backtrace_free (struct backtrace_state *state, void *mem,
 			    backtrace_error_callback error_callback,
 			    void *data);
 
+/* Prepare the allocator for backtrace_state_freeze, so that it no
+   longer reuses memory freed before the call or writes to the state.
+   Returns 1 on success, 0 on error.  */
+
+extern int backtrace_alloc_freeze (struct backtrace_state *state,
+				   backtrace_error_callback error_callback,
+				   void *data);
+
 /* A growable vector of some struct.  This is used for more efficient
    allocation when we don't know the final size of some group of data
    that we want to represent as an array.  */
@@ -252,6 +317,18 @@ extern void *backtrace_vector_grow (struct backtrace_state *state, size_t size,
 				    void *data,
 				    struct backtrace_vector *vec);
 
+/* Make sure that VEC has room for at least SIZE more bytes without
+   changing VEC->size.  Unlike backtrace_vector_grow, this allocates
+   only the space requested, so it may be used to reserve space
+   for a large number of entries up front.  Returns 1 on success, 0
+   on failure.  */
+
+extern int backtrace_vector_reserve (struct backtrace_state *state,
+				     size_t size,
+				     backtrace_error_callback error_callback,
+				     void *data,
+				     struct backtrace_vector *vec);
+
 /* Finish the current allocation on VEC.  Prepare to start a new
    allocation.  The finished allocation will never be freed.  Returns
    a pointer to the base of the finished entries, or NULL on
@@ -299,6 +376,114 @@ extern int backtrace_initialize (struct backtrace_state *state,
 				 void *data,
 				 fileline *fileline_fn);
 
+/* Read the debug data of the COUNT files in MODULES, rather than of
+   the running program, and set the fileline_fn, fileline_data,
+   syminfo_fn, and syminfo_data fields of STATE.  Returns 1 on
+   success, 0 on error.  Like backtrace_initialize, there is an
+   implementation of this function for each file format.  */
+
+extern int backtrace_initialize_modules (struct backtrace_state *state,
+					 const struct backtrace_module *modules,
+					 int count,
+					 backtrace_error_callback
+					   error_callback,
+					 void *data);
+
+/* Make sure that the file/line information has been read from the
+   executable.  Returns 1 on success, 0 on failure.  */
+
+extern int backtrace_fileline_initialize (struct backtrace_state *state,
+					  backtrace_error_callback
+					    error_callback,
+					  void *data);
+
+/* The registers tracked by the built-in unwinder.  */
+
+struct backtrace_unwind_regs
+{
+  /* The program counter.  */
+  uintptr_t pc;
+  /* The stack pointer.  */
+  uintptr_t sp;
+  /* The frame pointer.  */
+  uintptr_t fp;
+  /* The link register, on processors that have one.  */
+  uintptr_t lr;
+  /* Non-zero if PC is the address of the next instruction to
+     execute, rather than a return address.  */
+  int exact;
+};
+
+/* Store the registers of the calling function in REGS, which is a
+   struct backtrace_unwind_regs.  This must be a macro so that the
+   registers are those of the function using it.  */
+
+#if defined (__x86_64__)
+#define backtrace_unwind_regs_capture(regs)				\
+  do									\
+    {									\
+      __asm__ volatile ("leaq 0(%%rip), %0\n\t"				\
+			"movq %%rsp, %1\n\t"				\
+			"movq %%rbp, %2"				\
+			: "=r" ((regs).pc), "=r" ((regs).sp),		\
+			  "=r" ((regs).fp));				\
+      (regs).lr = 0;							\
+      (regs).exact = 1;							\
+    }									\
+  while (0)
+#endif
+
+/* Prepare STATE for the built-in unwinder, reading the list of
+   loaded modules.  Returns 1 on success, 0 on failure.  */
+
+extern int backtrace_eh_frame_init (struct backtrace_state *state,
+				    backtrace_error_callback error_callback,
+				    void *data);
+
+/* If modules have been loaded or unloaded since the built-in
+   unwinder last read the list of modules, read it again.  This does
+   nothing if backtrace_eh_frame_init has not been called.  This calls
+   dl_iterate_phdr, so it is not async-signal-safe.  */
+
+extern void backtrace_eh_frame_sync (struct backtrace_state *state);
+
+/* Step REGS from a frame to its caller using the registered unwind
+   tables.  LO and HI are the bounds of the stack.  Returns 1 on
+   success, 0 if this was the outermost frame, and -1 if the frame
+   could not be unwound.  This is async-signal-safe.  */
+
+extern int backtrace_eh_frame_step (struct backtrace_state *state,
+				    struct backtrace_unwind_regs *regs,
+				    uintptr_t lo, uintptr_t hi);
+
+/* Store up to MAX PCs in PCS from the stack of the code interrupted
+   by a signal, whose registers are in CONTEXT, the ucontext_t passed
+   to an SA_SIGINFO signal handler.  The first PC is the one at which
+   the signal arrived.  The stack is walked as backtrace_capture walks
+   it, except that the unwind library is never used; in
+   BACKTRACE_UNWIND_DEFAULT mode the frame pointers are followed.
+   Every address read from the stack is checked against its bounds:
+   if REGIONS is not NULL, it is NREGIONS pairs of start and end
+   addresses, sorted by start, of readable memory, and the stack is
+   the one containing the stack pointer; otherwise the bounds are
+   those found by backtrace_capture_prepare, if it was called on
+   this thread.  Failing both, only the page holding the stack
+   pointer is read.  This never allocates memory, so it is
+   async-signal-safe.  Returns the number of PCs stored, which is 0
+   if the registers can't be read on this system.  */
+
+extern int backtrace_capture_context (struct backtrace_state *state,
+				      const void *context,
+				      const uintptr_t *regions,
+				      size_t nregions, uintptr_t *pcs,
+				      int max);
+
+/* Look up the bounds of the current thread's stack, so that
+   backtrace_capture_context can check the frames it reads against
+   them.  This is not async-signal-safe.  */
+
+extern void backtrace_capture_prepare (void);
+
 /* An enum for the DWARF sections we care about.  */
 
 enum dwarf_section
@@ -373,6 +558,41 @@ extern int backtrace_dwarf_add (struct backtrace_state *state,
 				void *data, fileline *fileline_fn,
 				struct dwarf_data **fileline_entry);
 
+/* Return the DWARF data after AFTER, or from the start if AFTER is
+   NULL, whose address ranges span PC, or NULL.  */
+
+extern struct dwarf_data *backtrace_dwarf_find (struct backtrace_state *state,
+						struct dwarf_data *after,
+						uintptr_t pc);
+
+/* Look up PC in the DWARF data for one module.  Sets *FOUND to 1 if
+   the PC is found, 0 if not.  */
+
+extern int backtrace_dwarf_lookup (struct backtrace_state *state,
+				   struct dwarf_data *ddata, uintptr_t pc,
+				   backtrace_full_callback callback,
+				   backtrace_error_callback error_callback,
+				   void *data, int *found);
+
+/* Return the DWARF data after DDATA in STATE, or the first if DDATA
+   is NULL.  */
+
+extern struct dwarf_data *backtrace_dwarf_next (struct backtrace_state *state,
+						struct dwarf_data *ddata);
+
+/* Add to STATE the DWARF data DDATA read for another threaded state.  */
+
+extern int backtrace_dwarf_share (struct backtrace_state *state,
+				  const struct dwarf_data *ddata,
+				  backtrace_error_callback error_callback,
+				  void *data, fileline *fileline_fn);
+
+/* Read all the DWARF information that lookups would read on demand.  */
+
+extern void backtrace_dwarf_read_all (struct backtrace_state *state,
+				      backtrace_error_callback error_callback,
+				      void *data);
+
 /* A data structure to pass to backtrace_syminfo_to_full.  */
 
 struct backtrace_call_full
@@ -1359,3 +1359,17 @@ backtrace_initialize (struct backtrace_state *state, const char *filename,
 }
 
 #endif /* !defined (HAVE_MACH_O_DYLD_H) */
+
+/* Reading the debug info of arbitrary files is not supported for
+   Mach-O.  */
+
+int
+backtrace_initialize_modules (struct backtrace_state *state ATTRIBUTE_UNUSED,
+			      const struct backtrace_module *modules ATTRIBUTE_UNUSED,
+			      int count ATTRIBUTE_UNUSED,
+			      backtrace_error_callback error_callback,
+			      void *data)
+{
+  error_callback (data, "offline symbolization not supported for Mach-O", 0);
+  return 0;
+}
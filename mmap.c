@@ -68,10 +68,24 @@ struct backtrace_freelist_struct
   size_t size;
 };
 
-/* Free memory allocated by backtrace_alloc.  */
+/* The lock and free list used once the state is frozen.  This lives
+   at the start of a page mapped by backtrace_alloc_freeze, so that
+   using it doesn't write to the state itself.  */
+
+struct backtrace_frozen_alloc
+{
+  /* The lock for the free list.  */
+  int lock;
+  /* Blocks freed since the state was frozen.  */
+  struct backtrace_freelist_struct *freelist;
+};
+
+/* Add the block at ADDR of SIZE bytes to the free list *PFREELIST,
+   whose lock is held.  */
 
 static void
-backtrace_free_locked (struct backtrace_state *state, void *addr, size_t size)
+backtrace_free_locked (struct backtrace_freelist_struct **pfreelist,
+		       void *addr, size_t size)
 {
   /* Just leak small blocks.  We don't have to be perfect.  Don't put
      more than 16 entries on the free list, to avoid wasting time
@@ -87,7 +101,7 @@ backtrace_free_locked (struct backtrace_state *state, void *addr, size_t size)
 
       c = 0;
       ppsmall = NULL;
-      for (pp = &state->freelist; *pp != NULL; pp = &(*pp)->next)
+      for (pp = pfreelist; *pp != NULL; pp = &(*pp)->next)
 	{
 	  if (ppsmall == NULL || (*pp)->size < (*ppsmall)->size)
 	    ppsmall = pp;
@@ -101,9 +115,9 @@ backtrace_free_locked (struct backtrace_state *state, void *addr, size_t size)
 	}
 
       p = (struct backtrace_freelist_struct *) addr;
-      p->next = state->freelist;
+      p->next = *pfreelist;
       p->size = size;
-      state->freelist = p;
+      *pfreelist = p;
     }
 }
 
@@ -116,6 +130,8 @@ backtrace_alloc (struct backtrace_state *state,
 		 void *data)
 {
   void *ret;
+  int *plock;
+  struct backtrace_freelist_struct **pfreelist;
   int locked;
   struct backtrace_freelist_struct **pp;
   size_t pagesize;
@@ -124,6 +140,21 @@ backtrace_alloc (struct backtrace_state *state,
 
   ret = NULL;
 
+  /* Once the state is frozen, the free list and the lock in the state
+     must not be written, so use the ones that backtrace_alloc_freeze
+     set up in a page of their own.  */
+
+  if (state->frozen)
+    {
+      plock = &state->frozen_alloc->lock;
+      pfreelist = &state->frozen_alloc->freelist;
+    }
+  else
+    {
+      plock = &state->lock_alloc;
+      pfreelist = &state->freelist;
+    }
+
   /* If we can acquire the lock, then see if there is space on the
      free list.  If we can't acquire the lock, drop straight into
      using mmap.  __sync_lock_test_and_set returns the old state of
@@ -132,11 +163,11 @@ backtrace_alloc (struct backtrace_state *state,
   if (!state->threaded)
     locked = 1;
   else
-    locked = __sync_lock_test_and_set (&state->lock_alloc, 1) == 0;
+    locked = __sync_lock_test_and_set (plock, 1) == 0;
 
   if (locked)
     {
-      for (pp = &state->freelist; *pp != NULL; pp = &(*pp)->next)
+      for (pp = pfreelist; *pp != NULL; pp = &(*pp)->next)
 	{
 	  if ((*pp)->size >= size)
 	    {
@@ -149,7 +180,7 @@ backtrace_alloc (struct backtrace_state *state,
 		 is more than 8 bytes.  */
 	      size = (size + 7) & ~ (size_t) 7;
 	      if (size < p->size)
-		backtrace_free_locked (state, (char *) p + size,
+		backtrace_free_locked (pfreelist, (char *) p + size,
 				       p->size - size);
 
 	      ret = (void *) p;
@@ -159,7 +190,7 @@ backtrace_alloc (struct backtrace_state *state,
 	}
 
       if (state->threaded)
-	__sync_lock_release (&state->lock_alloc);
+	__sync_lock_release (plock);
     }
 
   if (ret == NULL)
@@ -196,14 +227,18 @@ backtrace_free (struct backtrace_state *state, void *addr, size_t size,
 		backtrace_error_callback error_callback ATTRIBUTE_UNUSED,
 		void *data ATTRIBUTE_UNUSED)
 {
+  int *plock;
+  struct backtrace_freelist_struct **pfreelist;
   int locked;
 
   /* If we are freeing a large aligned block, just release it back to
      the system.  This case arises when growing a vector for a large
      binary with lots of debug info.  Calling munmap here may cause us
      to call mmap again if there is also a large shared library; we
-     just live with that.  */
-  if (size >= 16 * 4096)
+     just live with that.  Once the state is frozen, do this for any
+     whole pages, as they may be shared with a parent process and
+     putting them on the free list would write to them.  */
+  if (size >= 16 * 4096 || state->frozen)
     {
       size_t pagesize;
 
@@ -218,6 +253,17 @@ backtrace_free (struct backtrace_state *state, void *addr, size_t size,
 	}
     }
 
+  if (state->frozen)
+    {
+      plock = &state->frozen_alloc->lock;
+      pfreelist = &state->frozen_alloc->freelist;
+    }
+  else
+    {
+      plock = &state->lock_alloc;
+      pfreelist = &state->freelist;
+    }
+
   /* If we can acquire the lock, add the new space to the free list.
      If we can't acquire the lock, just leak the memory.
      __sync_lock_test_and_set returns the old state of the lock, so we
@@ -226,15 +272,61 @@ backtrace_free (struct backtrace_state *state, void *addr, size_t size,
   if (!state->threaded)
     locked = 1;
   else
-    locked = __sync_lock_test_and_set (&state->lock_alloc, 1) == 0;
+    locked = __sync_lock_test_and_set (plock, 1) == 0;
 
   if (locked)
     {
-      backtrace_free_locked (state, addr, size);
+      backtrace_free_locked (pfreelist, addr, size);
 
       if (state->threaded)
-	__sync_lock_release (&state->lock_alloc);
+	__sync_lock_release (plock);
+    }
+}
+
+/* Prepare for backtrace_state_freeze.  The free list lives in the
+   memory that it describes, so using it would write to pages shared
+   with a child process; drop it, leaking the memory on it.  Memory
+   freed from now on goes on a new free list, with its lock, at the
+   start of a freshly mapped page.  Blocks allocated after this come
+   from new pages, so reusing them writes nothing shared with the
+   parent.  A partial page allocated before the freeze and freed after
+   it goes on the new list too, which just costs a copy of that
+   page.  */
+
+int
+backtrace_alloc_freeze (struct backtrace_state *state,
+			backtrace_error_callback error_callback, void *data)
+{
+  size_t pagesize;
+  void *page;
+  struct backtrace_frozen_alloc *fa;
+  size_t size;
+
+  if (state->frozen_alloc != NULL)
+    return 1;
+
+  pagesize = getpagesize ();
+  page = mmap (NULL, pagesize, PROT_READ | PROT_WRITE,
+	       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (page == MAP_FAILED)
+    {
+      error_callback (data, "mmap", errno);
+      return 0;
     }
+
+  fa = (struct backtrace_frozen_alloc *) page;
+  fa->lock = 0;
+  fa->freelist = NULL;
+
+  /* The rest of the page is the first free block.  */
+  size = (sizeof *fa + 7) & ~ (size_t) 7;
+  backtrace_free_locked (&fa->freelist, (char *) page + size,
+			 pagesize - size);
+
+  state->frozen_alloc = fa;
+  state->freelist = NULL;
+
+  return 1;
 }
 
 /* Grow VEC by SIZE bytes.  */
@@ -286,6 +378,39 @@ backtrace_vector_grow (struct backtrace_state *state,size_t size,
   return ret;
 }
 
+/* Reserve SIZE bytes in VEC.  */
+
+int
+backtrace_vector_reserve (struct backtrace_state *state, size_t size,
+			  backtrace_error_callback error_callback,
+			  void *data, struct backtrace_vector *vec)
+{
+  size_t pagesize;
+  size_t alc;
+  void *base;
+
+  if (size <= vec->alc)
+    return 1;
+
+  /* The memory comes from mmap in whole pages anyhow, so round up
+     to a page.  */
+  pagesize = getpagesize ();
+  alc = vec->size + size;
+  alc = (alc + pagesize - 1) & ~ (pagesize - 1);
+  base = backtrace_alloc (state, alc, error_callback, data);
+  if (base == NULL)
+    return 0;
+  if (vec->base != NULL)
+    {
+      memcpy (base, vec->base, vec->size);
+      backtrace_free (state, vec->base, vec->size + vec->alc,
+		      error_callback, data);
+    }
+  vec->base = base;
+  vec->alc = alc - vec->size;
+  return 1;
+}
+
 /* Finish the current allocation on VEC.  */
 
 void *
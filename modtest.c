@@ -0,0 +1,245 @@
+/* modtest.c -- Test symbolizing a list of object files.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    (1) Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    (2) Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in
+    the documentation and/or other materials provided with the
+    distribution.
+
+    (3) The name of the author may not be used to
+    endorse or promote products derived from this software without
+    specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.  */
+
+
+/* Test backtrace_create_state_from_modules by reading this program as
+   though it had been loaded somewhere else.  */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#ifdef HAVE_LINK_H
+#include <link.h>
+#endif
+
+#include "backtrace.h"
+#include "backtrace-supported.h"
+
+#include "testlib.h"
+
+#if defined (HAVE_DL_ITERATE_PHDR) && defined (HAVE_LINK_H)
+
+/* The function whose address we look up.  */
+
+static int target (int) __attribute__ ((noinline, noclone));
+
+static int
+target (int i)
+{
+  return i + 1;
+}
+
+/* What we know about this program.  */
+
+struct exe_info
+{
+  /* The load bias.  */
+  uintptr_t bias;
+  /* The build ID, or NULL.  */
+  const char *build_id;
+  size_t build_id_size;
+};
+
+/* A dl_iterate_phdr callback that records the bias and build ID of
+   the executable, which is the first module.  */
+
+static int
+exe_callback (struct dl_phdr_info *info, size_t size ATTRIBUTE_UNUSED,
+	      void *data)
+{
+  struct exe_info *exe = (struct exe_info *) data;
+  int i;
+
+  exe->bias = info->dlpi_addr;
+  for (i = 0; i < info->dlpi_phnum; ++i)
+    {
+      const char *p;
+      const char *end;
+
+      if (info->dlpi_phdr[i].p_type != PT_NOTE)
+	continue;
+      p = (const char *) (info->dlpi_addr + info->dlpi_phdr[i].p_vaddr);
+      end = p + info->dlpi_phdr[i].p_memsz;
+      while (p + 12 <= end)
+	{
+	  uint32_t namesz;
+	  uint32_t descsz;
+	  uint32_t type;
+	  const char *name;
+	  const char *desc;
+
+	  memcpy (&namesz, p, 4);
+	  memcpy (&descsz, p + 4, 4);
+	  memcpy (&type, p + 8, 4);
+	  name = p + 12;
+	  desc = name + ((namesz + 3) & ~3U);
+	  if (desc + descsz > end)
+	    break;
+	  if (type == 3 && namesz == 4 && memcmp (name, "GNU", 4) == 0)
+	    {
+	      exe->build_id = desc;
+	      exe->build_id_size = descsz;
+	      return 1;
+	    }
+	  p = desc + ((descsz + 3) & ~3U);
+	}
+    }
+  return 1;
+}
+
+/* A backtrace_pcinfo callback that records the function name.  */
+
+static int
+function_callback (void *data, uintptr_t pc ATTRIBUTE_UNUSED,
+		   const char *filename ATTRIBUTE_UNUSED,
+		   int lineno ATTRIBUTE_UNUSED, const char *function)
+{
+  const char **pfunction = (const char **) data;
+
+  if (function != NULL)
+    *pfunction = function;
+  return 0;
+}
+
+/* An error callback that ignores errors.  */
+
+static void
+ignore_error_callback (void *data ATTRIBUTE_UNUSED,
+		       const char *msg ATTRIBUTE_UNUSED,
+		       int errnum ATTRIBUTE_UNUSED)
+{
+}
+
+/* The offset that we pretend the program was loaded at.  */
+
+#define FAKE_OFFSET ((uintptr_t) 0x10000000)
+
+/* Look up target with different load biases and build IDs.  */
+
+static void
+test1 (const char *filename)
+{
+  struct exe_info exe;
+  struct backtrace_module module;
+  struct backtrace_state *mstate;
+  uintptr_t pc;
+  const char *function;
+  char bad_id[64];
+
+  memset (&exe, 0, sizeof exe);
+  dl_iterate_phdr (exe_callback, &exe);
+  pc = (uintptr_t) target + 1;
+
+  /* Read the program at its real bias.  */
+  memset (&module, 0, sizeof module);
+  module.filename = filename;
+  module.base_address = exe.bias;
+  mstate = backtrace_create_state_from_modules (&module, 1, 0,
+						error_callback_create, NULL);
+  function = NULL;
+  if (mstate != NULL)
+    backtrace_pcinfo (mstate, pc, function_callback, error_callback_create,
+		      &function);
+  if (function == NULL || strcmp (function, "target") != 0)
+    {
+      fprintf (stderr, "test1: real bias: got %s, want target\n",
+	       function == NULL ? "NULL" : function);
+      printf ("FAIL: backtrace_create_state_from_modules bias\n");
+      ++failures;
+    }
+  else
+    printf ("PASS: backtrace_create_state_from_modules bias\n");
+
+  /* Pretend that the program was loaded elsewhere.  */
+  module.base_address = exe.bias + FAKE_OFFSET;
+  mstate = backtrace_create_state_from_modules (&module, 1, 1,
+						error_callback_create, NULL);
+  function = NULL;
+  if (mstate != NULL)
+    backtrace_pcinfo (mstate, pc + FAKE_OFFSET, function_callback,
+		      error_callback_create, &function);
+  if (function == NULL || strcmp (function, "target") != 0)
+    {
+      fprintf (stderr, "test1: moved bias: got %s, want target\n",
+	       function == NULL ? "NULL" : function);
+      printf ("FAIL: backtrace_create_state_from_modules moved\n");
+      ++failures;
+    }
+  else
+    printf ("PASS: backtrace_create_state_from_modules moved\n");
+
+  if (exe.build_id == NULL || exe.build_id_size > sizeof bad_id)
+    {
+      printf ("UNSUPPORTED: backtrace_create_state_from_modules build ID\n");
+      return;
+    }
+
+  /* The right build ID must be accepted and the wrong one rejected.  */
+  module.base_address = exe.bias;
+  module.build_id = exe.build_id;
+  module.build_id_size = exe.build_id_size;
+  mstate = backtrace_create_state_from_modules (&module, 1, 0,
+						error_callback_create, NULL);
+  memcpy (bad_id, exe.build_id, exe.build_id_size);
+  bad_id[0] ^= 1;
+  module.build_id = bad_id;
+  if (mstate == NULL
+      || backtrace_create_state_from_modules (&module, 1, 0,
+					      ignore_error_callback,
+					      NULL) != NULL)
+    {
+      printf ("FAIL: backtrace_create_state_from_modules build ID\n");
+      ++failures;
+    }
+  else
+    printf ("PASS: backtrace_create_state_from_modules build ID\n");
+
+  if (target (0) != 1)
+    abort ();
+}
+
+#endif /* defined (HAVE_DL_ITERATE_PHDR) && defined (HAVE_LINK_H) */
+
+int
+main (int argc ATTRIBUTE_UNUSED, char **argv)
+{
+#if defined (HAVE_DL_ITERATE_PHDR) && defined (HAVE_LINK_H)
+  test1 (argv[0]);
+#else
+  printf ("UNSUPPORTED: backtrace_create_state_from_modules\n");
+#endif
+
+  exit (failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -1121,3 +1121,17 @@ backtrace_initialize (struct backtrace_state *state,
 
   return 1;
 }
+
+/* Reading the debug info of arbitrary files is not supported for
+   PE/COFF.  */
+
+int
+backtrace_initialize_modules (struct backtrace_state *state ATTRIBUTE_UNUSED,
+			      const struct backtrace_module *modules ATTRIBUTE_UNUSED,
+			      int count ATTRIBUTE_UNUSED,
+			      backtrace_error_callback error_callback,
+			      void *data)
+{
+  error_callback (data, "offline symbolization not supported for PE/COFF", 0);
+  return 0;
+}
@@ -32,9 +32,11 @@ POSSIBILITY OF SUCH DAMAGE.  */
 
 #include "config.h"
 
+#include <errno.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include "backtrace.h"
 #include "internal.h"
@@ -115,3 +117,219 @@ backtrace_print (struct backtrace_state *state, int skip, FILE *f)
   backtrace_full (state, skip + 1, print_callback, error_callback,
 		  (void *) &data);
 }
+
+/* Passed to the callbacks of backtrace_print_fd.  None of these
+   functions use stdio or allocate memory, so that they may be called
+   from a signal handler.  */
+
+struct print_fd_data
+{
+  struct backtrace_state *state;
+  /* The descriptor to write to.  */
+  int fd;
+  /* The output buffer.  */
+  char *buf;
+  /* The size of the buffer.  */
+  size_t size;
+  /* The number of bytes in the buffer.  */
+  size_t len;
+};
+
+/* Write out the buffer.  Errors are ignored, as there is nowhere to
+   report them.  */
+
+static void
+print_fd_flush (struct print_fd_data *pdata)
+{
+  const char *p;
+  size_t len;
+
+  p = pdata->buf;
+  len = pdata->len;
+  while (len > 0)
+    {
+      ssize_t got;
+
+      got = write (pdata->fd, p, len);
+      if (got < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  break;
+	}
+      p += got;
+      len -= (size_t) got;
+    }
+  pdata->len = 0;
+}
+
+/* Append the string S.  */
+
+static void
+print_fd_string (struct print_fd_data *pdata, const char *s)
+{
+  while (*s != '\0')
+    {
+      if (pdata->len == pdata->size)
+	print_fd_flush (pdata);
+      pdata->buf[pdata->len++] = *s++;
+    }
+}
+
+/* Append V in hex with a leading 0x, as the "0x%lx" format in
+   print_callback would.  */
+
+static void
+print_fd_hex (struct print_fd_data *pdata, uintptr_t v)
+{
+  char digits[sizeof (uintptr_t) * 2 + 3];
+  char *p;
+
+  p = digits + sizeof digits;
+  *--p = '\0';
+  do
+    {
+      *--p = "0123456789abcdef"[v & 0xf];
+      v >>= 4;
+    }
+  while (v != 0);
+  *--p = 'x';
+  *--p = '0';
+  print_fd_string (pdata, p);
+}
+
+/* Append V in decimal.  */
+
+static void
+print_fd_decimal (struct print_fd_data *pdata, int v)
+{
+  char digits[sizeof (int) * 3 + 2];
+  char *p;
+  unsigned int u;
+
+  u = v < 0 ? - (unsigned int) v : (unsigned int) v;
+  p = digits + sizeof digits;
+  *--p = '\0';
+  do
+    {
+      *--p = (char) ('0' + u % 10);
+      u /= 10;
+    }
+  while (u != 0);
+  if (v < 0)
+    *--p = '-';
+  print_fd_string (pdata, p);
+}
+
+/* Print errors to the standard error descriptor.  strerror is not
+   async-signal-safe, so the error number is printed as a number.  */
+
+static void
+print_fd_error_callback (void *data, const char *msg, int errnum)
+{
+  struct print_fd_data *pdata = (struct print_fd_data *) data;
+  struct print_fd_data edata;
+  char buf[256];
+
+  edata.state = pdata->state;
+  edata.fd = 2;
+  edata.buf = buf;
+  edata.size = sizeof buf;
+  edata.len = 0;
+
+  if (pdata->state->filename != NULL)
+    {
+      print_fd_string (&edata, pdata->state->filename);
+      print_fd_string (&edata, ": ");
+    }
+  print_fd_string (&edata, "libbacktrace: ");
+  print_fd_string (&edata, msg);
+  if (errnum > 0)
+    {
+      print_fd_string (&edata, ": errno ");
+      print_fd_decimal (&edata, errnum);
+    }
+  print_fd_string (&edata, "\n");
+  print_fd_flush (&edata);
+}
+
+/* Print one level of a backtrace using the symbol table, as
+   print_syminfo_callback does.  */
+
+static void
+print_fd_syminfo_callback (void *data, uintptr_t pc, const char *symname,
+			   uintptr_t symval, uintptr_t symsize ATTRIBUTE_UNUSED)
+{
+  struct print_fd_data *pdata = (struct print_fd_data *) data;
+
+  print_fd_hex (pdata, pc);
+  if (symname == NULL)
+    print_fd_string (pdata, " ???\n\t???:0\n");
+  else
+    {
+      print_fd_string (pdata, " ???\n\t");
+      print_fd_string (pdata, symname);
+      print_fd_string (pdata, "+");
+      print_fd_hex (pdata, pc - symval);
+      print_fd_string (pdata, ":0\n");
+    }
+}
+
+/* Print one level of a backtrace, as print_callback does.  This is
+   called once for each inlined frame.  */
+
+static int
+print_fd_callback (void *data, uintptr_t pc, const char *filename,
+		   int lineno, const char *function)
+{
+  struct print_fd_data *pdata = (struct print_fd_data *) data;
+
+  if (function == NULL && filename == NULL)
+    {
+      backtrace_syminfo (pdata->state, pc, print_fd_syminfo_callback,
+			 print_fd_error_callback, data);
+      return 0;
+    }
+
+  print_fd_hex (pdata, pc);
+  print_fd_string (pdata, " ");
+  print_fd_string (pdata, function == NULL ? "???" : function);
+  print_fd_string (pdata, "\n\t");
+  print_fd_string (pdata, filename == NULL ? "???" : filename);
+  print_fd_string (pdata, ":");
+  print_fd_decimal (pdata, lineno);
+  print_fd_string (pdata, "\n");
+  return 0;
+}
+
+/* Print a backtrace to a file descriptor.  */
+
+void __attribute__((noinline))
+backtrace_print_fd (struct backtrace_state *state, int skip, int fd,
+		    char *buf, size_t size)
+{
+  struct print_fd_data data;
+  char local_buf[256];
+  uintptr_t pcs[BACKTRACE_STACK_MAX_DEPTH];
+  int count;
+  int i;
+
+  if (buf == NULL || size == 0)
+    {
+      buf = local_buf;
+      size = sizeof local_buf;
+    }
+
+  data.state = state;
+  data.fd = fd;
+  data.buf = buf;
+  data.size = size;
+  data.len = 0;
+
+  count = backtrace_capture (state, skip + 1, pcs,
+			     BACKTRACE_STACK_MAX_DEPTH);
+  for (i = 0; i < count; ++i)
+    backtrace_pcinfo (state, pcs[i], print_fd_callback,
+		      print_fd_error_callback, &data);
+  print_fd_flush (&data);
+}
@@ -0,0 +1,358 @@
+/* proftest.c -- Test for the libbacktrace sampling profiler.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    (1) Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    (2) Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in
+    the documentation and/or other materials provided with the
+    distribution.
+
+    (3) The name of the author may not be used to
+    endorse or promote products derived from this software without
+    specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.  */
+
+
+/* Test the sampling profiler with several busy threads.  */
+
+#include "config.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <pthread.h>
+
+#ifdef HAVE_TIMER_CREATE
+#include <sys/syscall.h>
+#endif
+
+#include "backtrace.h"
+#include "backtrace-supported.h"
+
+#include "testlib.h"
+
+/* Whether sample.c builds the sampler; this must match the test
+   there.  If it does, backtrace_sampler_create must not fail.  */
+
+#if defined (HAVE_TIMER_CREATE) && defined (HAVE_TLS) \
+  && defined (HAVE_ATOMIC_FUNCTIONS) && defined (SIGEV_THREAD_ID) \
+  && defined (SYS_gettid)
+#define SAMPLER_SUPPORTED 1
+#else
+#define SAMPLER_SUPPORTED 0
+#endif
+
+/* The number of threads.  */
+
+#define THREAD_COUNT 4
+
+/* The sampling interval, in microseconds.  */
+
+#define INTERVAL_USEC 10000
+
+/* The CPU time that each thread uses, in microseconds.  */
+
+#define SPIN_USEC 500000
+
+/* The sampler.  */
+
+static struct backtrace_sampler *sampler;
+
+/* The number of threads that have started sampling.  */
+
+static int started;
+
+/* The number of threads that have finished spinning.  */
+
+static int finished;
+
+/* Counts collected by the drain callback.  */
+
+struct counts
+{
+  /* The number of samples seen.  */
+  int samples;
+  /* The number of samples that include the spin function.  */
+  int in_spin;
+  /* The number of samples whose first PC is in the spin function,
+     where the signal arrived.  */
+  int first_in_spin;
+  /* The number of samples per slot.  */
+  int per_slot[THREAD_COUNT];
+};
+
+/* A backtrace_syminfo callback that checks for the spin function.  */
+
+static void
+find_spin (void *vdata, uintptr_t pc ATTRIBUTE_UNUSED, const char *symname,
+	   uintptr_t symval ATTRIBUTE_UNUSED,
+	   uintptr_t symsize ATTRIBUTE_UNUSED)
+{
+  int *found = (int *) vdata;
+
+  if (symname != NULL && strncmp (symname, "spin", 4) == 0)
+    *found = 1;
+}
+
+/* A backtrace_syminfo error callback.  */
+
+static void
+error_callback_sym (void *vdata ATTRIBUTE_UNUSED, const char *msg,
+		    int errnum)
+{
+  fprintf (stderr, "%s", msg);
+  if (errnum > 0)
+    fprintf (stderr, ": %s", strerror (errnum));
+  fprintf (stderr, "\n");
+  ++failures;
+}
+
+/* The backtrace_sampler_drain callback.  */
+
+static int
+count_sample (void *vdata, int slot, const uintptr_t *pcs, int count)
+{
+  struct counts *counts = (struct counts *) vdata;
+  int found;
+  int i;
+
+  ++counts->samples;
+  if (slot >= 0 && slot < THREAD_COUNT)
+    ++counts->per_slot[slot];
+
+  found = 0;
+  for (i = 0; i < count && !found; ++i)
+    {
+      backtrace_syminfo (state, pcs[i], find_spin, error_callback_sym,
+			 &found);
+      if (found && i == 0)
+	++counts->first_in_spin;
+    }
+  if (found)
+    ++counts->in_spin;
+
+  return 0;
+}
+
+/* Use SPIN_USEC of CPU time.  */
+
+static int __attribute__ ((noinline, noclone))
+spin (void)
+{
+  struct timespec start;
+  struct timespec now;
+  volatile int v;
+  long used;
+
+  v = 0;
+  if (clock_gettime (CLOCK_THREAD_CPUTIME_ID, &start) < 0)
+    return -1;
+  do
+    {
+      int i;
+
+      /* Keep the time spent in clock_gettime small, so that most
+	 signals arrive in this loop.  */
+      for (i = 0; i < 1000000; ++i)
+	v = v + i;
+      if (clock_gettime (CLOCK_THREAD_CPUTIME_ID, &now) < 0)
+	return -1;
+      used = ((now.tv_sec - start.tv_sec) * 1000000
+	      + (now.tv_nsec - start.tv_nsec) / 1000);
+    }
+  while (used < SPIN_USEC);
+  return 0;
+}
+
+/* A sampled thread.  This is called via pthread_create.  It returns
+   the number of failures, as void *.  */
+
+static void *
+thread_fn (void *arg ATTRIBUTE_UNUSED)
+{
+  int failed;
+
+  if (!backtrace_sampler_start_thread (sampler, INTERVAL_USEC,
+				       error_callback_create, NULL))
+    return (void *) (uintptr_t) 1;
+
+  /* Wait until every thread has a slot, so that no thread stops and
+     gives up its slot to a thread that starts later.  */
+  __atomic_add_fetch (&started, 1, __ATOMIC_RELEASE);
+  while (__atomic_load_n (&started, __ATOMIC_ACQUIRE) < THREAD_COUNT)
+    {
+      struct timespec ts;
+
+      ts.tv_sec = 0;
+      ts.tv_nsec = 1000000;
+      nanosleep (&ts, NULL);
+    }
+
+  failed = spin () != 0;
+  if (!backtrace_sampler_stop_thread (sampler, error_callback_create, NULL))
+    failed = 1;
+  __atomic_add_fetch (&finished, 1, __ATOMIC_RELEASE);
+  return (void *) (uintptr_t) failed;
+}
+
+/* Run busy threads, draining samples while they run.  */
+
+static void
+test1 (void)
+{
+  pthread_t atid[THREAD_COUNT];
+  struct counts counts;
+  int expected;
+  int in_slots;
+  int errnum;
+  int this_fail;
+  void *ret;
+  int i;
+
+  memset (&counts, 0, sizeof counts);
+
+  for (i = 0; i < THREAD_COUNT; i++)
+    {
+      errnum = pthread_create (&atid[i], NULL, thread_fn, NULL);
+      if (errnum != 0)
+	{
+	  fprintf (stderr, "pthread_create %d: %s\n", i, strerror (errnum));
+	  exit (EXIT_FAILURE);
+	}
+    }
+
+  /* Drain while the threads are running, to test that the ring
+     buffers work with a concurrent reader.  */
+  while (__atomic_load_n (&finished, __ATOMIC_ACQUIRE) < THREAD_COUNT)
+    {
+      struct timespec ts;
+
+      backtrace_sampler_drain (sampler, count_sample, &counts);
+      ts.tv_sec = 0;
+      ts.tv_nsec = 20000000;
+      nanosleep (&ts, NULL);
+    }
+
+  this_fail = 0;
+  for (i = 0; i < THREAD_COUNT; i++)
+    {
+      errnum = pthread_join (atid[i], &ret);
+      if (errnum != 0)
+	{
+	  fprintf (stderr, "pthread_join %d: %s\n", i, strerror (errnum));
+	  exit (EXIT_FAILURE);
+	}
+      this_fail += (int) (uintptr_t) ret;
+    }
+
+  backtrace_sampler_drain (sampler, count_sample, &counts);
+
+  /* Each thread should get about SPIN_USEC / INTERVAL_USEC samples.
+     Allow for timer granularity and slop in the accounting of CPU
+     time.  Each thread has its own slot, so check each one to catch
+     a timer or ring buffer that doesn't work.  */
+  expected = SPIN_USEC / INTERVAL_USEC;
+  for (i = 0; i < THREAD_COUNT; i++)
+    {
+      if (counts.per_slot[i] < expected / 3
+	  || counts.per_slot[i] > expected * 2)
+	{
+	  fprintf (stderr,
+		   "test1: got %d samples in slot %d, expected about %d\n",
+		   counts.per_slot[i], i, expected);
+	  this_fail = 1;
+	}
+    }
+  in_slots = 0;
+  for (i = 0; i < THREAD_COUNT; i++)
+    in_slots += counts.per_slot[i];
+  if (in_slots != counts.samples)
+    {
+      fprintf (stderr, "test1: %d samples not in a thread slot\n",
+	       counts.samples - in_slots);
+      this_fail = 1;
+    }
+
+  /* Almost all the time is spent in spin.  */
+  if (counts.in_spin < counts.samples / 2)
+    {
+      fprintf (stderr, "test1: only %d of %d samples in spin\n",
+	       counts.in_spin, counts.samples);
+      this_fail = 1;
+    }
+
+  /* The leaf function must not be lost, whatever the unwind mode.  */
+  if (counts.first_in_spin < counts.samples / 2)
+    {
+      fprintf (stderr, "test1: only %d of %d samples start in spin\n",
+	       counts.first_in_spin, counts.samples);
+      this_fail = 1;
+    }
+
+  if (backtrace_sampler_dropped (sampler) != 0)
+    {
+      fprintf (stderr, "test1: %zu samples dropped\n",
+	       backtrace_sampler_dropped (sampler));
+      this_fail = 1;
+    }
+
+  printf ("%s: backtrace_sampler threads\n", this_fail ? "FAIL" : "PASS");
+
+  failures += this_fail;
+}
+
+/* An error callback that ignores the error.  */
+
+static void
+error_callback_ignore (void *data ATTRIBUTE_UNUSED,
+		       const char *msg ATTRIBUTE_UNUSED,
+		       int errnum ATTRIBUTE_UNUSED)
+{
+}
+
+int
+main (int argc ATTRIBUTE_UNUSED, char **argv)
+{
+  state = backtrace_create_state (argv[0], BACKTRACE_SUPPORTS_THREADS,
+				  error_callback_create, NULL);
+
+#if BACKTRACE_SUPPORTED && BACKTRACE_SUPPORTS_THREADS
+  /* The unwind library is not async-signal-safe, so use one of our
+     own unwinders if we can.  */
+  if (!backtrace_set_unwind_mode (state, BACKTRACE_UNWIND_EH_FRAME,
+				  error_callback_ignore, NULL))
+    backtrace_set_unwind_mode (state, BACKTRACE_UNWIND_FRAME_POINTER,
+			       error_callback_ignore, NULL);
+
+#if SAMPLER_SUPPORTED
+  sampler = backtrace_sampler_create (state, THREAD_COUNT, 4096, 64,
+				      error_callback_create, NULL);
+  test1 ();
+#else
+  printf ("UNSUPPORTED: backtrace_sampler threads\n");
+#endif
+#endif
+
+  exit (failures ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,486 @@
+/* sample.c -- Sampling profiler.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    (1) Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    (2) Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in
+    the documentation and/or other materials provided with the
+    distribution.
+
+    (3) The name of the author may not be used to
+    endorse or promote products derived from this software without
+    specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.  */
+
+
+#include "config.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef HAVE_TIMER_CREATE
+#include <sys/syscall.h>
+#endif
+
+#include "backtrace.h"
+#include "internal.h"
+
+/* The sampling profiler.  Each sampled thread has a timer, created
+   with timer_create, that measures the CPU time of the thread and
+   sends SIGPROF to that thread.  The signal handler captures the stack
+   starting from the registers of the interrupted code, with
+   backtrace_capture_context, and appends it to a ring buffer owned by
+   the thread.  Each ring buffer has a single writer, the signal handler
+   of its thread, and a single reader, backtrace_sampler_drain, so
+   they need no locks.  All memory is allocated when the sampler is
+   created.  */
+
+#if defined (HAVE_TIMER_CREATE) && defined (HAVE_TLS) \
+  && defined (HAVE_ATOMIC_FUNCTIONS) && defined (SIGEV_THREAD_ID) \
+  && defined (SYS_gettid)
+
+/* Older versions of glibc don't define sigev_notify_thread_id.  */
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+/* A ring buffer of samples.  Each sample is stored as the number of
+   PCs followed by the PCs.  */
+
+struct backtrace_sample_ring
+{
+  /* The buffer.  */
+  uintptr_t *buf;
+  /* The size of the buffer minus one.  The size is a power of two.  */
+  size_t mask;
+  /* The index of the next word to write.  Only the signal handler
+     changes this.  */
+  size_t head;
+  /* The index of the next word to read.  Only
+     backtrace_sampler_drain changes this.  */
+  size_t tail;
+  /* The number of samples dropped because the buffer was full.  */
+  size_t dropped;
+  /* Non-zero if a thread is using this ring.  */
+  int in_use;
+};
+
+struct backtrace_sampler
+{
+  /* The state used to capture stacks.  */
+  struct backtrace_state *state;
+  /* The ring buffers.  */
+  struct backtrace_sample_ring *rings;
+  /* The number of ring buffers.  */
+  int max_threads;
+  /* The maximum number of PCs in a sample.  */
+  int max_depth;
+};
+
+/* The sampler that the signal handler uses.  There can only be
+   one.  */
+
+static struct backtrace_sampler *active_sampler;
+
+/* The ring buffer of the current thread, or NULL if the thread is not
+   being sampled.  */
+
+static __thread struct backtrace_sample_ring *thread_ring;
+
+/* The timer of the current thread.  */
+
+static __thread timer_t thread_timer;
+
+/* Append a sample of COUNT PCs to RING.  This is only called by the
+   signal handler.  */
+
+static void
+sampler_push (struct backtrace_sample_ring *ring, const uintptr_t *pcs,
+	      int count)
+{
+  size_t head;
+  size_t tail;
+  size_t need;
+  int i;
+
+  head = ring->head;
+  tail = __atomic_load_n (&ring->tail, __ATOMIC_ACQUIRE);
+  need = (size_t) count + 1;
+  if (ring->mask + 1 - (head - tail) < need)
+    {
+      __atomic_store_n (&ring->dropped, ring->dropped + 1,
+			__ATOMIC_RELAXED);
+      return;
+    }
+
+  ring->buf[head & ring->mask] = (uintptr_t) count;
+  for (i = 0; i < count; ++i)
+    ring->buf[(head + 1 + i) & ring->mask] = pcs[i];
+  __atomic_store_n (&ring->head, head + need, __ATOMIC_RELEASE);
+}
+
+/* The SIGPROF handler.  */
+
+static void
+sampler_handler (int sig ATTRIBUTE_UNUSED, siginfo_t *info ATTRIBUTE_UNUSED,
+		 void *context)
+{
+  struct backtrace_sampler *sampler;
+  struct backtrace_sample_ring *ring;
+  uintptr_t pcs[BACKTRACE_STACK_MAX_DEPTH];
+  int saved_errno;
+  int count;
+
+  ring = __atomic_load_n (&thread_ring, __ATOMIC_RELAXED);
+  sampler = __atomic_load_n (&active_sampler, __ATOMIC_ACQUIRE);
+  if (ring == NULL || sampler == NULL)
+    return;
+
+  saved_errno = errno;
+
+  /* Start from the interrupted registers, so that the first PC is
+     where the signal arrived even if that function has not yet set
+     up its frame.  */
+  count = backtrace_capture_context (sampler->state, context, NULL, 0, pcs,
+				     sampler->max_depth);
+  if (count > 0)
+    sampler_push (ring, pcs, count);
+
+  errno = saved_errno;
+}
+
+/* Create a sampler.  */
+
+struct backtrace_sampler *
+backtrace_sampler_create (struct backtrace_state *state, int max_threads,
+			  int buffer_size, int max_depth,
+			  backtrace_error_callback error_callback,
+			  void *data)
+{
+  struct backtrace_sampler *sampler;
+  size_t size;
+  size_t rings_size;
+  int i;
+  struct sigaction sa;
+
+  if (max_threads <= 0
+      || buffer_size <= 0
+      || max_depth <= 0
+      || max_depth > BACKTRACE_STACK_MAX_DEPTH
+      || buffer_size < max_depth + 1)
+    {
+      error_callback (data, "invalid sampler parameters", 0);
+      return NULL;
+    }
+
+  if (__atomic_load_n (&active_sampler, __ATOMIC_ACQUIRE) != NULL)
+    {
+      error_callback (data, "sampler already created", 0);
+      return NULL;
+    }
+
+  size = 1;
+  while (size < (size_t) buffer_size)
+    size <<= 1;
+
+  sampler = ((struct backtrace_sampler *)
+	     backtrace_alloc (state, sizeof *sampler, error_callback, data));
+  if (sampler == NULL)
+    return NULL;
+  sampler->state = state;
+  sampler->max_threads = max_threads;
+  sampler->max_depth = max_depth;
+
+  rings_size = (size_t) max_threads * sizeof (struct backtrace_sample_ring);
+  sampler->rings = ((struct backtrace_sample_ring *)
+		    backtrace_alloc (state, rings_size, error_callback,
+				     data));
+  if (sampler->rings == NULL)
+    {
+      backtrace_free (state, sampler, sizeof *sampler, error_callback,
+		      data);
+      return NULL;
+    }
+  memset (sampler->rings, 0, rings_size);
+
+  for (i = 0; i < max_threads; ++i)
+    {
+      struct backtrace_sample_ring *ring;
+
+      ring = &sampler->rings[i];
+      ring->buf = ((uintptr_t *)
+		   backtrace_alloc (state, size * sizeof (uintptr_t),
+				    error_callback, data));
+      if (ring->buf == NULL)
+	goto fail;
+      ring->mask = size - 1;
+    }
+
+  memset (&sa, 0, sizeof sa);
+  sa.sa_sigaction = sampler_handler;
+  sa.sa_flags = SA_SIGINFO | SA_RESTART;
+  sigemptyset (&sa.sa_mask);
+  if (sigaction (SIGPROF, &sa, NULL) < 0)
+    {
+      error_callback (data, "sigaction", errno);
+      goto fail;
+    }
+
+  if (!__sync_bool_compare_and_swap (&active_sampler, NULL, sampler))
+    {
+      error_callback (data, "sampler already created", 0);
+      goto fail;
+    }
+
+  return sampler;
+
+ fail:
+  for (i = 0; i < max_threads; ++i)
+    {
+      if (sampler->rings[i].buf != NULL)
+	backtrace_free (state, sampler->rings[i].buf,
+			size * sizeof (uintptr_t), error_callback, data);
+    }
+  backtrace_free (state, sampler->rings, rings_size, error_callback, data);
+  backtrace_free (state, sampler, sizeof *sampler, error_callback, data);
+  return NULL;
+}
+
+/* Start sampling the current thread.  */
+
+int
+backtrace_sampler_start_thread (struct backtrace_sampler *sampler,
+				long interval_usec,
+				backtrace_error_callback error_callback,
+				void *data)
+{
+  struct backtrace_sample_ring *ring;
+  struct sigevent sev;
+  struct itimerspec its;
+  int i;
+
+  if (thread_ring != NULL)
+    {
+      error_callback (data, "thread is already being sampled", 0);
+      return 0;
+    }
+
+  if (interval_usec <= 0)
+    {
+      error_callback (data, "invalid sampling interval", 0);
+      return 0;
+    }
+
+  ring = NULL;
+  for (i = 0; i < sampler->max_threads; ++i)
+    {
+      if (__sync_bool_compare_and_swap (&sampler->rings[i].in_use, 0, 1))
+	{
+	  ring = &sampler->rings[i];
+	  break;
+	}
+    }
+  if (ring == NULL)
+    {
+      error_callback (data, "too many sampled threads", 0);
+      return 0;
+    }
+
+  /* Look up the bounds of the thread stack now, and make sure that
+     the unwind tables are up to date, as the signal handler can't.  */
+  backtrace_capture_prepare ();
+  backtrace_eh_frame_sync (sampler->state);
+
+  memset (&sev, 0, sizeof sev);
+  sev.sigev_notify = SIGEV_THREAD_ID;
+  sev.sigev_signo = SIGPROF;
+  sev.sigev_notify_thread_id = (pid_t) syscall (SYS_gettid);
+  if (timer_create (CLOCK_THREAD_CPUTIME_ID, &sev, &thread_timer) < 0)
+    {
+      error_callback (data, "timer_create", errno);
+      __atomic_store_n (&ring->in_use, 0, __ATOMIC_RELEASE);
+      return 0;
+    }
+
+  __atomic_store_n (&thread_ring, ring, __ATOMIC_RELAXED);
+  __atomic_signal_fence (__ATOMIC_SEQ_CST);
+
+  its.it_interval.tv_sec = interval_usec / 1000000;
+  its.it_interval.tv_nsec = (interval_usec % 1000000) * 1000;
+  its.it_value = its.it_interval;
+  if (timer_settime (thread_timer, 0, &its, NULL) < 0)
+    {
+      error_callback (data, "timer_settime", errno);
+      timer_delete (thread_timer);
+      __atomic_store_n (&thread_ring, NULL, __ATOMIC_RELAXED);
+      __atomic_store_n (&ring->in_use, 0, __ATOMIC_RELEASE);
+      return 0;
+    }
+
+  return 1;
+}
+
+/* Stop sampling the current thread.  */
+
+int
+backtrace_sampler_stop_thread (struct backtrace_sampler *sampler ATTRIBUTE_UNUSED,
+			       backtrace_error_callback error_callback,
+			       void *data)
+{
+  struct backtrace_sample_ring *ring;
+
+  ring = thread_ring;
+  if (ring == NULL)
+    {
+      error_callback (data, "thread is not being sampled", 0);
+      return 0;
+    }
+
+  if (timer_delete (thread_timer) < 0)
+    {
+      error_callback (data, "timer_delete", errno);
+      return 0;
+    }
+
+  /* A signal that is already pending will see that there is no ring
+     and do nothing.  Samples already in the ring are still returned
+     by backtrace_sampler_drain.  */
+  __atomic_store_n (&thread_ring, NULL, __ATOMIC_RELAXED);
+  __atomic_signal_fence (__ATOMIC_SEQ_CST);
+  __atomic_store_n (&ring->in_use, 0, __ATOMIC_RELEASE);
+
+  return 1;
+}
+
+/* Pass all the samples collected so far to CALLBACK.  */
+
+int
+backtrace_sampler_drain (struct backtrace_sampler *sampler,
+			 backtrace_sample_callback callback, void *data)
+{
+  uintptr_t pcs[BACKTRACE_STACK_MAX_DEPTH];
+  int i;
+
+  /* Pick up any modules loaded or unloaded since the last drain, for
+     the samples that follow.  */
+  backtrace_eh_frame_sync (sampler->state);
+
+  for (i = 0; i < sampler->max_threads; ++i)
+    {
+      struct backtrace_sample_ring *ring;
+      size_t head;
+      size_t tail;
+
+      ring = &sampler->rings[i];
+      head = __atomic_load_n (&ring->head, __ATOMIC_ACQUIRE);
+      tail = ring->tail;
+      while (tail != head)
+	{
+	  int count;
+	  int j;
+	  int ret;
+
+	  count = (int) ring->buf[tail & ring->mask];
+	  for (j = 0; j < count; ++j)
+	    pcs[j] = ring->buf[(tail + 1 + j) & ring->mask];
+	  tail += (size_t) count + 1;
+
+	  /* Release the space before calling the callback, which may
+	     take a while.  */
+	  __atomic_store_n (&ring->tail, tail, __ATOMIC_RELEASE);
+
+	  ret = callback (data, i, pcs, count);
+	  if (ret != 0)
+	    return ret;
+	}
+    }
+
+  return 0;
+}
+
+/* Return the number of samples dropped because a buffer was full.  */
+
+size_t
+backtrace_sampler_dropped (struct backtrace_sampler *sampler)
+{
+  size_t ret;
+  int i;
+
+  ret = 0;
+  for (i = 0; i < sampler->max_threads; ++i)
+    ret += __atomic_load_n (&sampler->rings[i].dropped, __ATOMIC_RELAXED);
+  return ret;
+}
+
+#else /* !(HAVE_TIMER_CREATE && ...) */
+
+/* Sampling is not supported on this system.  */
+
+struct backtrace_sampler *
+backtrace_sampler_create (struct backtrace_state *state ATTRIBUTE_UNUSED,
+			  int max_threads ATTRIBUTE_UNUSED,
+			  int buffer_size ATTRIBUTE_UNUSED,
+			  int max_depth ATTRIBUTE_UNUSED,
+			  backtrace_error_callback error_callback,
+			  void *data)
+{
+  error_callback (data, "sampling not supported on this system", 0);
+  return NULL;
+}
+
+int
+backtrace_sampler_start_thread (struct backtrace_sampler *sampler ATTRIBUTE_UNUSED,
+				long interval_usec ATTRIBUTE_UNUSED,
+				backtrace_error_callback error_callback,
+				void *data)
+{
+  error_callback (data, "sampling not supported on this system", 0);
+  return 0;
+}
+
+int
+backtrace_sampler_stop_thread (struct backtrace_sampler *sampler ATTRIBUTE_UNUSED,
+			       backtrace_error_callback error_callback,
+			       void *data)
+{
+  error_callback (data, "sampling not supported on this system", 0);
+  return 0;
+}
+
+int
+backtrace_sampler_drain (struct backtrace_sampler *sampler ATTRIBUTE_UNUSED,
+			 backtrace_sample_callback callback ATTRIBUTE_UNUSED,
+			 void *data ATTRIBUTE_UNUSED)
+{
+  return 0;
+}
+
+size_t
+backtrace_sampler_dropped (struct backtrace_sampler *sampler ATTRIBUTE_UNUSED)
+{
+  return 0;
+}
+
+#endif /* !(HAVE_TIMER_CREATE && ...) */
@@ -32,8 +32,22 @@ POSSIBILITY OF SUCH DAMAGE.  */
 
 #include "config.h"
 
+#include <sys/types.h>
+
+#ifdef HAVE_PTHREAD_GETATTR_NP
+#include <pthread.h>
+#endif
+
+#if defined (__linux__) \
+  && (defined (__x86_64__) || defined (__i386__) || defined (__aarch64__))
+#include <signal.h>
+#include <ucontext.h>
+#define HAVE_SIGNAL_CONTEXT 1
+#endif
+
 #include "unwind.h"
 #include "backtrace.h"
+#include "internal.h"
 
 /* The simple_backtrace routine.  */
 
@@ -55,13 +69,12 @@ struct backtrace_simple_data
   int ret;
 };
 
-/* Unwind library callback routine.  This is passed to
-   _Unwind_Backtrace.  */
+/* Return the PC of the frame CONTEXT, adjusted to point into the
+   call instruction if it is a return address.  */
 
-static _Unwind_Reason_Code
-simple_unwind (struct _Unwind_Context *context, void *vdata)
+static inline uintptr_t
+simple_context_pc (struct _Unwind_Context *context)
 {
-  struct backtrace_simple_data *bdata = (struct backtrace_simple_data *) vdata;
   uintptr_t pc;
   int ip_before_insn = 0;
 
@@ -71,16 +84,27 @@ simple_unwind (struct _Unwind_Context *context, void *vdata)
   pc = _Unwind_GetIP (context);
 #endif
 
+  if (!ip_before_insn)
+    --pc;
+
+  return pc;
+}
+
+/* Unwind library callback routine.  This is passed to
+   _Unwind_Backtrace.  */
+
+static _Unwind_Reason_Code
+simple_unwind (struct _Unwind_Context *context, void *vdata)
+{
+  struct backtrace_simple_data *bdata = (struct backtrace_simple_data *) vdata;
+
   if (bdata->skip > 0)
     {
       --bdata->skip;
       return _URC_NO_REASON;
     }
 
-  if (!ip_before_insn)
-    --pc;
-
-  bdata->ret = bdata->callback (bdata->data, pc);
+  bdata->ret = bdata->callback (bdata->data, simple_context_pc (context));
 
   if (bdata->ret != 0)
     return _URC_END_OF_STACK;
@@ -88,6 +112,480 @@ simple_unwind (struct _Unwind_Context *context, void *vdata)
   return _URC_NO_REASON;
 }
 
+/* Data passed through _Unwind_Backtrace by backtrace_capture.  */
+
+struct backtrace_capture_data
+{
+  /* Number of frames to skip.  */
+  int skip;
+  /* Where to store the PCs.  */
+  uintptr_t *pcs;
+  /* The number of PCs stored so far.  */
+  int count;
+  /* The size of the PCS array.  */
+  int max;
+};
+
+/* Unwind library callback routine for backtrace_capture.  */
+
+static _Unwind_Reason_Code
+simple_capture_unwind (struct _Unwind_Context *context, void *vdata)
+{
+  struct backtrace_capture_data *cdata =
+    (struct backtrace_capture_data *) vdata;
+
+  if (cdata->skip > 0)
+    {
+      --cdata->skip;
+      return _URC_NO_REASON;
+    }
+
+  cdata->pcs[cdata->count] = simple_context_pc (context);
+  ++cdata->count;
+
+  if (cdata->count >= cdata->max)
+    return _URC_END_OF_STACK;
+
+  return _URC_NO_REASON;
+}
+
+#if BACKTRACE_FRAME_POINTER_UNWIND
+
+/* The bounds of the current thread's stack, looked up the first time
+   the thread unwinds using frame pointers.  STACK_HI is zero if they
+   are not yet known.  */
+
+static __thread uintptr_t stack_lo;
+static __thread uintptr_t stack_hi;
+
+/* Set *LO and *HI to the bounds of the current thread's stack.
+   Returns 1 on success, 0 if they are not known.  */
+
+static int
+simple_stack_bounds (uintptr_t *lo, uintptr_t *hi)
+{
+  if (stack_hi == 0)
+    {
+      pthread_attr_t attr;
+      void *addr;
+      size_t size;
+      int r;
+
+      if (pthread_getattr_np (pthread_self (), &attr) != 0)
+	return 0;
+      r = pthread_attr_getstack (&attr, &addr, &size);
+      pthread_attr_destroy (&attr);
+      if (r != 0 || size == 0)
+	return 0;
+      stack_lo = (uintptr_t) addr;
+      stack_hi = (uintptr_t) addr + size;
+    }
+
+  *lo = stack_lo;
+  *hi = stack_hi;
+  return 1;
+}
+
+/* The smallest page size of any system we support.  */
+
+#define SIMPLE_MIN_PAGE 4096
+
+/* Set *LO and *HI to the bounds of the stack of a thread interrupted
+   by a signal with stack pointer SP.  This runs in the signal
+   handler, so it must not allocate memory.  REGIONS, if not NULL, is
+   NREGIONS pairs of addresses, sorted by start address, of memory
+   known to be readable; the stack is the region containing SP.
+   Otherwise, use the bounds of the thread stack if they have been
+   looked up.  If neither tells us anything, all we know is that the
+   page containing SP is mapped, so only that page is read.  */
+
+static void
+simple_signal_stack_bounds (uintptr_t sp, const uintptr_t *regions,
+			    size_t nregions, uintptr_t *lo, uintptr_t *hi)
+{
+  if (regions != NULL)
+    {
+      size_t l;
+      size_t h;
+
+      /* Find the last region that starts at or below SP.  */
+      l = 0;
+      h = nregions;
+      while (l < h)
+	{
+	  size_t mid;
+
+	  mid = l + (h - l) / 2;
+	  if (regions[2 * mid] <= sp)
+	    l = mid + 1;
+	  else
+	    h = mid;
+	}
+      if (l > 0 && sp < regions[2 * (l - 1) + 1])
+	{
+	  *lo = regions[2 * (l - 1)];
+	  *hi = (regions[2 * (l - 1) + 1]
+		 & ~(uintptr_t) (sizeof (uintptr_t) - 1));
+	  return;
+	}
+    }
+
+  if (stack_hi != 0 && sp >= stack_lo && sp < stack_hi)
+    {
+      *lo = stack_lo;
+      *hi = stack_hi;
+    }
+  else
+    {
+      *lo = sp;
+      *hi = (sp | (uintptr_t) (SIMPLE_MIN_PAGE - 1)) + 1;
+    }
+}
+
+/* Return whether the frame record at FP lies entirely within the
+   stack bounds LO and HI and is properly aligned.  */
+
+static inline int
+simple_fp_ok (uintptr_t fp, uintptr_t lo, uintptr_t hi)
+{
+  return (fp >= lo
+	  && fp < hi - 2 * sizeof (uintptr_t)
+	  && (fp & (sizeof (uintptr_t) - 1)) == 0);
+}
+
+/* The state of a walk along the chain of frame records.  */
+
+struct simple_fp_walk
+{
+  /* The bounds of the stack.  */
+  uintptr_t lo;
+  uintptr_t hi;
+  /* The next frame record, or zero at the end of the chain.  */
+  uintptr_t frame;
+};
+
+/* Start a walk along the chain of frame records at FP.  Returns 1 on
+   success, 0 if FP is not usable.  */
+
+static int
+simple_fp_start (struct simple_fp_walk *walk, uintptr_t fp)
+{
+  if (!simple_stack_bounds (&walk->lo, &walk->hi))
+    return 0;
+
+  /* If we are not running on the thread stack, as happens in a signal
+     handler that uses an alternate signal stack, give up.  */
+  if (!simple_fp_ok (fp, walk->lo, walk->hi))
+    return 0;
+
+  walk->frame = fp;
+  return 1;
+}
+
+/* Step WALK to the next frame record, setting *PC to the return
+   address in the current one.  The chain ends at a null frame
+   pointer or return address, or at a frame pointer that is outside
+   the stack, which is what we see when we reach code that does not
+   maintain a frame pointer.  Each frame must be above the previous
+   one, as the stack grows down on all processors for which we do
+   this.  Returns 1 if *PC was set, 0 at the end of the chain, and -1
+   if the chain is corrupt; this can happen if some code uses the
+   frame pointer register for some other purpose.  */
+
+static inline int
+simple_fp_next (struct simple_fp_walk *walk, uintptr_t *pc)
+{
+  const uintptr_t *rec;
+  uintptr_t next;
+
+  if (walk->frame == 0)
+    return 0;
+
+  rec = (const uintptr_t *) walk->frame;
+  next = rec[0];
+  *pc = rec[1];
+  if (*pc == 0)
+    return 0;
+
+  if (next == 0 || next < walk->lo || next >= walk->hi)
+    next = 0;
+  else if (next <= walk->frame || !simple_fp_ok (next, walk->lo, walk->hi))
+    return -1;
+
+  walk->frame = next;
+  return 1;
+}
+
+/* Walk the chain of frame records starting at FP, the frame of
+   backtrace_simple.  The chain is walked twice: once to check that it
+   is valid, and then again to call the callback.  This lets us fall
+   back to the unwind library if the chain is bad, or too short to
+   report any frames, without having already reported a partial
+   backtrace.  Returns 1 if the backtrace was reported, setting *RET
+   to the value to return from backtrace_simple.  Returns 0 if the
+   caller should use the unwind library.  */
+
+static int
+simple_unwind_fp (uintptr_t fp, int skip, backtrace_simple_callback callback,
+		  void *data, int *ret)
+{
+  struct simple_fp_walk start;
+  int pass;
+
+  if (!simple_fp_start (&start, fp))
+    return 0;
+
+  for (pass = 0; pass < 2; ++pass)
+    {
+      struct simple_fp_walk walk;
+      int count;
+      int step;
+      uintptr_t pc;
+
+      walk = start;
+      count = skip;
+      while ((step = simple_fp_next (&walk, &pc)) > 0)
+	{
+	  if (pass == 0)
+	    --count;
+	  else if (count > 0)
+	    --count;
+	  else
+	    {
+	      /* PC is a return address, so back up to the call
+		 instruction, as simple_unwind does.  */
+	      *ret = callback (data, pc - 1);
+	      if (*ret != 0)
+		return 1;
+	    }
+	}
+
+      /* If there are no frames to report after skipping, let the
+	 unwind library report the error.  */
+      if (pass == 0 && (step < 0 || count >= 0))
+	return 0;
+    }
+
+  *ret = 0;
+  return 1;
+}
+
+/* Store up to MAX PCs from the chain of frame records starting at FP
+   in PCS, after skipping SKIP frames.  Returns the number of PCs
+   stored, or -1 if the caller should use the unwind library.  */
+
+static int
+simple_capture_fp (uintptr_t fp, int skip, uintptr_t *pcs, int max)
+{
+  struct simple_fp_walk walk;
+  int count;
+  int step;
+  uintptr_t pc;
+
+  if (!simple_fp_start (&walk, fp))
+    return -1;
+
+  count = 0;
+  step = 0;
+  while (count < max)
+    {
+      step = simple_fp_next (&walk, &pc);
+      if (step <= 0)
+	break;
+      if (skip > 0)
+	--skip;
+      else
+	pcs[count++] = pc - 1;
+    }
+
+  if (count == 0 || step < 0)
+    return -1;
+  return count;
+}
+
+#if BACKTRACE_EH_FRAME_UNWIND
+
+/* Walk the stack using the built-in unwinder, starting from REGS,
+   the registers of backtrace_simple.  As with simple_unwind_fp the
+   stack is walked twice, so that we can fall back to the unwind
+   library if we find a frame that we can't unwind.  Returns 1 if the
+   backtrace was reported, setting *RET, or 0 if the caller should use
+   the unwind library.  */
+
+static int
+simple_unwind_eh (struct backtrace_state *state,
+		  const struct backtrace_unwind_regs *regs, int skip,
+		  backtrace_simple_callback callback, void *data, int *ret)
+{
+  uintptr_t lo;
+  uintptr_t hi;
+  int pass;
+
+  if (!simple_stack_bounds (&lo, &hi))
+    return 0;
+
+  if (regs->sp < lo || regs->sp >= hi)
+    return 0;
+
+  for (pass = 0; pass < 2; ++pass)
+    {
+      struct backtrace_unwind_regs r;
+      int count;
+      int step;
+
+      r = *regs;
+      count = skip;
+
+      /* Step out of backtrace_simple to our caller, which is the
+	 first frame we report.  */
+      step = backtrace_eh_frame_step (state, &r, lo, hi);
+      while (step > 0)
+	{
+	  if (pass == 0)
+	    --count;
+	  else if (count > 0)
+	    --count;
+	  else
+	    {
+	      *ret = callback (data, r.exact ? r.pc : r.pc - 1);
+	      if (*ret != 0)
+		return 1;
+	    }
+
+	  step = backtrace_eh_frame_step (state, &r, lo, hi);
+	}
+
+      if (pass == 0 && (step < 0 || count >= 0))
+	return 0;
+    }
+
+  *ret = 0;
+  return 1;
+}
+
+/* Store up to MAX PCs in PCS using the built-in unwinder, starting
+   from REGS, after skipping SKIP frames.  Returns the number of PCs
+   stored, or -1 if the caller should use the unwind library.  */
+
+static int
+simple_capture_eh (struct backtrace_state *state,
+		   const struct backtrace_unwind_regs *regs, int skip,
+		   uintptr_t *pcs, int max)
+{
+  struct backtrace_unwind_regs r;
+  uintptr_t lo;
+  uintptr_t hi;
+  int count;
+  int step;
+
+  if (!simple_stack_bounds (&lo, &hi))
+    return -1;
+
+  if (regs->sp < lo || regs->sp >= hi)
+    return -1;
+
+  r = *regs;
+  count = 0;
+  step = 0;
+  while (count < max)
+    {
+      step = backtrace_eh_frame_step (state, &r, lo, hi);
+      if (step <= 0)
+	break;
+      if (skip > 0)
+	--skip;
+      else
+	pcs[count++] = r.exact ? r.pc : r.pc - 1;
+    }
+
+  if (count == 0 || step < 0)
+    return -1;
+  return count;
+}
+
+#endif /* BACKTRACE_EH_FRAME_UNWIND */
+
+#ifdef HAVE_SIGNAL_CONTEXT
+
+/* Set REGS to the registers in CONTEXT, the ucontext_t passed to an
+   SA_SIGINFO signal handler.  */
+
+static void
+simple_context_regs (const void *context, struct backtrace_unwind_regs *regs)
+{
+  const ucontext_t *uc = (const ucontext_t *) context;
+
+#if defined (__x86_64__)
+  regs->pc = (uintptr_t) uc->uc_mcontext.gregs[REG_RIP];
+  regs->sp = (uintptr_t) uc->uc_mcontext.gregs[REG_RSP];
+  regs->fp = (uintptr_t) uc->uc_mcontext.gregs[REG_RBP];
+  regs->lr = 0;
+#elif defined (__i386__)
+  regs->pc = (uintptr_t) uc->uc_mcontext.gregs[REG_EIP];
+  regs->sp = (uintptr_t) uc->uc_mcontext.gregs[REG_ESP];
+  regs->fp = (uintptr_t) uc->uc_mcontext.gregs[REG_EBP];
+  regs->lr = 0;
+#else
+  regs->pc = (uintptr_t) uc->uc_mcontext.pc;
+  regs->sp = (uintptr_t) uc->uc_mcontext.sp;
+  regs->fp = (uintptr_t) uc->uc_mcontext.regs[29];
+  regs->lr = (uintptr_t) uc->uc_mcontext.regs[30];
+#endif
+  regs->exact = 1;
+}
+
+/* If REGS, the registers of an interrupted function, are at an
+   instruction at the start or end of the function where the frame
+   pointer register still points at the frame record of the caller,
+   return the return address into the caller; otherwise return 0.
+   Following the chain of frame records would skip the caller in
+   that case.  These are the instructions that GCC and clang emit
+   when they maintain a frame pointer.  */
+
+static uintptr_t
+simple_leaf_return (const struct backtrace_unwind_regs *regs,
+		    uintptr_t lo, uintptr_t hi)
+{
+#if defined (__x86_64__) || defined (__i386__)
+  const unsigned char *p;
+  uintptr_t addr;
+
+  p = (const unsigned char *) regs->pc;
+  if (p[0] == 0x55					/* push %rbp */
+      || p[0] == 0xc3					/* ret */
+      || (p[0] == 0xf3 && p[1] == 0x0f && p[2] == 0x1e
+	  && (p[3] == 0xfa || p[3] == 0xfb)))		/* endbr */
+    addr = regs->sp;
+#if defined (__x86_64__)
+  else if (p[0] == 0x48 && p[1] == 0x89 && p[2] == 0xe5) /* mov %rsp,%rbp */
+#else
+  else if (p[0] == 0x89 && p[1] == 0xe5)		/* mov %esp,%ebp */
+#endif
+    addr = regs->sp + sizeof (uintptr_t);
+  else
+    return 0;
+
+  if (addr < lo || addr > hi - sizeof (uintptr_t))
+    return 0;
+  return *(const uintptr_t *) addr;
+#else
+  uint32_t insn;
+
+  insn = *(const uint32_t *) regs->pc;
+  if ((insn & 0xffc07fff) == 0xa9807bfd	/* stp x29, x30, [sp, #-N]! */
+      || insn == 0x910003fd		/* mov x29, sp */
+      || insn == 0xd503233f		/* paciasp */
+      || insn == 0xd503245f		/* bti c */
+      || insn == 0xd65f03c0)		/* ret */
+    return regs->lr;
+  return 0;
+#endif
+}
+
+#endif /* HAVE_SIGNAL_CONTEXT */
+
+#endif /* BACKTRACE_FRAME_POINTER_UNWIND */
+
 /* Get a simple stack backtrace.  */
 
 int __attribute__((noinline))
@@ -97,6 +595,31 @@ backtrace_simple (struct backtrace_state *state, int skip,
 {
   struct backtrace_simple_data bdata;
 
+#if BACKTRACE_FRAME_POINTER_UNWIND
+  if (state->unwind_mode == BACKTRACE_UNWIND_FRAME_POINTER)
+    {
+      int ret;
+
+      /* The frame record of this function holds the return address
+	 into our caller, which is the first frame we report.  */
+      if (simple_unwind_fp ((uintptr_t) __builtin_frame_address (0), skip,
+			    callback, data, &ret))
+	return ret;
+    }
+#endif
+
+#if BACKTRACE_EH_FRAME_UNWIND
+  if (state->unwind_mode == BACKTRACE_UNWIND_EH_FRAME)
+    {
+      struct backtrace_unwind_regs regs;
+      int ret;
+
+      backtrace_unwind_regs_capture (regs);
+      if (simple_unwind_eh (state, &regs, skip, callback, data, &ret))
+	return ret;
+    }
+#endif
+
   bdata.skip = skip + 1;
   bdata.state = state;
   bdata.callback = callback;
@@ -106,3 +629,122 @@ backtrace_simple (struct backtrace_state *state, int skip,
   _Unwind_Backtrace (simple_unwind, &bdata);
   return bdata.ret;
 }
+
+/* Store a stack backtrace in an array.  */
+
+int __attribute__((noinline))
+backtrace_capture (struct backtrace_state *state, int skip, uintptr_t *pcs,
+		   int max)
+{
+  struct backtrace_capture_data cdata;
+
+  if (max <= 0)
+    return 0;
+
+#if BACKTRACE_FRAME_POINTER_UNWIND
+  if (state->unwind_mode == BACKTRACE_UNWIND_FRAME_POINTER)
+    {
+      int count;
+
+      count = simple_capture_fp ((uintptr_t) __builtin_frame_address (0),
+				 skip, pcs, max);
+      if (count >= 0)
+	return count;
+    }
+#endif
+
+#if BACKTRACE_EH_FRAME_UNWIND
+  if (state->unwind_mode == BACKTRACE_UNWIND_EH_FRAME)
+    {
+      struct backtrace_unwind_regs regs;
+      int count;
+
+      backtrace_unwind_regs_capture (regs);
+      count = simple_capture_eh (state, &regs, skip, pcs, max);
+      if (count >= 0)
+	return count;
+    }
+#endif
+
+  cdata.skip = skip + 1;
+  cdata.pcs = pcs;
+  cdata.count = 0;
+  cdata.max = max;
+  _Unwind_Backtrace (simple_capture_unwind, &cdata);
+  return cdata.count;
+}
+
+/* Store the stack of the code interrupted by a signal in an
+   array.  */
+
+int
+backtrace_capture_context (struct backtrace_state *state ATTRIBUTE_UNUSED,
+			   const void *context ATTRIBUTE_UNUSED,
+			   const uintptr_t *regions ATTRIBUTE_UNUSED,
+			   size_t nregions ATTRIBUTE_UNUSED,
+			   uintptr_t *pcs ATTRIBUTE_UNUSED,
+			   int max ATTRIBUTE_UNUSED)
+{
+#if BACKTRACE_FRAME_POINTER_UNWIND && defined (HAVE_SIGNAL_CONTEXT)
+  struct backtrace_unwind_regs regs;
+  struct simple_fp_walk walk;
+  uintptr_t pc;
+  int count;
+
+  if (max <= 0 || context == NULL)
+    return 0;
+
+  simple_context_regs (context, &regs);
+  simple_signal_stack_bounds (regs.sp, regions, nregions, &walk.lo,
+			      &walk.hi);
+
+  /* The first PC is where the signal arrived, so it is not adjusted
+     as a return address would be.  */
+  pcs[0] = regs.pc;
+  count = 1;
+
+#if BACKTRACE_EH_FRAME_UNWIND
+  if (state->unwind_mode == BACKTRACE_UNWIND_EH_FRAME)
+    {
+      struct backtrace_unwind_regs r;
+
+      r = regs;
+      while (count < max
+	     && backtrace_eh_frame_step (state, &r, walk.lo, walk.hi) > 0)
+	pcs[count++] = r.exact ? r.pc : r.pc - 1;
+
+      /* If the interrupted function has no unwind information, try
+	 the frame pointers.  */
+      if (count > 1)
+	return count;
+    }
+#endif
+
+  /* The unwind library is not async-signal-safe, so in the default
+     mode we follow the frame pointers too.  A bad chain just ends the
+     backtrace.  */
+  pc = simple_leaf_return (&regs, walk.lo, walk.hi);
+  if (pc != 0 && count < max)
+    pcs[count++] = pc - 1;
+  walk.frame = simple_fp_ok (regs.fp, walk.lo, walk.hi) ? regs.fp : 0;
+  while (count < max && simple_fp_next (&walk, &pc) > 0)
+    pcs[count++] = pc - 1;
+  return count;
+#else
+  return 0;
+#endif
+}
+
+/* Look up the bounds of the current thread's stack for
+   backtrace_capture_context.  */
+
+void
+backtrace_capture_prepare (void)
+{
+#if BACKTRACE_FRAME_POINTER_UNWIND
+  uintptr_t lo;
+  uintptr_t hi;
+
+  simple_stack_bounds (&lo, &hi);
+#endif
+}
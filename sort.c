@@ -33,6 +33,7 @@ POSSIBILITY OF SUCH DAMAGE.  */
 #include "config.h"
 
 #include <stddef.h>
+#include <string.h>
 #include <sys/types.h>
 
 #include "backtrace.h"
@@ -40,7 +41,19 @@ POSSIBILITY OF SUCH DAMAGE.  */
 
 /* The GNU glibc version of qsort allocates memory, which we must not
    do if we are invoked by a signal handler.  So provide our own
-   sort.  */
+   sort.
+
+   This is an introsort: a quicksort that picks a median of three
+   pivot, finishes small ranges with an insertion sort, and falls back
+   to a heapsort if the recursion gets too deep, so that it is never
+   worse than O(N log N).  The tables we sort have millions of entries
+   for large programs, so the inner loops matter.  */
+
+/* Ranges of at most this many elements are insertion sorted.  */
+
+#define SORT_INSERTION_MAX 12
+
+/* Swap SIZE bytes at A and B a byte at a time.  */
 
 static void
 swap (char *a, char *b, size_t size)
@@ -57,52 +70,196 @@ swap (char *a, char *b, size_t size)
     }
 }
 
-void
-backtrace_qsort (void *basearg, size_t count, size_t size,
-		 int (*compar) (const void *, const void *))
+/* Swap SIZE bytes at A and B a word at a time.  SIZE must be a
+   multiple of the word size.  This uses memcpy rather than accessing
+   the elements through a uintptr_t pointer, which would break the
+   aliasing rules; the compiler turns each memcpy into a single load
+   or store.  */
+
+static void
+swap_words (char *a, char *b, size_t size)
 {
-  char *base = (char *) basearg;
   size_t i;
-  size_t mid;
 
- tail_recurse:
-  if (count < 2)
-    return;
+  for (i = 0; i < size; i += sizeof (uintptr_t))
+    {
+      uintptr_t ta;
+      uintptr_t tb;
+
+      memcpy (&ta, a + i, sizeof ta);
+      memcpy (&tb, b + i, sizeof tb);
+      memcpy (a + i, &tb, sizeof tb);
+      memcpy (b + i, &ta, sizeof ta);
+    }
+}
 
-  /* The symbol table and DWARF tables, which is all we use this
-     routine for, tend to be roughly sorted.  Pick the middle element
-     in the array as our pivot point, so that we are more likely to
-     cut the array in half for each recursion step.  */
-  swap (base, base + (count / 2) * size, size);
+/* The parameters of one sort.  */
+
+struct sort_data
+{
+  size_t size;
+  int (*compar) (const void *, const void *);
+  void (*swap) (char *, char *, size_t);
+};
+
+/* Sort COUNT elements at BASE by insertion.  */
+
+static void
+insertion_sort (const struct sort_data *sd, char *base, size_t count)
+{
+  size_t size = sd->size;
+  size_t i;
 
-  mid = 0;
   for (i = 1; i < count; i++)
     {
-      if ((*compar) (base, base + i * size) > 0)
-	{
-	  ++mid;
-	  if (i != mid)
-	    swap (base + mid * size, base + i * size, size);
-	}
+      char *p;
+
+      for (p = base + i * size;
+	   p > base && sd->compar (p - size, p) > 0;
+	   p -= size)
+	sd->swap (p - size, p, size);
     }
+}
 
-  if (mid > 0)
-    swap (base, base + mid * size, size);
+/* Move element I down the heap of COUNT elements at BASE.  */
+
+static void
+sift_down (const struct sort_data *sd, char *base, size_t i, size_t count)
+{
+  size_t size = sd->size;
 
-  /* Recurse with the smaller array, loop with the larger one.  That
-     ensures that our maximum stack depth is log count.  */
-  if (2 * mid < count)
+  while (1)
     {
-      backtrace_qsort (base, mid, size, compar);
-      base += (mid + 1) * size;
-      count -= mid + 1;
-      goto tail_recurse;
+      size_t child;
+
+      child = 2 * i + 1;
+      if (child >= count)
+	break;
+      if (child + 1 < count
+	  && sd->compar (base + child * size, base + (child + 1) * size) < 0)
+	++child;
+      if (sd->compar (base + i * size, base + child * size) >= 0)
+	break;
+      sd->swap (base + i * size, base + child * size, size);
+      i = child;
     }
-  else
+}
+
+/* Sort COUNT elements at BASE with a heapsort.  */
+
+static void
+heap_sort (const struct sort_data *sd, char *base, size_t count)
+{
+  size_t size = sd->size;
+  size_t i;
+
+  for (i = count / 2; i > 0; i--)
+    sift_down (sd, base, i - 1, count);
+  for (i = count - 1; i > 0; i--)
     {
-      backtrace_qsort (base + (mid + 1) * size, count - (mid + 1),
-		       size, compar);
-      count = mid;
-      goto tail_recurse;
+      sd->swap (base, base + i * size, size);
+      sift_down (sd, base, 0, i);
     }
 }
+
+/* Sort COUNT elements at BASE.  DEPTH is the number of times we may
+   still partition before switching to a heapsort.  */
+
+static void
+intro_sort (const struct sort_data *sd, char *base, size_t count,
+	    unsigned int depth)
+{
+  size_t size = sd->size;
+
+  while (count > SORT_INSERTION_MAX)
+    {
+      char *mid;
+      char *last;
+      size_t i;
+      size_t j;
+
+      if (depth == 0)
+	{
+	  heap_sort (sd, base, count);
+	  return;
+	}
+      --depth;
+
+      /* The symbol table and DWARF tables, which is all we use this
+	 routine for, tend to be roughly sorted, so the median of the
+	 first, middle and last elements is usually a good pivot.  Put
+	 it at the start of the array.  */
+      mid = base + (count / 2) * size;
+      last = base + (count - 1) * size;
+      if (sd->compar (mid, base) < 0)
+	sd->swap (mid, base, size);
+      if (sd->compar (last, mid) < 0)
+	{
+	  sd->swap (last, mid, size);
+	  if (sd->compar (mid, base) < 0)
+	    sd->swap (mid, base, size);
+	}
+      sd->swap (base, mid, size);
+
+      /* Partition around the pivot.  Both scans stop at elements
+	 equal to the pivot, so that many equal elements still split
+	 the array evenly.  */
+      i = 0;
+      j = count;
+      while (1)
+	{
+	  do
+	    ++i;
+	  while (i < count && sd->compar (base + i * size, base) < 0);
+	  do
+	    --j;
+	  while (sd->compar (base + j * size, base) > 0);
+	  if (i >= j)
+	    break;
+	  sd->swap (base + i * size, base + j * size, size);
+	}
+      sd->swap (base, base + j * size, size);
+
+      /* Recurse with the smaller array, loop with the larger one.
+	 That ensures that our maximum stack depth is log count.  */
+      if (2 * j < count)
+	{
+	  intro_sort (sd, base, j, depth);
+	  base += (j + 1) * size;
+	  count -= j + 1;
+	}
+      else
+	{
+	  intro_sort (sd, base + (j + 1) * size, count - (j + 1), depth);
+	  count = j;
+	}
+    }
+
+  insertion_sort (sd, base, count);
+}
+
+void
+backtrace_qsort (void *basearg, size_t count, size_t size,
+		 int (*compar) (const void *, const void *))
+{
+  struct sort_data sd;
+  unsigned int depth;
+  size_t c;
+
+  if (count < 2)
+    return;
+
+  sd.size = size;
+  sd.compar = compar;
+  if (size % sizeof (uintptr_t) == 0
+      && (uintptr_t) basearg % sizeof (uintptr_t) == 0)
+    sd.swap = swap_words;
+  else
+    sd.swap = swap;
+
+  depth = 0;
+  for (c = count; c > 1; c >>= 1)
+    depth += 2;
+
+  intro_sort (&sd, (char *) basearg, count, depth);
+}
@@ -70,3 +70,94 @@ backtrace_create_state (const char *filename, int threaded,
 
   return state;
 }
+
+/* Create a backtrace state for a list of object files.  */
+
+struct backtrace_state *
+backtrace_create_state_from_modules (const struct backtrace_module *modules,
+				     int count, int threaded,
+				     backtrace_error_callback error_callback,
+				     void *data)
+{
+  struct backtrace_state *state;
+
+  if (count <= 0)
+    {
+      error_callback (data, "no modules", 0);
+      return NULL;
+    }
+
+  state = backtrace_create_state (NULL, threaded, error_callback, data);
+  if (state == NULL)
+    return NULL;
+
+  if (!backtrace_initialize_modules (state, modules, count, error_callback,
+				     data))
+    return NULL;
+
+  return state;
+}
+
+/* Read all the debug info for STATE and stop writing to the memory
+   that holds it.  */
+
+int
+backtrace_state_freeze (struct backtrace_state *state,
+			backtrace_error_callback error_callback, void *data)
+{
+  if (!backtrace_fileline_initialize (state, error_callback, data))
+    return 0;
+
+  if (state->fileline_initialization_failed)
+    return 0;
+
+  backtrace_dwarf_read_all (state, error_callback, data);
+
+  if (!backtrace_alloc_freeze (state, error_callback, data))
+    return 0;
+
+  state->frozen = 1;
+
+  return 1;
+}
+
+/* Select how backtrace_simple walks the stack.  */
+
+int
+backtrace_set_unwind_mode (struct backtrace_state *state, int mode,
+			   backtrace_error_callback error_callback,
+			   void *data)
+{
+  switch (mode)
+    {
+    case BACKTRACE_UNWIND_DEFAULT:
+      break;
+    case BACKTRACE_UNWIND_FRAME_POINTER:
+      if (!BACKTRACE_FRAME_POINTER_UNWIND)
+	{
+	  error_callback (data,
+			  "frame pointer unwinding not supported on this system",
+			  0);
+	  return 0;
+	}
+      break;
+    case BACKTRACE_UNWIND_EH_FRAME:
+      if (!backtrace_eh_frame_init (state, error_callback, data))
+	return 0;
+      break;
+    default:
+      error_callback (data, "unknown unwind mode", 0);
+      return 0;
+    }
+
+  state->unwind_mode = mode;
+  return 1;
+}
+
+/* Read the list of modules for the built-in unwinder again.  */
+
+void
+backtrace_update_modules (struct backtrace_state *state)
+{
+  backtrace_eh_frame_sync (state);
+}
@@ -35,6 +35,7 @@ POSSIBILITY OF SUCH DAMAGE.  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <sys/types.h>
 
 #include "backtrace.h"
@@ -109,13 +110,219 @@ compare (const void *a, const void *b)
   return *ai - *bi;
 }
 
+/* An element shaped like the symbol and address tables that the
+   library sorts: an address key and two more words.  */
+
+struct entry
+{
+  uintptr_t address;
+  size_t id;
+  const char *name;
+};
+
+static int
+entry_compare (const void *a, const void *b)
+{
+  const struct entry *ea = (const struct entry *) a;
+  const struct entry *eb = (const struct entry *) b;
+
+  if (ea->address < eb->address)
+    return -1;
+  else if (ea->address > eb->address)
+    return 1;
+  else
+    return 0;
+}
+
+/* The kinds of input for the larger tests.  */
+
+enum order
+{
+  ORDER_RANDOM,
+  ORDER_SORTED,
+  ORDER_REVERSED,
+  ORDER_NEARLY_SORTED,
+  ORDER_FEW_KEYS,
+  ORDER_COUNT
+};
+
+static const char * const order_names[ORDER_COUNT] =
+  {
+    "random", "sorted", "reversed", "nearly sorted", "few keys"
+  };
+
+/* Fill E with COUNT entries in ORDER.  */
+
+static void
+fill (struct entry *e, size_t count, enum order order)
+{
+  size_t i;
+
+  for (i = 0; i < count; i++)
+    {
+      switch (order)
+	{
+	case ORDER_RANDOM:
+	  e[i].address = ((uintptr_t) rand () << 16) ^ (uintptr_t) rand ();
+	  break;
+	case ORDER_SORTED:
+	case ORDER_NEARLY_SORTED:
+	  e[i].address = i * 16;
+	  break;
+	case ORDER_REVERSED:
+	  e[i].address = (count - i) * 16;
+	  break;
+	case ORDER_FEW_KEYS:
+	  e[i].address = (uintptr_t) (rand () % 4);
+	  break;
+	default:
+	  abort ();
+	}
+      e[i].id = i;
+      e[i].name = NULL;
+    }
+
+  if (order == ORDER_NEARLY_SORTED)
+    {
+      for (i = 0; i < count / 100; i++)
+	{
+	  size_t a;
+	  size_t b;
+	  struct entry t;
+
+	  a = (size_t) rand () % count;
+	  b = (size_t) rand () % count;
+	  t = e[a];
+	  e[a] = e[b];
+	  e[b] = t;
+	}
+    }
+}
+
+/* Check that the COUNT entries in E are sorted and are a permutation
+   of the input.  SEEN is scratch space.  */
+
+static int
+check_sorted (const struct entry *e, size_t count, char *seen)
+{
+  size_t i;
+
+  memset (seen, 0, count);
+  for (i = 0; i < count; i++)
+    {
+      if (i > 0 && e[i - 1].address > e[i].address)
+	return 0;
+      if (e[i].id >= count || seen[e[i].id])
+	return 0;
+      seen[e[i].id] = 1;
+    }
+  return 1;
+}
+
+/* Sort larger arrays of each kind.  */
+
+static int
+test_large (void)
+{
+  static const size_t counts[] = { 13, 100, 1000, 100000 };
+  struct entry *e;
+  char *seen;
+  size_t max;
+  size_t i;
+  int o;
+  int failures;
+
+  max = counts[sizeof counts / sizeof counts[0] - 1];
+  e = (struct entry *) malloc (max * sizeof *e);
+  seen = (char *) malloc (max);
+  if (e == NULL || seen == NULL)
+    {
+      fprintf (stderr, "malloc failed\n");
+      exit (EXIT_FAILURE);
+    }
+
+  failures = 0;
+  for (i = 0; i < sizeof counts / sizeof counts[0]; i++)
+    {
+      for (o = 0; o < ORDER_COUNT; o++)
+	{
+	  fill (e, counts[i], (enum order) o);
+	  backtrace_qsort (e, counts[i], sizeof *e, entry_compare);
+	  if (!check_sorted (e, counts[i], seen))
+	    {
+	      fprintf (stderr, "large test failed: %zu %s entries\n",
+		       counts[i], order_names[o]);
+	      ++failures;
+	    }
+	}
+    }
+
+  free (seen);
+  free (e);
+  return failures;
+}
+
+/* Time sorting COUNT entries of each kind, comparing against the C
+   library qsort.  */
+
+static void
+benchmark (size_t count)
+{
+  struct entry *e;
+  int o;
+
+  e = (struct entry *) malloc (count * sizeof *e);
+  if (e == NULL)
+    {
+      fprintf (stderr, "malloc failed\n");
+      exit (EXIT_FAILURE);
+    }
+
+  printf ("sorting %zu entries of %zu bytes\n", count, sizeof *e);
+  for (o = 0; o < ORDER_COUNT; o++)
+    {
+      double times[2];
+      int j;
+
+      for (j = 0; j < 2; j++)
+	{
+	  struct timespec start;
+	  struct timespec end;
+
+	  srand (1);
+	  fill (e, count, (enum order) o);
+	  clock_gettime (CLOCK_MONOTONIC, &start);
+	  if (j == 0)
+	    backtrace_qsort (e, count, sizeof *e, entry_compare);
+	  else
+	    qsort (e, count, sizeof *e, entry_compare);
+	  clock_gettime (CLOCK_MONOTONIC, &end);
+	  times[j] = ((double) (end.tv_sec - start.tv_sec) * 1000.0
+		      + (double) (end.tv_nsec - start.tv_nsec) / 1000000.0);
+	}
+      printf ("%-14s backtrace_qsort %8.2f ms  qsort %8.2f ms\n",
+	      order_names[o], times[0], times[1]);
+    }
+
+  free (e);
+}
+
+/* With -b, time sorting instead of testing.  An optional second
+   argument is the number of entries.  */
+
 int
-main (int argc ATTRIBUTE_UNUSED, char **argv ATTRIBUTE_UNUSED)
+main (int argc, char **argv)
 {
   int failures;
   size_t i;
   int a[MAX];
 
+  if (argc > 1 && strcmp (argv[1], "-b") == 0)
+    {
+      benchmark (argc > 2 ? (size_t) strtoul (argv[2], NULL, 10) : 4000000);
+      exit (EXIT_SUCCESS);
+    }
+
   failures = 0;
   for (i = 0; i < sizeof tests / sizeof tests[0]; i++)
     {
@@ -133,5 +340,7 @@ main (int argc ATTRIBUTE_UNUSED, char **argv ATTRIBUTE_UNUSED)
 	}
     }
 
+  failures += test_large ();
+
   exit (failures > 0 ? EXIT_FAILURE : EXIT_SUCCESS);
 }
@@ -0,0 +1,145 @@
+/* symtarget.c -- Generated program for testing btsymbolize.
+   Copyright (C) 2024 Free Software Foundation, Inc.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are
+met:
+
+    (1) Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+    (2) Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in
+    the documentation and/or other materials provided with the
+    distribution.
+
+    (3) The name of the author may not be used to
+    endorse or promote products derived from this software without
+    specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT,
+INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.  */
+
+
+/* This program has many small functions.  It prints queries for
+   btsymbolize that look up addresses in each of them, followed by
+   the expected function name:
+
+     FILE OFFSET FUNCTION  */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef HAVE_LINK_H
+#include <link.h>
+#endif
+
+/* Define a function.  */
+
+#define F(n)							\
+  static int sym_f##n (int) __attribute__ ((noinline, noclone));	\
+  static int sym_f##n (int i) { return i * n + n; }
+
+#define F8(n) F(n##0) F(n##1) F(n##2) F(n##3) F(n##4) F(n##5) F(n##6) F(n##7)
+#define F64(n) F8(n##0) F8(n##1) F8(n##2) F8(n##3) \
+  F8(n##4) F8(n##5) F8(n##6) F8(n##7)
+
+F64(1)
+F64(2)
+F64(3)
+F64(4)
+
+/* The table of functions.  */
+
+struct target
+{
+  int (*fn) (int);
+  const char *name;
+};
+
+#define T(n) { sym_f##n, "sym_f" #n },
+#define T8(n) T(n##0) T(n##1) T(n##2) T(n##3) T(n##4) T(n##5) T(n##6) T(n##7)
+#define T64(n) T8(n##0) T8(n##1) T8(n##2) T8(n##3) \
+  T8(n##4) T8(n##5) T8(n##6) T8(n##7)
+
+static const struct target targets[] =
+{
+  T64(1)
+  T64(2)
+  T64(3)
+  T64(4)
+};
+
+#define TARGET_COUNT (sizeof targets / sizeof targets[0])
+
+/* The number of different offsets used in each function.  */
+
+#define OFFSETS 4
+
+#if defined (HAVE_DL_ITERATE_PHDR) && defined (HAVE_LINK_H)
+
+/* A dl_iterate_phdr callback that records the load bias of the
+   executable, which is the first module.  */
+
+static int
+bias_callback (struct dl_phdr_info *info,
+	       size_t size __attribute__ ((unused)), void *data)
+{
+  *(uintptr_t *) data = info->dlpi_addr;
+  return 1;
+}
+
+#endif
+
+int
+main (int argc __attribute__ ((unused)), char **argv)
+{
+  char path[4096];
+  ssize_t len;
+  uintptr_t bias;
+  size_t i;
+  int j;
+  int sum;
+
+  len = readlink ("/proc/self/exe", path, sizeof path - 1);
+  if (len > 0)
+    path[len] = '\0';
+  else
+    strcpy (path, argv[0]);
+
+  bias = 0;
+#if defined (HAVE_DL_ITERATE_PHDR) && defined (HAVE_LINK_H)
+  dl_iterate_phdr (bias_callback, &bias);
+#endif
+
+  /* Visit the functions in a scrambled order, so that btsymbolize has
+     to sort them.  */
+  sum = 0;
+  for (j = 0; j < OFFSETS; ++j)
+    {
+      for (i = 0; i < TARGET_COUNT; ++i)
+	{
+	  const struct target *t;
+
+	  t = &targets[(i * 97) % TARGET_COUNT];
+	  printf ("%s 0x%lx %s\n", path,
+		  (unsigned long) ((uintptr_t) t->fn - bias + j), t->name);
+	  sum += t->fn (j);
+	}
+    }
+
+  return sum == 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -36,6 +36,8 @@ POSSIBILITY OF SUCH DAMAGE.  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <signal.h>
+#include <time.h>
 
 #include <pthread.h>
 
@@ -145,6 +147,415 @@ test1 (void)
   failures += this_fail;
 }
 
+/* The stack table used by test2.  */
+
+static struct backtrace_stack_table *table;
+
+/* The number of times that each thread interns each stack.  */
+
+#define INTERN_COUNT 1000
+
+static uint32_t intern_a (void) __attribute__ ((noinline, noclone));
+static uint32_t intern_b (void) __attribute__ ((noinline, noclone));
+
+static uint32_t
+intern_a (void)
+{
+  return backtrace_stack_capture (table, 0);
+}
+
+static uint32_t
+intern_b (void)
+{
+  return backtrace_stack_capture (table, 0);
+}
+
+/* The IDs seen by each thread in test2.  */
+
+static uint32_t ids[THREAD_COUNT][2];
+
+/* Intern two stacks, storing the IDs in TIDS the first time.
+   Returns non-zero if the IDs are not the same as last time.  */
+
+static int __attribute__ ((noinline, noclone))
+intern_check (uint32_t *tids)
+{
+  uint32_t a;
+  uint32_t b;
+
+  a = intern_a ();
+  b = intern_b ();
+  if (tids[0] == 0)
+    {
+      tids[0] = a;
+      tids[1] = b;
+      return 0;
+    }
+  return a != tids[0] || b != tids[1];
+}
+
+/* Intern the same two stacks many times.  This is called via
+   pthread_create.  It returns the number of failures, as void *.  */
+
+static void *
+test2_thread (void *arg)
+{
+  uint32_t *tids = &ids[(uintptr_t) arg][0];
+  int i;
+
+  for (i = 0; i < INTERN_COUNT; ++i)
+    {
+      if (intern_check (tids))
+	{
+	  fprintf (stderr, "test2: stack ID changed\n");
+	  return (void *) (uintptr_t) 1;
+	}
+    }
+  return (void *) (uintptr_t) 0;
+}
+
+/* A backtrace_stack_iterate callback that counts the stacks.  */
+
+static int
+count_stacks (void *data, uint32_t id ATTRIBUTE_UNUSED,
+	      const uintptr_t *pcs ATTRIBUTE_UNUSED, int count ATTRIBUTE_UNUSED)
+{
+  ++*(int *) data;
+  return 0;
+}
+
+/* Intern stacks from several threads at once.  */
+
+static void test2 (void) __attribute__ ((unused));
+
+static void
+test2 (void)
+{
+  pthread_t atid[THREAD_COUNT];
+  int i;
+  int errnum;
+  int this_fail;
+  void *ret;
+  int nstacks;
+  const uintptr_t *pcs;
+  struct backtrace_stack_table *small;
+  static const uintptr_t big_pcs[5] = { 1, 2, 3, 4, 5 };
+
+  table = backtrace_stack_table_create (state, 100, 10000,
+					error_callback_create, NULL);
+  if (table == NULL)
+    {
+      printf ("FAIL: threaded backtrace_stack_intern\n");
+      ++failures;
+      return;
+    }
+
+  for (i = 0; i < THREAD_COUNT; i++)
+    {
+      errnum = pthread_create (&atid[i], NULL, test2_thread,
+			       (void *) (uintptr_t) i);
+      if (errnum != 0)
+	{
+	  fprintf (stderr, "pthread_create %d: %s\n", i, strerror (errnum));
+	  exit (EXIT_FAILURE);
+	}
+    }
+
+  this_fail = 0;
+  for (i = 0; i < THREAD_COUNT; i++)
+    {
+      errnum = pthread_join (atid[i], &ret);
+      if (errnum != 0)
+	{
+	  fprintf (stderr, "pthread_join %d: %s\n", i, strerror (errnum));
+	  exit (EXIT_FAILURE);
+	}
+      this_fail += (int) (uintptr_t) ret;
+    }
+
+  /* All the threads have the same stacks.  */
+  for (i = 0; i < THREAD_COUNT; i++)
+    {
+      if (ids[i][0] == 0
+	  || ids[i][0] == ids[i][1]
+	  || ids[i][0] != ids[0][0]
+	  || ids[i][1] != ids[0][1])
+	{
+	  fprintf (stderr, "test2: thread %d: got IDs %u %u, want %u %u\n",
+		   i, (unsigned int) ids[i][0], (unsigned int) ids[i][1],
+		   (unsigned int) ids[0][0], (unsigned int) ids[0][1]);
+	  this_fail = 1;
+	}
+    }
+
+  nstacks = 0;
+  backtrace_stack_iterate (table, count_stacks, &nstacks);
+  if (nstacks != 2)
+    {
+      fprintf (stderr, "test2: got %d stacks, want 2\n", nstacks);
+      this_fail = 1;
+    }
+
+  if (backtrace_stack_get (table, ids[0][0], &pcs) < 3
+      || backtrace_stack_intern (table, pcs,
+				 backtrace_stack_get (table, ids[0][0], &pcs))
+	 != ids[0][0])
+    {
+      fprintf (stderr, "test2: backtrace_stack_get failed\n");
+      this_fail = 1;
+    }
+
+  /* A stack that does not fit in the PC pool must not use up an
+     entry.  */
+  small = backtrace_stack_table_create (state, 1, 4, error_callback_create,
+					NULL);
+  if (small == NULL
+      || backtrace_stack_intern (small, big_pcs, 5) != 0
+      || backtrace_stack_intern (small, big_pcs, 2) != 1)
+    {
+      fprintf (stderr, "test2: full PC pool used up an entry\n");
+      this_fail = 1;
+    }
+
+  printf ("%s: threaded backtrace_stack_intern\n",
+	  this_fail > 0 ? "FAIL" : "PASS");
+
+  failures += this_fail;
+}
+
+/* Set when the threads of test3 may exit.  */
+
+static volatile int dump_done;
+
+/* The number of threads of test3 that are waiting.  */
+
+static int dump_ready;
+
+static void dump_wait (void) __attribute__ ((noinline, noclone));
+
+/* Wait until test3 is done.  */
+
+static void
+dump_wait (void)
+{
+  struct timespec ts;
+
+  __sync_fetch_and_add (&dump_ready, 1);
+  while (!dump_done)
+    {
+      ts.tv_sec = 0;
+      ts.tv_nsec = 1000000;
+      nanosleep (&ts, NULL);
+    }
+}
+
+/* This is called via pthread_create.  */
+
+static void *
+test3_thread (void *arg ATTRIBUTE_UNUSED)
+{
+  dump_wait ();
+  return NULL;
+}
+
+/* The results of backtrace_dump_threads in test3.  */
+
+struct dump_result
+{
+  /* The number of threads reported.  */
+  int threads;
+  /* The number of threads with dump_wait on the stack.  */
+  int waiting;
+  /* Whether the current thread has had a dump_wait frame.  */
+  int seen;
+  /* Whether the next frame is the first of the current thread.  */
+  int first;
+  /* The number of stacks that start in backtrace_dump_threads.  */
+  int in_dump;
+};
+
+static int
+dump_thread_callback (void *data, int tid ATTRIBUTE_UNUSED, int count)
+{
+  struct dump_result *result = (struct dump_result *) data;
+
+  ++result->threads;
+  result->seen = 0;
+  result->first = 1;
+  if (count < 0)
+    fprintf (stderr, "test3: thread %d did not answer\n", tid);
+  return 0;
+}
+
+static int
+dump_frame_callback (void *data, uintptr_t pc ATTRIBUTE_UNUSED,
+		     const char *filename ATTRIBUTE_UNUSED,
+		     int lineno ATTRIBUTE_UNUSED, const char *function)
+{
+  struct dump_result *result = (struct dump_result *) data;
+
+  if (result->first
+      && function != NULL
+      && strcmp (function, "backtrace_dump_threads") == 0)
+    ++result->in_dump;
+  result->first = 0;
+
+  if (function != NULL
+      && strcmp (function, "dump_wait") == 0
+      && !result->seen)
+    {
+      ++result->waiting;
+      result->seen = 1;
+    }
+  return 0;
+}
+
+static void error_callback_ignore (void *, const char *, int)
+  __attribute__ ((unused));
+
+/* An error callback that ignores the error.  */
+
+static void
+error_callback_ignore (void *data ATTRIBUTE_UNUSED,
+		       const char *msg ATTRIBUTE_UNUSED,
+		       int errnum ATTRIBUTE_UNUSED)
+{
+}
+
+/* Dump the stacks of several threads that are waiting in the same
+   function.  */
+
+static void test3 (void) __attribute__ ((unused));
+
+static void
+test3 (void)
+{
+  pthread_t atid[THREAD_COUNT];
+  struct dump_result result;
+  int i;
+  int errnum;
+  int this_fail;
+
+  /* The signal handler never uses the unwind library, and the C
+     library is not compiled with frame pointers, so use the built-in
+     unwinder to get out of nanosleep.  */
+  if (!backtrace_set_unwind_mode (state, BACKTRACE_UNWIND_EH_FRAME,
+				  error_callback_ignore, NULL))
+    {
+      printf ("UNSUPPORTED: backtrace_dump_threads\n");
+      return;
+    }
+
+  for (i = 0; i < THREAD_COUNT; i++)
+    {
+      errnum = pthread_create (&atid[i], NULL, test3_thread, NULL);
+      if (errnum != 0)
+	{
+	  fprintf (stderr, "pthread_create %d: %s\n", i, strerror (errnum));
+	  exit (EXIT_FAILURE);
+	}
+    }
+
+  while (__sync_fetch_and_add (&dump_ready, 0) < THREAD_COUNT)
+    {
+      struct timespec ts;
+
+      ts.tv_sec = 0;
+      ts.tv_nsec = 1000000;
+      nanosleep (&ts, NULL);
+    }
+
+  memset (&result, 0, sizeof result);
+  backtrace_dump_threads (state, SIGURG, 100, 64, 5000, 4,
+			  dump_thread_callback, dump_frame_callback,
+			  error_callback_create, &result);
+
+  dump_done = 1;
+  for (i = 0; i < THREAD_COUNT; i++)
+    {
+      errnum = pthread_join (atid[i], NULL);
+      if (errnum != 0)
+	{
+	  fprintf (stderr, "pthread_join %d: %s\n", i, strerror (errnum));
+	  exit (EXIT_FAILURE);
+	}
+    }
+
+  this_fail = 0;
+  if (result.threads != THREAD_COUNT + 1
+      || result.waiting != THREAD_COUNT)
+    {
+      fprintf (stderr, "test3: got %d threads, %d waiting; want %d, %d\n",
+	       result.threads, result.waiting, THREAD_COUNT + 1,
+	       THREAD_COUNT);
+      this_fail = 1;
+    }
+  if (result.in_dump != 0)
+    {
+      fprintf (stderr, "test3: stack starts in backtrace_dump_threads\n");
+      this_fail = 1;
+    }
+
+  printf ("%s: backtrace_dump_threads\n", this_fail > 0 ? "FAIL" : "PASS");
+
+  failures += this_fail;
+}
+
+/* The backtrace_syminfo callback for test4, which records the symbol
+   name pointer itself.  */
+
+static void
+test4_syminfo_callback (void *vdata, uintptr_t pc ATTRIBUTE_UNUSED,
+			const char *symname,
+			uintptr_t symval ATTRIBUTE_UNUSED,
+			uintptr_t symsize ATTRIBUTE_UNUSED)
+{
+  *(const char **) vdata = symname;
+}
+
+/* Test that a second state for the same program, which shares the
+   module data read by the first state, gives the same results.  */
+
+static void test4 (const char *) __attribute__ ((unused));
+
+static void
+test4 (const char *filename)
+{
+  void *first;
+  void *second;
+  const char *name1;
+  const char *name2;
+  int this_fail;
+
+  first = state;
+  second = backtrace_create_state (filename, 1, error_callback_create, NULL);
+  state = second;
+  this_fail = (int) (uintptr_t) test1_thread (NULL);
+  state = first;
+
+  /* The symbol names come from the symbol table of the module, so if
+     the states share the module data the names are the same
+     pointer.  */
+  name1 = NULL;
+  name2 = NULL;
+  backtrace_syminfo ((struct backtrace_state *) first,
+		     (uintptr_t) test1_thread, test4_syminfo_callback,
+		     error_callback_create, &name1);
+  backtrace_syminfo ((struct backtrace_state *) second,
+		     (uintptr_t) test1_thread, test4_syminfo_callback,
+		     error_callback_create, &name2);
+  if (name1 == NULL || name1 != name2)
+    {
+      fprintf (stderr, "test4: symbol names %p and %p not shared\n",
+	       (const void *) name1, (const void *) name2);
+      this_fail = 1;
+    }
+
+  printf ("%s: shared module data\n", this_fail > 0 ? "FAIL" : "PASS");
+
+  failures += this_fail;
+}
+
 int
 main (int argc ATTRIBUTE_UNUSED, char **argv)
 {
@@ -154,6 +565,11 @@ main (int argc ATTRIBUTE_UNUSED, char **argv)
 #if BACKTRACE_SUPPORTED
 #if BACKTRACE_SUPPORTS_THREADS
   test1 ();
+  test2 ();
+#ifdef __linux__
+  test3 ();
+#endif
+  test4 (argv[0]);
 #endif
 #endif
 
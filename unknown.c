@@ -63,3 +63,17 @@ backtrace_initialize (struct backtrace_state *state ATTRIBUTE_UNUSED,
   *fileline_fn = unknown_fileline;
   return 1;
 }
+
+/* Reading the debug info of arbitrary files is not supported for
+   unknown file formats.  */
+
+int
+backtrace_initialize_modules (struct backtrace_state *state ATTRIBUTE_UNUSED,
+			      const struct backtrace_module *modules ATTRIBUTE_UNUSED,
+			      int count ATTRIBUTE_UNUSED,
+			      backtrace_error_callback error_callback,
+			      void *data)
+{
+  error_callback (data, "offline symbolization not supported", 0);
+  return 0;
+}
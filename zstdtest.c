@@ -194,6 +194,7 @@ test_samples (struct backtrace_state *state)
 
   for (i = 0; i < sizeof tests / sizeof tests[0]; ++i)
     {
+      unsigned char *compressed;
       unsigned char *uncompressed;
       size_t uncompressed_len;
 
@@ -201,18 +202,23 @@ test_samples (struct backtrace_state *state)
       if (uncompressed_len == 0)
 	uncompressed_len = strlen (tests[i].uncompressed);
 
+      /* Copy the input to a buffer of exactly its size, rather than
+	 using the string constant with its trailing NUL, so that
+	 valgrind and ASan can catch a read past the end.  */
+      compressed = (unsigned char *) malloc (tests[i].compressed_len);
       uncompressed = (unsigned char *) malloc (uncompressed_len);
-      if (uncompressed == NULL)
+      if (compressed == NULL || uncompressed == NULL)
 	{
 	  perror ("malloc");
 	  fprintf (stderr, "test %s: uncompress failed\n", tests[i].name);
 	  ++failures;
+	  free (compressed);
+	  free (uncompressed);
 	  continue;
 	}
+      memcpy (compressed, tests[i].compressed, tests[i].compressed_len);
 
-      if (!backtrace_uncompress_zstd (state,
-				      ((const unsigned char *)
-				       tests[i].compressed),
+      if (!backtrace_uncompress_zstd (state, compressed,
 				      tests[i].compressed_len,
 				      error_callback_compress, NULL,
 				      uncompressed, uncompressed_len))
@@ -239,6 +245,7 @@ test_samples (struct backtrace_state *state)
 	    printf ("PASS: uncompress %s\n", tests[i].name);
 	}
 
+      free (compressed);
       free (uncompressed);
     }
 }
@@ -297,6 +304,7 @@ test_large (struct backtrace_state *state ATTRIBUTE_UNUSED)
   size_t orig_bufsize;
   size_t i;
   char *compressed_buf;
+  unsigned char *compressed_copy;
   size_t compressed_bufsize;
   size_t compressed_size;
   unsigned char *uncompressed_buf;
@@ -418,6 +426,39 @@ test_large (struct backtrace_state *state ATTRIBUTE_UNUSED)
 
   printf ("PASS: zstd large\n");
 
+  /* Decompress again from a copy that is exactly the size of the
+     compressed data, so that tools like valgrind and ASan can catch a
+     read past the end of the input.  */
+
+  compressed_copy = malloc (compressed_size);
+  if (compressed_copy == NULL)
+    {
+      perror ("malloc");
+      goto fail;
+    }
+  memcpy (compressed_copy, compressed_buf, compressed_size);
+  memset (uncompressed_buf, 0, orig_bufsize);
+
+  if (!backtrace_uncompress_zstd (state, compressed_copy, compressed_size,
+				  error_callback_compress, NULL,
+				  uncompressed_buf, orig_bufsize))
+    {
+      fprintf (stderr,
+	       "zstd large exact: backtrace_uncompress_zstd failed\n");
+      free (compressed_copy);
+      goto fail;
+    }
+
+  free (compressed_copy);
+
+  if (memcmp (uncompressed_buf, orig_buf, orig_bufsize) != 0)
+    {
+      fprintf (stderr, "zstd large exact: uncompressed data mismatch\n");
+      goto fail;
+    }
+
+  printf ("PASS: zstd large exact\n");
+
   for (i = 0; i < trials; ++i)
     {
       cid = ZSTD_CLOCK_GETTIME_ARG;